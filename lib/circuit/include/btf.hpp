@@ -0,0 +1,140 @@
+/*!
+ *    @file  btf.hpp
+ *   @brief  block triangular form of a sparse pattern
+ *
+ *  A row permutation putting nonzeros on the whole diagonal, then the strongly
+ *  connected components of the graph it leaves, in an order where each one
+ *  only reads unknowns of those before it. Load time only.
+ *
+ *  @author  Thadeu Luiz Barbosa Dias (tlbd)
+ *
+ *  @internal
+ *       Created:  10/18/2026
+ *      Revision:  none
+ *      Compiler:  g++
+ *  Organization:  SMT - Signals, Multimedia and Telecommunications Lab
+ *     Copyright:  Copyright (c) 2019, Thadeu Luiz Barbosa Dias
+ *
+ *  This source code is released for free distribution under the terms of the
+ *  GNU General Public License as published by the Free Software Foundation.
+ */
+
+#ifndef  btf_INC
+#define  btf_INC
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace rtspice::circuit::btf {
+
+  //row matched to each column of the m by m CSR pattern, by depth first
+  //augmenting paths. empty if the pattern is structurally singular
+  inline std::vector<int> transversal(std::size_t m, const int* row, const int* col) {
+
+    std::vector<int> match(m, -1), seen(m, -1);
+
+    //rows on the path, with the next entry each one tries, and the matched
+    //column each one was reached through
+    std::vector<std::pair<int, int>> path;
+    std::vector<int> via;
+
+    for(std::size_t r = 0; r < m; ++r) {
+
+      path.assign(1, {int(r), row[r]});
+      via.assign(1, -1);
+      auto found = false;
+
+      while(!path.empty() && !found) {
+
+        auto& [i, k] = path.back();
+        if(k == row[i+1]) {
+          path.pop_back();
+          via.pop_back();
+          continue;
+        }
+
+        const auto j = col[k++];
+        if(seen[j] == int(r)) continue;
+        seen[j] = r;
+
+        if(match[j] < 0) {
+          //every row on the path takes the column the next one came through
+          match[j] = path.back().first;
+          for(auto t = path.size() - 1; t > 0; --t) match[via[t]] = path[t-1].first;
+          found = true;
+        }
+        else {
+          path.push_back({match[j], row[match[j]]});
+          via.push_back(j);
+        }
+      }
+
+      if(!found) return {};
+    }
+
+    return match;
+  }
+
+  //strongly connected components of the graph where column j points to the
+  //columns of its matched row, by Tarjan's algorithm. each one comes out
+  //after every one it points to, so solving them in order only ever reads
+  //unknowns already solved. returns the component of each column
+  inline std::vector<int> components(std::size_t m, const int* row, const int* col,
+                                     const std::vector<int>& match, int& count) {
+
+    std::vector<int> index(m, -1), low(m, 0), comp(m, -1), stack;
+    std::vector<std::pair<int, int>> calls; //column, next entry of its row
+    int next = 0;
+    count = 0;
+
+    for(std::size_t s = 0; s < m; ++s) {
+
+      if(index[s] >= 0) continue;
+
+      index[s] = low[s] = next++;
+      stack.push_back(s);
+      calls.push_back({int(s), row[match[s]]});
+
+      while(!calls.empty()) {
+
+        auto& [v, k] = calls.back();
+
+        if(k < row[match[v]+1]) {
+          const auto w = col[k++];
+          if(index[w] < 0) {
+            index[w] = low[w] = next++;
+            stack.push_back(w);
+            calls.push_back({w, row[match[w]]});
+          }
+          else if(comp[w] < 0)
+            low[v] = std::min(low[v], index[w]);
+          continue;
+        }
+
+        //v is done: a root pops its component
+        const auto u = v;
+        calls.pop_back();
+        if(!calls.empty()) {
+          const auto p = calls.back().first;
+          low[p] = std::min(low[p], low[u]);
+        }
+
+        if(low[u] == index[u]) {
+          int w;
+          do {
+            w = stack.back();
+            stack.pop_back();
+            comp[w] = count;
+          } while(w != u);
+          ++count;
+        }
+      }
+    }
+
+    return comp;
+  }
+
+}		// -----  end of namespace rtspice::circuit::btf  -----
+
+#endif   // ----- #ifndef btf_INC  -----
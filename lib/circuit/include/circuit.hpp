@@ -20,13 +20,20 @@
 #ifndef  system_INC
 #define  system_INC
 
+#include <algorithm>
 #include <vector>
 #include <map>
+#include <set>
+#include <memory>
 #include <unordered_map>
 
 #include <tuple>
 #include <string>
 #include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
 
 #include <cassert>
 
@@ -36,9 +43,14 @@
 #include <cusolverRf.h>
 
 #include "component.hpp"
+#include "dense.hpp"
+#include "lru_cache.hpp"
 
 namespace rtspice::circuit {
 
+  namespace wdf    { class tree; }
+  namespace passes { struct partition; }
+
   template<class T>
   class entry_reference {
     public:
@@ -84,6 +96,8 @@ namespace rtspice::circuit {
         std::vector<components::component::ptr> static_;
         std::vector<components::component::ptr> dynamic;
         std::vector<components::component::ptr> nonlinear;
+        std::vector<components::component*>     commit;
+        std::vector<components::component*>     update;
       } components_;
 
       struct {
@@ -99,8 +113,13 @@ namespace rtspice::circuit {
       } context_;
 
       struct {
-        std::map<std::string, std::ptrdiff_t> names;
+        std::map<std::string, std::ptrdiff_t> names; //unknown (column) index
+        std::map<std::string, std::ptrdiff_t> rows;  //equation (row) index
         std::map<std::pair<std::string,std::string>, std::ptrdiff_t> pointers;
+        std::vector<std::pair<std::string,std::string>> row_ties, col_ties;
+        std::map<std::string, const float*> derived; //computed, not solved for
+        std::map<std::string, float> constants;      //known voltages
+        std::map<std::string, const float*> fixed;   //nodes at known voltages
       } nodes_;
 
       struct {
@@ -113,6 +132,10 @@ namespace rtspice::circuit {
         std::unordered_map<std::string, entry_reference<const float>> outputs;
 
         std::size_t         m, nnz;       //problem size
+        std::size_t         nfix = 0;     //entries on known voltage columns
+
+        //known voltage entries live past nnz, moved to b before solving
+        std::vector<std::pair<std::ptrdiff_t, const float*>> fixed;
 
         cuda_ptr_<int>      row, col;
         cuda_ptr_<float>    A_nonlinear, A_static, A_dynamic; //the buffers
@@ -131,15 +154,133 @@ namespace rtspice::circuit {
         const float         *ground_x = &zero;
 
         float time = 0.0, delta_time;
+        unsigned stage = 0; //of a split step, 0 when not split
+
 
       } system_;
 
+      //block triangular form: the unknowns are ordered so that A is block
+      //lower triangular, and each diagonal block is solved on its own from
+      //the blocks before it. blocks out of reach of every nonlinear stamp,
+      //directly or through the blocks they read, are settled: solved once per
+      //step, never again while iterating
+      struct block_ {
+        std::size_t begin, end;       //rows and unknowns
+        std::vector<int> row, col;    //pattern of the diagonal block
+        std::vector<float> A, b;      //gathered before each solve
+        std::vector<std::size_t> reads; //blocks it reads, all before it
+        bool settled = false;
+      };
+
+      struct {
+        std::vector<block_> blocks;
+        std::set<std::ptrdiff_t>* touched = nullptr; //rows asked for by nonlinear setups
+      } btf_;
+
+      //fill reducing ordering picked by setup_nodes_, nested dissection is
+      //only tried from this many unknowns on
+      std::string ordering_;
+      static constexpr std::size_t nested_dissection = 200;
+
+      void setup_blocks_(const std::vector<std::size_t>& sizes); //after the permutation
+      void settle_blocks_(const std::set<std::ptrdiff_t>& nonlinear_rows);
+
+      //piecewise linear mode: every nonlinear component is piecewise, so each
+      //combination of segments is a linear system, factored once and cached
+      struct {
+        using key = std::vector<std::uint8_t>;
+
+        bool enabled = false;
+        key  region, next;
+        lru_cache<key, dense::lu_factors<double>> factors;
+        std::vector<float>  A_linear; //A_dynamic the factors were built on
+        std::vector<double> scratch;
+      } pwl_;
+
+      //wave digital mode: a series-parallel netlist runs on its adaptor tree,
+      //node voltages are copied to the unknowns they belong to
+      std::unique_ptr<wdf::tree> wdf_;
+      std::vector<std::pair<std::size_t, std::ptrdiff_t>> wdf_x_; //potential, unknown
+
+      void setup_wdf_(const std::vector<components::component::ptr>&);
+
+      //steps per host sample, asked for by the OVERSAMPLE option
+      unsigned oversampling_ = 1;
+      bool     adaptive_     = false; //ADAPTIVE, only at 1x while quiet
+
+      //subcircuits holding a .SLOW card, each its own circuit stepped once
+      //every ratio steps, over ratio times the step. see split_partitions
+      struct slow_partition_ {
+
+        struct port {
+          std::shared_ptr<float> v, i;           //what each side is fed
+          entry_reference<const float> j, x;     //source current, slow voltage
+          float v0 = 0.0f, v1 = 0.0f;            //last two slow voltages
+          float q  = 0.0f;                       //charge drawn since then
+        };
+
+        std::unique_ptr<circuit> c;
+        unsigned ratio;
+        bool     hold;
+        unsigned phase = 0;
+        std::vector<port> ports;
+      };
+
+      std::vector<slow_partition_> slow_;
+
+      void setup_slow_(passes::partition&, bool simplify);
+      int  slow_step_(slow_partition_& s, float delta_t);
+
+      //subcircuits holding a .PARTITION card, each its own circuit stepped
+      //on a worker thread while this one steps. before every step, each side
+      //hands the other what it read at the ports after the last one, so both
+      //see them one step late. the handoff is a pair of sequence numbers, the
+      //worker only sleeps once the host has stopped calling advance_
+      struct thread_partition_ {
+
+        struct port {
+          entry_reference<const float> here, there; //read on each side
+          float sign_here, sign_there;              //-1 on source currents
+          std::shared_ptr<float> into_here, into_there;
+        };
+
+        std::unique_ptr<circuit> c;
+        std::vector<port> ports;
+
+        std::vector<float> to_worker, to_host; //port values, one step late
+        float delta_t = 0.0f;
+        int   result  = 0;
+
+        std::uint64_t sent = 0;               //steps handed over
+        std::atomic<std::uint64_t> posted{0}; //published sent
+        std::atomic<std::uint64_t> done{0};   //steps the worker finished
+        std::atomic<bool> stop{false}, sleeping{false};
+        std::mutex m;
+        std::condition_variable wake;
+        std::thread worker;
+      };
+
+      std::vector<std::unique_ptr<thread_partition_>> threads_;
+
+      void setup_thread_(passes::partition&, bool simplify);
+      int  hand_over_(thread_partition_& t, float delta_t) noexcept;
+      static void settle_(thread_partition_& t) noexcept;
+      static void work_(thread_partition_& t);
+
       void setup_context_();
       void teardown_context_();
 
       void setup_components_(const std::vector<components::component::ptr>&);
 
-      void register_nodes_();
+      //netlist reduction passes, see passes.hpp
+      void simplify_(std::vector<components::component::ptr>&);
+      std::pair<std::size_t, std::size_t>
+        measure_(const std::vector<components::component::ptr>&);
+
+      std::vector<std::string> log_;
+
+      void register_nodes_(const std::vector<components::component::ptr>&);
+      void index_nodes_();
       void setup_nodes_();
 
       void setup_system_();
@@ -148,24 +289,59 @@ namespace rtspice::circuit {
       void init_components_();
 
       void setup_static_();
+      void fill_static_();
+
+      int solve_(bool all = true); //only the unsettled blocks unless all
+
+      int  step_(float delta_t);   //one solve, from the current state
+      int  stages_(float delta_t); //two of them, for TR-BDF2
+      bool staged_ = false;        //steps run in two stages, for TR-BDF2
 
-      int solve_();
+      void fold_fixed_();  //move known voltage columns to the right hand side
+      int  pwl_step_();    //region search in piecewise linear mode
 
 
     public:
 
-      circuit(std::vector<components::component::ptr> components);
+      //simplify runs the netlist passes, only probed names are kept readable
+      circuit(std::vector<components::component::ptr> components,
+              bool simplify = false);
       ~circuit();
 
       int nr_step_();    //iterate basic step until convergence
       int advance_(float delta_t);  //nr_step_ then advance time
 
+      //precomputes what advance_(delta_t) calls will need, i.e. the exact
+      //discretizations of the EXPM option. never while advancing
+      void prepare(float delta_t);
+
       //add node name to pool
       void register_node(const std::string& node_name);
 
+      //fold an ideal nullor into the node numbering: the norator nodes share
+      //a single equation and the nullator nodes share a single unknown
+      void register_nullor(const std::pair<std::string,std::string>& norator,
+                           const std::pair<std::string,std::string>& nullator);
+
+      //hold node at a known voltage against ground, folding it out of the system
+      void register_constant(const std::string& node_name, float value);
+
       //add matrix entry to pool
       void register_entry(const std::pair<std::string,std::string>& entry);
 
+      //add variable reconstructed by a component to pool, i.e. branch currents
+      void register_derived(const std::string& name);
+
+      //feed address of derived variable, false if nobody asked for it
+      bool bind_derived(const std::string& name, const float* value);
+
+      //request component::commit calls after every time step
+      void register_commit(components::component* c);
+
+      //request component::update calls before every time step, the static
+      //stamp is rebuilt whenever one of them reports a change
+      void register_update(components::component* c);
+
       //recover address of matrix entry
       entry_reference<float> get_A(const std::pair<std::string,std::string>& entry);
 
@@ -195,6 +371,58 @@ namespace rtspice::circuit {
       const float* get_time() const;
       const float* get_delta_time() const;
 
+      //1 and 2 during the two stages of a split step, 0 otherwise
+      const unsigned* get_stage() const;
+
+      //from now on, split every step in gamma and 1 - gamma of it
+      void split_steps() { staged_ = true; }
+      static constexpr float gamma = 0.5857864376f; //2 - sqrt(2)
+
+      auto size() const { return system_.m; }
+      auto nnz()  const { return system_.nnz; }
+
+      auto& log() const { return log_; }
+
+      //per region factorizations of the piecewise linear mode
+      bool piecewise() const { return pwl_.enabled; }
+      auto& regions() { return pwl_.factors; }
+
+      //true when running as a wave digital filter
+      bool wave_digital() const { return wdf_ != nullptr; }
+
+      //1, 2, 4 or 8 advance_ calls per host sample, around resamplers
+      unsigned oversampling() const { return oversampling_; }
+
+      //true if the oversampling factor is only used while the circuit is busy
+      bool adaptive() const { return adaptive_; }
+
+      //number of slow partitions split off the netlist
+      auto slow_partitions() const { return slow_.size(); }
+
+      //fill reducing ordering the factorizations run in, i.e. "AMD"
+      auto& ordering() const { return ordering_; }
+
+      //diagonal blocks of the block triangular form, and how many of them
+      //are solved once per step
+      auto blocks()         const { return btf_.blocks.size(); }
+      std::size_t settled_blocks() const {
+        return std::count_if(btf_.blocks.begin(), btf_.blocks.end(),
+                             [](auto&& b) { return b.settled; });
+      }
+
+      //number of partitions running on worker threads
+      auto threaded_partitions() const { return threads_.size(); }
+
+      //of those, the ones whose worker went to sleep waiting for a step
+      std::size_t sleeping_partitions() const {
+        return std::count_if(threads_.begin(), threads_.end(),
+                             [](auto&& t) { return t->sleeping.load(); });
+      }
+
+      //handles of every worker, nested ones too, for a real time host to
+      //raise to its own priority, the host thread waits on them each step
+      std::vector<std::thread::native_handle_type> worker_threads();
+
       auto& nodes() const { return nodes_.names; }
       auto& entries() const { return nodes_.pointers; }
 
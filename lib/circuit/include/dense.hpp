@@ -0,0 +1,252 @@
+/*!
+ *    @file  dense.hpp
+ *   @brief small dense linear algebra helpers for the netlist passes
+ *
+ *  Only meant for small blocks, at load time or while preparing for a time
+ *  step off the real-time thread; the simulation loop never touches these.
+ *
+ *  @author  Thadeu Luiz Barbosa Dias (tlbd)
+ *
+ *  @internal
+ *       Created:  10/18/2026
+ *      Revision:  none
+ *      Compiler:  g++
+ *  Organization:  SMT - Signals, Multimedia and Telecommunications Lab
+ *     Copyright:  Copyright (c) 2019, Thadeu Luiz Barbosa Dias
+ *
+ *  This source code is released for free distribution under the terms of the
+ *  GNU General Public License as published by the Free Software Foundation.
+ */
+
+#ifndef  dense_INC
+#define  dense_INC
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace rtspice::circuit::dense {
+
+  /*!
+   *  @brief  row major dense matrix
+   */
+  template<class T>
+  struct basic_matrix {
+
+    basic_matrix(std::size_t rows = 0, std::size_t cols = 0) :
+      rows{ rows },
+      cols{ cols },
+      data(rows*cols, T{}) {}
+
+    auto& operator()(std::size_t i, std::size_t j)       { return data[i*cols + j]; }
+    auto  operator()(std::size_t i, std::size_t j) const { return data[i*cols + j]; }
+
+    std::size_t rows, cols;
+    std::vector<T> data;
+  };
+
+  using matrix         = basic_matrix<double>;
+  using complex_matrix = basic_matrix<std::complex<double>>;
+
+  template<class T>
+  basic_matrix<T> operator*(const basic_matrix<T>& A, const basic_matrix<T>& B) {
+    basic_matrix<T> C{A.rows, B.cols};
+    for(std::size_t i = 0; i < A.rows; ++i)
+      for(std::size_t k = 0; k < A.cols; ++k)
+        for(std::size_t j = 0; j < B.cols; ++j)
+          C(i, j) += A(i, k) * B(k, j);
+    return C;
+  }
+
+  template<class T>
+  basic_matrix<T> operator-(basic_matrix<T> A, const basic_matrix<T>& B) {
+    for(std::size_t k = 0; k < A.data.size(); ++k) A.data[k] -= B.data[k];
+    return A;
+  }
+
+  template<class T>
+  basic_matrix<T> transpose(const basic_matrix<T>& A) {
+    basic_matrix<T> At{A.cols, A.rows};
+    for(std::size_t i = 0; i < A.rows; ++i)
+      for(std::size_t j = 0; j < A.cols; ++j)
+        At(j, i) = A(i, j);
+    return At;
+  }
+
+  //solves A X = B in place of B, by Gaussian elimination with partial
+  //pivoting, false if A is numerically singular
+  template<class T>
+  bool solve(basic_matrix<T> A, basic_matrix<T>& B) {
+
+    const auto n = A.rows;
+
+    for(std::size_t k = 0; k < n; ++k) {
+
+      auto p = k;
+      for(auto i = k+1; i < n; ++i)
+        if(std::abs(A(i, k)) > std::abs(A(p, k))) p = i;
+
+      if(std::abs(A(p, k)) < 1e-300) return false;
+
+      for(std::size_t j = 0; j < n;      ++j) std::swap(A(k, j), A(p, j));
+      for(std::size_t j = 0; j < B.cols; ++j) std::swap(B(k, j), B(p, j));
+
+      for(auto i = k+1; i < n; ++i) {
+        const auto l = A(i, k) / A(k, k);
+        for(auto j = k; j < n; ++j)               A(i, j) -= l*A(k, j);
+        for(std::size_t j = 0; j < B.cols; ++j) B(i, j) -= l*B(k, j);
+      }
+    }
+
+    for(auto k = n; k-- > 0;)
+      for(std::size_t j = 0; j < B.cols; ++j) {
+        auto s = B(k, j);
+        for(auto i = k+1; i < n; ++i) s -= A(k, i)*B(i, j);
+        B(k, j) = s / A(k, k);
+      }
+
+    return true;
+  }
+
+  //row pivoted LU factors, L unit lower and U sharing one matrix
+  template<class T>
+  struct lu_factors {
+    basic_matrix<T> LU;
+    std::vector<std::size_t> p; //row k of LU is row p[k] of A
+  };
+
+  //factors A = P L U, false if A is numerically singular
+  template<class T>
+  bool factor(basic_matrix<T> A, lu_factors<T>& f) {
+
+    const auto n = A.rows;
+
+    f.p.resize(n);
+    for(std::size_t k = 0; k < n; ++k) f.p[k] = k;
+
+    for(std::size_t k = 0; k < n; ++k) {
+
+      auto p = k;
+      for(auto i = k+1; i < n; ++i)
+        if(std::abs(A(i, k)) > std::abs(A(p, k))) p = i;
+
+      if(std::abs(A(p, k)) < 1e-300) return false;
+
+      for(std::size_t j = 0; j < n; ++j) std::swap(A(k, j), A(p, j));
+      std::swap(f.p[k], f.p[p]);
+
+      for(auto i = k+1; i < n; ++i) {
+        const auto l = A(i, k) /= A(k, k);
+        for(auto j = k+1; j < n; ++j) A(i, j) -= l*A(k, j);
+      }
+    }
+
+    f.LU = std::move(A);
+    return true;
+  }
+
+  //forward and back substitution on factors of A, x = A^-1 b, with y as
+  //scratch so repeated solves do not allocate
+  template<class T, class U>
+  void solve(const lu_factors<T>& f, const U* b, U* x, std::vector<T>& y) {
+
+    const auto n = f.LU.rows;
+    y.resize(n);
+
+    for(std::size_t i = 0; i < n; ++i) {
+      T s = b[f.p[i]];
+      for(std::size_t j = 0; j < i; ++j) s -= f.LU(i, j)*y[j];
+      y[i] = s;
+    }
+
+    for(auto i = n; i-- > 0;) {
+      auto s = y[i];
+      for(auto j = i+1; j < n; ++j) s -= f.LU(i, j)*y[j];
+      y[i] = s / f.LU(i, i);
+      x[i] = static_cast<U>(y[i]);
+    }
+  }
+
+  //e^A, by scaling and squaring: A is halved until its 1-norm is under 1/2,
+  //where 18 terms of the Taylor series are well past double precision
+  inline matrix expm(const matrix& A) {
+
+    const auto n = A.rows;
+
+    auto norm = 0.0;
+    for(std::size_t j = 0; j < n; ++j) {
+      auto s = 0.0;
+      for(std::size_t i = 0; i < n; ++i) s += std::abs(A(i, j));
+      norm = std::max(norm, s);
+    }
+
+    int squarings = 0;
+    if(norm > 0.5) squarings = static_cast<int>(std::ceil(std::log2(norm / 0.5)));
+
+    auto X = A;
+    for(auto& x: X.data) x = std::ldexp(x, -squarings);
+
+    matrix E{n, n}, T{n, n};
+    for(std::size_t i = 0; i < n; ++i) E(i, i) = T(i, i) = 1.0;
+
+    for(int k = 1; k <= 18; ++k) {
+      T = T * X;
+      for(std::size_t i = 0; i < n*n; ++i) {
+        T.data[i] /= k;
+        E.data[i] += T.data[i];
+      }
+    }
+
+    for(int k = 0; k < squarings; ++k) E = E * E;
+
+    return E;
+  }
+
+  //appends the columns of X to the orthonormal columns of Q, by modified
+  //Gram-Schmidt with one reorthogonalization, dropping deflated columns.
+  //returns the number of columns added
+  inline std::size_t orthonormalize(matrix& Q, const matrix& X, double tol = 1e-10) {
+
+    const auto n = X.rows;
+    std::size_t added = 0;
+
+    for(std::size_t c = 0; c < X.cols; ++c) {
+
+      std::vector<double> v(n);
+      for(std::size_t i = 0; i < n; ++i) v[i] = X(i, c);
+
+      auto norm0 = 0.0;
+      for(auto x: v) norm0 += x*x;
+      norm0 = std::sqrt(norm0);
+      if(norm0 == 0.0) continue;
+
+      for(int pass = 0; pass < 2; ++pass)
+        for(std::size_t j = 0; j < Q.cols; ++j) {
+          auto d = 0.0;
+          for(std::size_t i = 0; i < n; ++i) d += Q(i, j)*v[i];
+          for(std::size_t i = 0; i < n; ++i) v[i] -= d*Q(i, j);
+        }
+
+      auto norm = 0.0;
+      for(auto x: v) norm += x*x;
+      norm = std::sqrt(norm);
+      if(norm <= tol*norm0) continue;
+
+      matrix R{n, Q.cols + 1};
+      for(std::size_t i = 0; i < n; ++i) {
+        for(std::size_t j = 0; j < Q.cols; ++j) R(i, j) = Q(i, j);
+        R(i, Q.cols) = v[i] / norm;
+      }
+      Q = std::move(R);
+      ++added;
+    }
+
+    return added;
+  }
+
+}		// -----  end of namespace rtspice::circuit::dense  -----
+
+#endif   // ----- #ifndef dense_INC  -----
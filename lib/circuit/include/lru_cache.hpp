@@ -0,0 +1,86 @@
+/*!
+ *    @file  lru_cache.hpp
+ *   @brief  bounded least recently used cache
+ *
+ *  @author  Thadeu Luiz Barbosa Dias (tlbd)
+ *
+ *  @internal
+ *       Created:  10/18/2026
+ *      Revision:  none
+ *      Compiler:  g++
+ *  Organization:  SMT - Signals, Multimedia and Telecommunications Lab
+ *     Copyright:  Copyright (c) 2019, Thadeu Luiz Barbosa Dias
+ *
+ *  This source code is released for free distribution under the terms of the
+ *  GNU General Public License as published by the Free Software Foundation.
+ */
+
+#ifndef  lru_cache_INC
+#define  lru_cache_INC
+
+#include <cstddef>
+#include <list>
+#include <map>
+#include <utility>
+
+namespace rtspice::circuit {
+
+  /*!
+   *  @brief  at most capacity values, the least recently found one is evicted
+   *  first
+   */
+  template<class Key, class Value>
+  class lru_cache {
+    public:
+      lru_cache(std::size_t capacity = 64) :
+        capacity_{ capacity } {}
+
+      //nullptr on a miss, a hit becomes the most recent entry
+      Value* find(const Key& k) {
+        const auto it = index_.find(k);
+        if(it == index_.end()) return nullptr;
+        items_.splice(items_.begin(), items_, it->second);
+        return &it->second->second;
+      }
+
+      Value& insert(const Key& k, Value v) {
+
+        if(const auto hit = find(k)) return *hit = std::move(v);
+
+        if(items_.size() >= capacity_ && !items_.empty()) {
+          index_.erase(items_.back().first);
+          items_.pop_back();
+        }
+
+        items_.emplace_front(k, std::move(v));
+        index_.emplace(k, items_.begin());
+        return items_.front().second;
+      }
+
+      void clear() {
+        items_.clear();
+        index_.clear();
+      }
+
+      void resize(std::size_t capacity) {
+        capacity_ = capacity;
+        while(items_.size() > capacity_) {
+          index_.erase(items_.back().first);
+          items_.pop_back();
+        }
+      }
+
+      auto size()     const noexcept { return items_.size(); }
+      auto capacity() const noexcept { return capacity_; }
+
+    private:
+      using list_ = std::list<std::pair<Key, Value>>;
+
+      std::size_t capacity_;
+      list_ items_; //most recent first
+      std::map<Key, typename list_::iterator> index_;
+  };
+
+}		// -----  end of namespace rtspice::circuit  -----
+
+#endif   // ----- #ifndef lru_cache_INC  -----
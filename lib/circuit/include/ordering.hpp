@@ -0,0 +1,133 @@
+/*!
+ *    @file  ordering.hpp
+ *   @brief  patterns fed to the fill reducing orderings, and what they cost
+ *
+ *  The symmetric orderings of cuSolver expect the pattern of A + A^T, column
+ *  orderings work on the pattern of A^T A. Candidates are compared by a
+ *  symbolic LU without pivoting, only at load time.
+ *
+ *  @author  Thadeu Luiz Barbosa Dias (tlbd)
+ *
+ *  @internal
+ *       Created:  10/18/2026
+ *      Revision:  none
+ *      Compiler:  g++
+ *  Organization:  SMT - Signals, Multimedia and Telecommunications Lab
+ *     Copyright:  Copyright (c) 2019, Thadeu Luiz Barbosa Dias
+ *
+ *  This source code is released for free distribution under the terms of the
+ *  GNU General Public License as published by the Free Software Foundation.
+ */
+
+#ifndef  ordering_INC
+#define  ordering_INC
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <queue>
+#include <set>
+#include <vector>
+
+namespace rtspice::circuit::ordering {
+
+  //compressed sparse rows, sorted within each row
+  struct pattern {
+    std::vector<int> row, col;
+  };
+
+  inline pattern compress(const std::vector<std::set<int>>& rows) {
+    pattern p;
+    p.row.push_back(0);
+    for(auto&& r: rows) {
+      p.col.insert(p.col.end(), r.begin(), r.end());
+      p.row.push_back(p.col.size());
+    }
+    return p;
+  }
+
+  //A + A^T, with the whole diagonal
+  inline pattern symmetric(std::size_t m, const int* row, const int* col) {
+    std::vector<std::set<int>> rows(m);
+    for(std::size_t i = 0; i < m; ++i) {
+      rows[i].insert(i);
+      for(auto k = row[i]; k < row[i+1]; ++k) {
+        rows[i].insert(col[k]);
+        rows[col[k]].insert(i);
+      }
+    }
+    return compress(rows);
+  }
+
+  //A^T A: columns sharing a row
+  inline pattern gram(std::size_t m, const int* row, const int* col) {
+    std::vector<std::set<int>> rows(m);
+    for(std::size_t i = 0; i < m; ++i)
+      for(auto a = row[i]; a < row[i+1]; ++a)
+        rows[col[a]].insert(col + row[i], col + row[i+1]);
+    return compress(rows);
+  }
+
+  struct cost {
+    std::size_t fill  = 0; //entries L + U adds to A
+    double      flops = 0; //divisions and multiply-adds of one factorization
+  };
+
+  inline bool operator<(const cost& a, const cost& b) {
+    return a.flops < b.flops || (a.flops == b.flops && a.fill < b.fill);
+  }
+
+  inline cost& operator+=(cost& a, const cost& b) {
+    a.fill  += b.fill;
+    a.flops += b.flops;
+    return a;
+  }
+
+  //symbolic LU of an n by n pattern without pivoting, row by row: row i
+  //takes in the upper part of every row k < i it ends up holding
+  inline cost predict(std::size_t n, const std::vector<int>& row,
+                      const std::vector<int>& col) {
+
+    cost c;
+    std::vector<std::vector<int>> upper(n);
+    std::vector<char> mark(n, 0);
+    std::vector<int> s;
+    std::size_t total = 0;
+
+    for(std::size_t i = 0; i < n; ++i) {
+
+      std::priority_queue<int, std::vector<int>, std::greater<int>> lower;
+
+      s.assign(col.begin() + row[i], col.begin() + row[i+1]);
+      if(std::find(s.begin(), s.end(), int(i)) == s.end()) s.push_back(i);
+      for(auto j: s) {
+        mark[j] = 1;
+        if(j < int(i)) lower.push(j);
+      }
+
+      while(!lower.empty()) {
+        const auto k = lower.top();
+        lower.pop();
+        c.flops += 1 + upper[k].size();
+        for(auto j: upper[k])
+          if(!mark[j]) {
+            mark[j] = 1;
+            s.push_back(j);
+            if(j < int(i)) lower.push(j);
+          }
+      }
+
+      total += s.size();
+      for(auto j: s) {
+        mark[j] = 0;
+        if(j > int(i)) upper[i].push_back(j);
+      }
+    }
+
+    c.fill = total - col.size();
+    return c;
+  }
+
+}		// -----  end of namespace rtspice::circuit::ordering  -----
+
+#endif   // ----- #ifndef ordering_INC  -----
@@ -0,0 +1,240 @@
+/*!
+ *    @file  oversampler.hpp
+ *   @brief  runs a circuit between resamplers, at a fixed or adaptive rate
+ *
+ *  Every input goes up through an interpolator, every output down through a
+ *  decimator, both over whole blocks, and the circuit steps factor times per
+ *  frame in between.
+ *
+ *  In adaptive mode quiet blocks step only once per frame. Their inputs are
+ *  read from the interpolated stream, at the last phase of each frame, and
+ *  their outputs are linearly interpolated back into it, so both filters keep
+ *  running and the latency never changes. The rate of a block is picked from
+ *  the one before: the high frequency energy the circuit adds to its inputs,
+ *  measured on the host rate buffers, is what aliases once harmonics reach the
+ *  Nyquist frequency. Blocks where the rate changes run at the full rate and
+ *  crossfade between the two streams.
+ *
+ *  @author  Thadeu Luiz Barbosa Dias (tlbd)
+ *
+ *  @internal
+ *       Created:  10/18/2026
+ *      Revision:  none
+ *      Compiler:  g++
+ *  Organization:  SMT - Signals, Multimedia and Telecommunications Lab
+ *     Copyright:  Copyright (c) 2019, Thadeu Luiz Barbosa Dias
+ *
+ *  This source code is released for free distribution under the terms of the
+ *  GNU General Public License as published by the Free Software Foundation.
+ */
+
+#ifndef  oversampler_INC
+#define  oversampler_INC
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "circuit.hpp"
+#include "resampler.hpp"
+
+namespace rtspice::circuit {
+
+  /*!
+   *  @brief  block processing of a circuit with its own inputs and outputs
+   */
+  class oversampler {
+    public:
+      //activity, the share of the energy up high added by the circuit, that
+      //calls for the full rate, and the one it has to stay under for hold
+      //blocks to get back to 1x
+      static constexpr float    rise = 1e-4f;
+      static constexpr float    fall = 2.5e-5f;
+      static constexpr unsigned hold = 8;
+
+      oversampler(circuit& c,
+                  std::vector<float*> inputs,
+                  std::vector<entry_reference<const float>> outputs,
+                  unsigned factor = 1,
+                  bool adaptive = false) :
+        circuit_{ c },
+        inputs_{ std::move(inputs) }, outputs_{ std::move(outputs) },
+        L_{ std::max(factor, 1u) },
+        adaptive_{ adaptive && L_ > 1 },
+        high_{ !adaptive_ },
+        up_(inputs_.size(), interpolator{ L_ }),
+        down_(outputs_.size(), decimator{ L_ }),
+        hi_in_(inputs_.size()), hi_out_(outputs_.size()),
+        held_(outputs_.size(), 0.0f),
+        in_hist_(inputs_.size(), { 0.0f, 0.0f }),
+        out_hist_(outputs_.size(), { 0.0f, 0.0f }) {
+
+        //a filter each way
+        if(L_ > 1)
+          latency_ = std::lround(interpolator{ L_ }.delay() + decimator{ L_ }.delay());
+      }
+
+      //sized for blocks of up to frames, never called while processing
+      void resize(std::size_t frames) {
+        const auto n = L_ > 1 ? frames*L_ : 0;
+        for(auto&& h: hi_in_)  h.assign(n, 0.0f);
+        for(auto&& h: hi_out_) h.assign(n, 0.0f);
+      }
+
+      //for host samples of delta_t, at either rate, never called while
+      //processing
+      void prepare(float delta_t) {
+        circuit_.prepare(delta_t);
+        if(L_ > 1) circuit_.prepare(delta_t/L_);
+      }
+
+      //n frames from in, one buffer per input, to out, one per output
+      void process(const float* const* in, float* const* out,
+                   std::size_t n, float delta_t) noexcept {
+
+        const auto ni = inputs_.size(), no = outputs_.size();
+
+        if(L_ == 1) {
+          for(std::size_t s = 0; s < n; ++s) {
+            for(std::size_t p = 0; p < ni; ++p) *inputs_[p] = in[p][s];
+            circuit_.advance_(delta_t);
+            for(std::size_t p = 0; p < no; ++p) out[p][s] = *outputs_[p];
+          }
+          return;
+        }
+
+        for(std::size_t p = 0; p < ni; ++p) up_[p].process(in[p], n, hi_in_[p].data());
+
+        //this block's rate, from the last block
+        const auto was = high_;
+        if(adaptive_) {
+          if(activity_ > rise) {
+            high_  = true;
+            quiet_ = 0;
+          }
+          else if(activity_ >= fall)
+            quiet_ = 0;
+          else if(high_ && ++quiet_ >= hold)
+            high_ = false;
+        }
+
+        const auto N = n*L_;
+
+        if(high_ || was) {
+          const auto dt = delta_t/L_;
+          for(std::size_t q = 0; q < N; ++q) {
+            for(std::size_t p = 0; p < ni; ++p) *inputs_[p] = hi_in_[p][q];
+            circuit_.advance_(dt);
+            for(std::size_t p = 0; p < no; ++p) hi_out_[p][q] = *outputs_[p];
+          }
+          if(high_ != was) crossfade_(n, high_);
+          rate_ = L_;
+        }
+        else {
+          for(std::size_t s = 0; s < n; ++s) {
+            const auto q = s*L_ + L_ - 1;
+            for(std::size_t p = 0; p < ni; ++p) *inputs_[p] = hi_in_[p][q];
+            circuit_.advance_(delta_t);
+            for(std::size_t p = 0; p < no; ++p) hold_(p, s, *outputs_[p]);
+          }
+          rate_ = 1;
+        }
+
+        for(std::size_t p = 0; p < no; ++p) {
+          held_[p] = hi_out_[p][N - 1];
+          down_[p].process(hi_out_[p].data(), n, out[p]);
+        }
+
+        if(adaptive_) activity_ = measure_(in, out, n);
+      }
+
+      unsigned factor()  const noexcept { return L_; }
+      bool     adaptive() const noexcept { return adaptive_; }
+
+      //steps per frame in the last block
+      unsigned rate() const noexcept { return rate_; }
+
+      //frames, through both filters
+      long latency() const noexcept { return latency_; }
+
+      //of the last block, against rise and fall
+      float activity() const noexcept { return activity_; }
+
+    private:
+      //frame s of output p from a single step, linear from the frame before
+      void hold_(std::size_t p, std::size_t s, float y) noexcept {
+        auto& h = hi_out_[p];
+        const auto y0 = s > 0 ? h[s*L_ - 1] : held_[p];
+        for(unsigned k = 0; k < L_; ++k)
+          h[s*L_ + k] = y0 + (k + 1)*(y - y0)/L_;
+      }
+
+      //blend a full rate block with what 1x would have made of it, towards
+      //the full rate when rising
+      void crossfade_(std::size_t n, bool rising) noexcept {
+        const auto N = n*L_;
+        for(std::size_t p = 0; p < hi_out_.size(); ++p) {
+          auto& h = hi_out_[p];
+          auto y0 = held_[p];
+          for(std::size_t s = 0; s < n; ++s) {
+            const auto y = h[s*L_ + L_ - 1];
+            for(unsigned k = 0; k < L_; ++k) {
+              const auto q = s*L_ + k;
+              const auto w = float(q + 1)/N;
+              const auto l = y0 + (k + 1)*(y - y0)/L_;
+              h[q] = l + (rising ? w : 1.0f - w)*(h[q] - l);
+            }
+            y0 = y;
+          }
+        }
+      }
+
+      //energy share of a second difference, 1 at the Nyquist frequency,
+      //outputs minus inputs
+      float measure_(const float* const* in, const float* const* out,
+                     std::size_t n) noexcept {
+
+        const auto share = [n](const float* const* x,
+                               std::vector<std::array<float, 2>>& hist) {
+          double hf = 0.0, e = 0.0;
+          for(std::size_t p = 0; p < hist.size(); ++p) {
+            auto& [y1, y2] = hist[p];
+            for(std::size_t s = 0; s < n; ++s) {
+              const double y = x[p][s];
+              const auto   d = y - 2.0*y1 + y2;
+              hf += d*d;
+              e  += y*y;
+              y2 = y1;
+              y1 = x[p][s];
+            }
+          }
+          return e > 0.0 ? hf/(16.0*e) : 0.0;
+        };
+
+        return std::max(0.0, share(out, out_hist_) - share(in, in_hist_));
+      }
+
+      circuit& circuit_;
+      std::vector<float*> inputs_;
+      std::vector<entry_reference<const float>> outputs_;
+
+      unsigned L_;
+      bool     adaptive_;
+      bool     high_;
+      unsigned rate_    = 1;
+      unsigned quiet_   = 0;
+      float    activity_ = 0.0f;
+      long     latency_ = 0;
+
+      std::vector<interpolator> up_;
+      std::vector<decimator>    down_;
+      std::vector<std::vector<float>> hi_in_, hi_out_;
+      std::vector<float> held_; //last sample of each output stream
+      std::vector<std::array<float, 2>> in_hist_, out_hist_;
+  };
+
+}		// -----  end of namespace rtspice::circuit  -----
+
+#endif   // ----- #ifndef oversampler_INC  -----
@@ -0,0 +1,131 @@
+/*!
+ *    @file  passes.hpp
+ *   @brief netlist simplification passes, run before MNA assembly
+ *
+ *  Every pass rewrites the component list in place, returning the number of
+ *  components it removed or replaced. Nodes read by probes are pinned and
+ *  never removed, so the reduced circuit produces the same probe outputs.
+ *
+ *  @author  Thadeu Luiz Barbosa Dias (tlbd)
+ *
+ *  @internal
+ *       Created:  10/18/2026
+ *      Revision:  none
+ *      Compiler:  g++
+ *  Organization:  SMT - Signals, Multimedia and Telecommunications Lab
+ *     Copyright:  Copyright (c) 2019, Thadeu Luiz Barbosa Dias
+ *
+ *  This source code is released for free distribution under the terms of the
+ *  GNU General Public License as published by the Free Software Foundation.
+ */
+
+#ifndef  passes_INC
+#define  passes_INC
+
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "component.hpp"
+
+namespace rtspice::circuit::passes {
+
+  using component_list = std::vector<components::component::ptr>;
+  using node_set       = std::set<std::string>;
+
+  //value of a .OPTIONS entry, last one wins
+  float option(const component_list& comps, const std::string& key, float fallback);
+
+  //moves capacitors and inductors whose line named no method to the
+  //integration method of the METHOD option; circuit always runs this one
+  std::size_t apply_method(component_list& comps, const node_set& pinned);
+
+  //subcircuit instance holding a .SLOW or .PARTITION card, split off the
+  //netlist. each node it shares with the rest is a port, driven by one side:
+  //the driving side reads its voltage into v, the other sees it as a voltage
+  //source of that value and hands back the current it draws through i, to a
+  //current source on the driving side
+  struct partition {
+
+    struct port {
+      std::string node, branch; //branch, the current of the voltage source
+      std::shared_ptr<float> v, i;
+      bool outward;             //driven by the partition
+    };
+
+    std::string    instance; //i.e. "X1."
+    component_list components;
+    unsigned       ratio;
+    bool           hold;
+    bool           threaded;
+    std::vector<port> ports;
+  };
+
+  //moves every instance holding a .SLOW or .PARTITION card out of comps,
+  //leaving its port sources behind. host inputs and knobs stay, as do
+  //instances that would drive a node another one split before drives. slow
+  //instances drive all their ports, threaded ones those where they hold an
+  //ideal opamp output or the rest only probes. circuit runs this one first
+  std::vector<partition> split_partitions(component_list& comps);
+
+  //names read by probes, which must survive every pass
+  node_set pinned(const component_list& comps);
+
+  //removes components not connected to ground, and passives left dangling
+  std::size_t drop_floating(component_list& comps, const node_set& pinned);
+
+  //turns DC voltage sources to ground into known node voltages
+  std::size_t fold_grounded_sources(component_list& comps, const node_set& pinned);
+
+  //merges linear resistors in series and in parallel, up to a fixpoint
+  std::size_t merge_resistors(component_list& comps, const node_set& pinned);
+
+  //sums linear VCCS and DC current sources sharing the same terminals
+  std::size_t combine_static(component_list& comps, const node_set& pinned);
+
+  //eliminates nodes touched only by linear resistors and transconductances,
+  //replacing each cluster by the Schur complement on its boundary nodes
+  std::size_t kron_reduce(component_list& comps, const node_set& pinned);
+
+  //projects linear RLC clusters onto a port preserving Krylov subspace
+  //(PRIMA), with the order set by the PRIMA_ORDER option or grown until the
+  //audio band port impedances match the full model within PRIMA_TOL
+  std::size_t prima_reduce(component_list& comps, const node_set& pinned);
+
+  //with the EXPM option, replaces linear clusters holding capacitors or
+  //inductors by blocks discretized by their matrix exponential, exact for
+  //inputs linear over each step. a change of discretization rather than an
+  //optimization, so circuit runs this one even when not simplifying
+  std::size_t expm_discretize(component_list& comps, const node_set& pinned);
+
+  //merges every FET into a single batch, evaluated in one vectorized pass
+  std::size_t batch_fets(component_list& comps, const node_set& pinned);
+
+  //replaces each group of inductors tied by K cards with a single coupled
+  //inductors block, integrated by the trapezoidal rule whatever their
+  //method. K cards are not an optimization, so circuit runs this one even
+  //when not simplifying. clamped coefficients and groups left uncoupled,
+  //their L singular, are noted in log
+  std::size_t couple_inductors(component_list& comps, const node_set& pinned,
+                               std::vector<std::string>& log);
+
+  struct pass {
+    const char* name;
+    std::size_t (*run)(component_list&, const node_set&);
+  };
+
+  //default pipeline, in order
+  inline const pass pipeline[] = {
+    { "fold_grounded_sources", fold_grounded_sources },
+    { "merge_resistors",       merge_resistors       },
+    { "combine_static",        combine_static        },
+    { "kron_reduce",           kron_reduce           },
+    { "prima_reduce",          prima_reduce          },
+    { "drop_floating",         drop_floating         },
+    { "batch_fets",            batch_fets            },
+  };
+
+}		// -----  end of namespace rtspice::circuit::passes  -----
+
+#endif   // ----- #ifndef passes_INC  -----
@@ -0,0 +1,169 @@
+/*!
+ *    @file  resampler.hpp
+ *   @brief  polyphase FIR interpolator and decimator for integer factors
+ *
+ *  Both share one linear phase lowpass, a Kaiser windowed sinc cut at the
+ *  base rate Nyquist frequency, split in factor phases of taps coefficients.
+ *  Buffers are sized on construction, processing never allocates.
+ *
+ *  @author  Thadeu Luiz Barbosa Dias (tlbd)
+ *
+ *  @internal
+ *       Created:  10/18/2026
+ *      Revision:  none
+ *      Compiler:  g++
+ *  Organization:  SMT - Signals, Multimedia and Telecommunications Lab
+ *     Copyright:  Copyright (c) 2019, Thadeu Luiz Barbosa Dias
+ *
+ *  This source code is released for free distribution under the terms of the
+ *  GNU General Public License as published by the Free Software Foundation.
+ */
+
+#ifndef  resampler_INC
+#define  resampler_INC
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace rtspice::circuit {
+
+  /*!
+   *  @brief  lowpass prototype, factor*taps long, unit DC gain
+   *
+   *  beta = 7 puts the stopband about 70 dB down; with 48 taps per phase it
+   *  starts 10% of the base rate above its Nyquist frequency.
+   */
+  inline std::vector<float> resampler_kernel(unsigned factor, unsigned taps,
+                                             double beta = 7.0) {
+
+    //zeroth order modified Bessel function, by its series
+    const auto I0 = [](double x) {
+      double s = 1.0, t = 1.0;
+      for(int k = 1; k < 32; ++k) {
+        t *= 0.25*x*x/(k*k);
+        s += t;
+      }
+      return s;
+    };
+
+    const auto N  = factor*taps;
+    const auto pi = 4.0*std::atan(1.0);
+    const auto c  = 0.5*(N - 1);
+
+    std::vector<double> h(N);
+    double sum = 0.0;
+
+    for(unsigned n = 0; n < N; ++n) {
+      const auto t = (n - c)/factor;
+      const auto r = (n - c)/c;
+      const auto sinc = t == 0.0 ? 1.0 : std::sin(pi*t)/(pi*t);
+      h[n] = sinc*I0(beta*std::sqrt(std::max(0.0, 1.0 - r*r)))/I0(beta);
+      sum += h[n];
+    }
+
+    std::vector<float> kernel(N);
+    for(unsigned n = 0; n < N; ++n) kernel[n] = h[n]/sum;
+    return kernel;
+  }
+
+  /*!
+   *  @brief  factor samples out for each sample in
+   */
+  class interpolator {
+    public:
+      interpolator(unsigned factor = 1, unsigned taps = 48) :
+        L_{ factor }, P_{ taps },
+        phases_(L_*P_),
+        history_(2*P_, 0.0f) {
+
+        //phase k, reversed to run along the history: y = sum w_k[i] x[n-P+1+i]
+        const auto h = resampler_kernel(L_, P_);
+        for(unsigned k = 0; k < L_; ++k)
+          for(unsigned i = 0; i < P_; ++i)
+            phases_[k*P_ + i] = L_*h[k + (P_ - 1 - i)*L_];
+      }
+
+      //n samples from in, n*factor() to out
+      void process(const float* in, std::size_t n, float* out) noexcept {
+
+        for(std::size_t s = 0; s < n; ++s) {
+
+          //mirrored, so the last P_ inputs are always contiguous
+          history_[pos_] = history_[pos_ + P_] = in[s];
+          pos_ = pos_ + 1 == P_ ? 0 : pos_ + 1;
+
+          const auto x = history_.data() + pos_;
+
+          for(unsigned k = 0; k < L_; ++k) {
+            const auto w = phases_.data() + k*P_;
+            auto y = 0.0f;
+            #pragma omp simd reduction(+:y)
+            for(unsigned i = 0; i < P_; ++i) y += w[i]*x[i];
+            *out++ = y;
+          }
+        }
+      }
+
+      unsigned factor() const noexcept { return L_; }
+
+      //group delay, in input samples
+      float delay() const noexcept { return 0.5f*(L_*P_ - 1)/L_; }
+
+    private:
+      unsigned L_, P_;
+      std::vector<float> phases_;
+      std::vector<float> history_;
+      std::size_t pos_ = 0;
+  };
+
+  /*!
+   *  @brief  one sample out for each factor samples in
+   */
+  class decimator {
+    public:
+      decimator(unsigned factor = 1, unsigned taps = 48) :
+        L_{ factor }, N_{ factor*taps },
+        kernel_(N_),
+        history_(2*N_, 0.0f) {
+
+        const auto h = resampler_kernel(L_, taps);
+        for(unsigned i = 0; i < N_; ++i) kernel_[i] = h[N_ - 1 - i];
+      }
+
+      //n*factor() samples from in, n to out
+      void process(const float* in, std::size_t n, float* out) noexcept {
+
+        for(std::size_t s = 0; s < n; ++s) {
+
+          for(unsigned k = 0; k < L_; ++k) {
+            history_[pos_] = history_[pos_ + N_] = *in++;
+            pos_ = pos_ + 1 == N_ ? 0 : pos_ + 1;
+          }
+
+          //only the kept samples are filtered
+          const auto x = history_.data() + pos_;
+          auto y = 0.0f;
+          #pragma omp simd reduction(+:y)
+          for(unsigned i = 0; i < N_; ++i) y += kernel_[i]*x[i];
+          out[s] = y;
+        }
+      }
+
+      unsigned factor() const noexcept { return L_; }
+
+      //group delay, in output samples, each one taken at the last of its
+      //factor inputs
+      float delay() const noexcept { return (0.5f*(N_ - 1) - (L_ - 1))/L_; }
+
+    private:
+      unsigned L_, N_;
+      std::vector<float> kernel_;
+      std::vector<float> history_;
+      std::size_t pos_ = 0;
+  };
+
+}		// -----  end of namespace rtspice::circuit  -----
+
+#endif   // ----- #ifndef resampler_INC  -----
@@ -0,0 +1,158 @@
+/*!
+ *    @file  wdf.hpp
+ *   @brief  wave digital filter engine for netlists around a single root
+ *
+ *  A netlist whose elements, seen from a single root element, reduce to
+ *  series and parallel combinations runs as a wave digital filter: one
+ *  upward and one downward pass over the adaptor tree per sample, with no
+ *  matrix to solve. What does not reduce, such as a bridge, becomes one
+ *  R-type adaptor, a dense scattering matrix over its ports rebuilt from
+ *  their resistances on every change of step. The root is either the only
+ *  nonlinearity, a group of diodes across the same two nodes, or a voltage
+ *  source in a linear netlist.
+ *
+ *  Diodes scatter the incident wave explicitly, b = g(a), so their models may
+ *  ask for antiderivative antialiasing: b is then the divided difference of
+ *  the first or second antiderivative of g over the last incident waves.
+ *  Both come in closed form in terms of the port voltage v, since along the
+ *  root a = v + R I(v).
+ *
+ *  @author  Thadeu Luiz Barbosa Dias (tlbd)
+ *
+ *  @internal
+ *       Created:  10/18/2026
+ *      Revision:  none
+ *      Compiler:  g++
+ *  Organization:  SMT - Signals, Multimedia and Telecommunications Lab
+ *     Copyright:  Copyright (c) 2019, Thadeu Luiz Barbosa Dias
+ *
+ *  This source code is released for free distribution under the terms of the
+ *  GNU General Public License as published by the Free Software Foundation.
+ */
+
+#ifndef  wdf_INC
+#define  wdf_INC
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "component.hpp"
+
+namespace rtspice::components {
+  class diode_resistance;
+  class potentiometer;
+}
+
+namespace rtspice::circuit::wdf {
+
+  /*!
+   *  @brief  adaptor tree of a netlist around its root
+   */
+  class tree {
+    public:
+      using component_list = std::vector<components::component::ptr>;
+
+      //nullptr, with the reason in why, if the netlist is not supported
+      static std::unique_ptr<tree> build(const component_list& comps,
+                                         std::string& why);
+
+      //one sample, sources are read at their current time
+      void advance(float delta_t);
+
+      //node names, and their voltages against ground at the last sample
+      const auto& nodes()      const noexcept { return nodes_; }
+      const auto& potentials() const noexcept { return potentials_; }
+
+      auto size() const noexcept { return tree_.size(); }
+
+    private:
+      enum class kind { resistor, capacitor, inductor, source, series, parallel,
+                        rtype };
+
+      struct element {
+        kind k;
+        float value = 0.0f;            //R, C or L
+        float R = 0.0f;                //port resistance
+        float a = 0.0f, b = 0.0f;      //incident and reflected waves
+        float state = 0.0f;            //last v + R i, reactive leaves
+        std::size_t first = 0, last = 0; //children, adaptors
+        std::size_t r = 0;             //its scattering matrix, R-type
+        std::size_t p, n;              //port nodes, in its own orientation
+        std::function<float()> source;
+      };
+
+      struct child {
+        std::size_t e;
+        float sign;         //-1 if the child port is reversed in the adaptor
+        float gamma = 0.0f; //R/R0 in series, R0/R in parallel
+      };
+
+      //R-type: children as branches between the nodes they join, the
+      //adaptor port across p and n, n the reference
+      struct scattering {
+        std::vector<std::size_t> nodes;            //global, but n
+        std::vector<std::pair<int, int>> branches; //local, -1 for n
+        int p;
+        std::vector<float> S; //row major, the adaptor port first
+      };
+
+      //both halves of a potentiometer, resistor leaves, at the knob last read
+      struct knob {
+        const components::potentiometer* pot;
+        float pos;
+        std::size_t a, b;
+      };
+
+      //potential[to] = potential[from] + sign*v(e)
+      struct step {
+        std::size_t to, from, e;
+        float sign;
+      };
+
+      //diode root: current, its derivative and its first two antiderivatives,
+      //all diodes summed, at the port voltage
+      struct junction { double I, G, J, J2; };
+
+      void resize_(float delta_t);
+      bool scatter_(element& e); //false if its ports leave a node floating
+      float root_(float a);
+
+      junction junction_(double v) const noexcept;
+      double   solve_(double a) const noexcept; //port voltage, from v_root_
+      double   Q_(double v) const noexcept;     //integral of I^2 from 0
+      double   G1_(double a) const noexcept;    //antiderivatives of g
+      double   G2_(double a) const noexcept;
+      double   D_(double a, double b) const noexcept; //(G2(a) - G2(b))/(a - b)
+
+      std::vector<element> tree_; //children before parents, the top last
+      std::vector<child>   children_;
+      std::vector<scattering> rtypes_;
+      std::vector<float>   waves_; //scratch, as wide as the widest R-type
+      std::vector<step>    walk_;
+      std::vector<knob>    knobs_;
+
+      component_list held_; //owners of the elements below
+
+      //root element, between top.p and top.n
+      std::function<float()> root_source_;
+      std::vector<std::pair<const components::diode_resistance*, float>> diodes_;
+      double v_root_ = 0.0;
+
+      unsigned adaa_ = 0;
+      double a1_ = 0.0, a2_ = 0.0;             //last incident waves
+      double a_aligned_ = 0.0;                 //incident, as late as b
+      double G1a1_ = 0.0, G2a1_ = 0.0, D12_ = 0.0; //at them, for the next one
+      std::vector<double> Q_table_, I2_table_; //on a fine grid around 0
+
+      std::vector<std::string> nodes_;
+      std::vector<float>       potentials_;
+      std::size_t              ground_;
+
+      float delta_t_ = 0.0f;
+  };
+
+}		// -----  end of namespace rtspice::circuit::wdf  -----
+
+#endif   // ----- #ifndef wdf_INC  -----
@@ -16,13 +16,19 @@
  */
 
 #include "circuit.hpp"
+#include "passes.hpp"
+#include "wdf.hpp"
+#include "btf.hpp"
+#include "ordering.hpp"
 
 #include <cstdint>
 #include <algorithm>
+#include <functional>
 #ifdef RTSPICE_USE_PSTL
 #include <execution>
 #endif
 #include <numeric>
+#include <set>
 
 using namespace std;
 
@@ -35,21 +41,58 @@ namespace rtspice::circuit {
 
   using components::component;
 
-  circuit::circuit(vector<component::ptr> components) {
+  circuit::circuit(vector<component::ptr> components, bool simplify) {
+
+      const auto wave = passes::option(components, "WDF", 0.0f) != 0.0f;
+      const auto os   = passes::option(components, "OVERSAMPLE", 1.0f);
+      const auto ad   = passes::option(components, "ADAPTIVE", 0.0f) != 0.0f;
+
+      auto parts = passes::split_partitions(components); //own circuits
 
       setup_context_();              //init cuda
+      passes::apply_method(components, {});     //integration method
+      passes::couple_inductors(components, {}, log_); //resolve K cards
+      passes::expm_discretize(components, passes::pinned(components));
+      if(simplify)
+        simplify_(components);       //reduce netlist
       setup_components_(components); //get component classes
 
-      register_nodes_();             //get needed variables
+      register_nodes_(components);   //get needed variables
+      index_nodes_();                //number unknowns and equations
       setup_system_();               //allocate linear system memory
       setup_nodes_();                //feed system pointers to components
 
       init_components_();
 
       setup_static_();               //feed static stamps
+
+      for(auto&& p: parts)           //own circuits, tied through ports
+        if(p.threaded)
+          setup_thread_(p, simplify);
+        else
+          setup_slow_(p, simplify);
+
+      if(wave)
+        setup_wdf_(components);        //wave digital mode, if it fits
+
+      if(os == 2.0f || os == 4.0f || os == 8.0f)
+        oversampling_ = os;
+      else if(os != 1.0f)
+        log_.push_back("oversampling: factor must be 1, 2, 4 or 8, running at 1x");
+
+      adaptive_ = ad && oversampling_ > 1;
   }
 
   circuit::~circuit() {
+    for(auto&& t: threads_) {
+      settle_(*t);
+      t->stop = true;
+      {
+        lock_guard l{t->m};
+        t->wake.notify_one();
+      }
+      t->worker.join();
+    }
     teardown_system_();
     teardown_context_();
   }
@@ -67,6 +110,89 @@ namespace rtspice::circuit {
     copy_if(comps.begin(), comps.end(),
         back_inserter(components_.nonlinear),
         [](auto&& c) { return c->is_nonlinear(); });
+
+    const auto& nl = components_.nonlinear;
+    pwl_.enabled = !nl.empty() &&
+      all_of(nl.begin(), nl.end(), [](auto&& c) { return c->is_piecewise(); });
+  }
+
+  void circuit::setup_wdf_(const vector<component::ptr>& comps) {
+
+    string why;
+    wdf_ = wdf::tree::build(comps, why);
+
+    if(!wdf_) {
+      log_.push_back("wdf: " + why + ", running MNA");
+      return;
+    }
+
+    const auto& names = wdf_->nodes();
+    for(size_t i = 0; i < names.size(); ++i)
+      if(const auto it = nodes_.names.find(names[i]);
+         it != nodes_.names.end() && it->second >= 0)
+        wdf_x_.emplace_back(i, it->second);
+
+    log_.push_back("wdf: " + to_string(wdf_->size()) + " adaptor tree elements");
+  }
+
+  void circuit::setup_slow_(passes::partition& p, bool simplify) {
+
+    slow_partition_ s;
+    s.c     = make_unique<circuit>(move(p.components), simplify);
+    s.ratio = p.ratio;
+    s.hold  = p.hold;
+
+    for(auto&& port: p.ports)
+      s.ports.push_back({port.v, port.i, get_state(port.branch), s.c->get_state(port.node)});
+
+    log_.push_back("slow: " + p.instance + " every " + to_string(s.ratio) +
+                   " steps, m = " + to_string(s.c->size()) + ", " +
+                   to_string(s.ports.size()) + " ports");
+    for(auto&& l: s.c->log()) log_.push_back("  " + l);
+
+    slow_.push_back(move(s));
+  }
+
+  void circuit::setup_thread_(passes::partition& p, bool simplify) {
+
+    auto t = make_unique<thread_partition_>();
+    t->c = make_unique<circuit>(move(p.components), simplify);
+
+    //the driving side reads the node, the other its source current
+    for(auto&& port: p.ports) {
+      auto& c = *t->c;
+      if(port.outward)
+        t->ports.push_back({get_state(port.branch), c.get_state(port.node),
+                            -1.0f, 1.0f, port.v, port.i});
+      else
+        t->ports.push_back({get_state(port.node), c.get_state(port.branch),
+                            1.0f, -1.0f, port.i, port.v});
+    }
+
+    t->to_worker.assign(t->ports.size(), 0.0f);
+    t->to_host.assign(t->ports.size(), 0.0f);
+
+    log_.push_back("partition: " + p.instance + " on a worker thread, m = " +
+                   to_string(t->c->size()) + ", " +
+                   to_string(t->ports.size()) + " ports");
+    for(auto&& l: t->c->log()) log_.push_back("  " + l);
+
+    t->worker = thread{work_, ref(*t)};
+    threads_.push_back(move(t));
+  }
+
+  vector<thread::native_handle_type> circuit::worker_threads() {
+    vector<thread::native_handle_type> handles;
+    auto nested = [&](circuit& c) {
+      const auto inner = c.worker_threads();
+      handles.insert(handles.end(), inner.begin(), inner.end());
+    };
+    for(auto&& t: threads_) {
+      handles.push_back(t->worker.native_handle());
+      nested(*t->c);
+    }
+    for(auto&& s: slow_) nested(*s.c);
+    return handles;
   }
 
   void circuit::setup_context_() {
@@ -79,31 +205,127 @@ namespace rtspice::circuit {
     assert(status == CUSOLVER_STATUS_SUCCESS && "cuSolver initialization failure");
   }
 
-  void circuit::register_nodes_() {
+  void circuit::simplify_(vector<component::ptr>& comps) {
+
+    const auto pinned = passes::pinned(comps);
+
+    const auto report = [this](const string& what, auto&& size) {
+      log_.push_back(what + ": m = " + to_string(size.first) +
+                            ", nnz = " + to_string(size.second));
+    };
+
+    report("netlist", measure_(comps));
 
-    for(auto&& c: components_.static_)   c->register_(*this);
-    for(auto&& c: components_.dynamic)   c->register_(*this);
-    for(auto&& c: components_.nonlinear) c->register_(*this);
+    for(auto&& [name, run]: passes::pipeline) {
+      const auto n = run(comps, pinned);
+      if(n > 0)
+        report(string{name} + " (" + to_string(n) + ")", measure_(comps));
+    }
 
   }
 
-  void circuit::setup_system_() {
+  pair<size_t, size_t> circuit::measure_(const vector<component::ptr>& comps) {
+
+    //dry run of the node registration on a clean pool
+    nodes_ = {};
+    register_nodes_(comps);
+    index_nodes_();
+    nodes_ = {};
+
+    return {system_.m, system_.nnz};
+  }
+
+  void circuit::register_nodes_(const vector<component::ptr>& comps) {
+
+    for(auto&& c: comps) c->register_(*this);
+
+    //derived variables are only kept if probed, and are never unknowns
+    for(auto it = nodes_.derived.begin(); it != nodes_.derived.end();) {
+      nodes_.rows.erase(it->first);
+      if(nodes_.names.erase(it->first)) ++it;
+      else it = nodes_.derived.erase(it);
+    }
+
+  }
+
+  void circuit::index_nodes_() {
+
+    //union-find over node names, ground is always the representative
+    using parents = map<string, string>;
+
+    const auto find = [](parents& p, string n) {
+      while(p.at(n) != n) n = p[n] = p.at(p.at(n));
+      return n;
+    };
+
+    const auto unite = [&find](parents& p, const string& a, const string& b) {
+      auto ra = find(p, a), rb = find(p, b);
+      if(ra == "0") swap(ra, rb);
+      p[ra] = rb;
+    };
+
+    parents row_p{{"0", "0"}}, col_p{{"0", "0"}};
+    for(auto&& [n, _]: nodes_.names) row_p[n] = col_p[n] = n;
+
+    //nullors: the norator current is eliminated by summing its equations,
+    //while the nullator forces both voltages to be the same unknown
+    for(auto&& [a, b]: nodes_.row_ties) unite(row_p, a, b);
+    for(auto&& [c, d]: nodes_.col_ties) unite(col_p, c, d);
+
+    //known voltages take their whole unknown class out of the system
+    map<string, const float*> known;
+    for(auto&& [n, v]: nodes_.constants) known[find(col_p, n)] = &v;
+
+    const auto number = [&find](parents& p, auto& idx, const auto& skip) {
+      map<string, ptrdiff_t> classes{{"0", -1}};
+      for(auto&& [n, i]: idx) {
+        const auto root = find(p, n);
+        i = skip.count(root) ? -1 :
+          classes.emplace(root, classes.size() - 1).first->second;
+      }
+      return classes.size() - 1;
+    };
+
+    const auto m    = number(col_p, nodes_.names, known);
+    const auto rows = number(row_p, nodes_.rows,  decltype(known){});
+
+    assert(m == rows && "nullor elimination must keep the system square");
+
+    for(auto&& [n, _]: nodes_.names)
+      if(const auto it = known.find(find(col_p, n)); it != known.end())
+        nodes_.fixed[n] = nodes_.derived[n] = it->second;
+
+    //entries touching a grounded equation or unknown are dropped, while
+    //entries on known voltages are kept apart
+    set<pair<ptrdiff_t, ptrdiff_t>> pattern;
+    set<pair<ptrdiff_t, const float*>> fixed;
+    for(auto&& [ij, _]: nodes_.pointers) {
+      const auto i = nodes_.rows.at(ij.first), j = nodes_.names.at(ij.second);
+      if(i >= 0 && j >= 0) pattern.emplace(i, j);
+      if(i >= 0 && j <  0 && nodes_.fixed.count(ij.second))
+        fixed.emplace(i, nodes_.fixed.at(ij.second));
+    }
 
-    const auto m   = nodes_.names.size();
-    const auto nnz = nodes_.pointers.size();
+    system_.m    = m;
+    system_.nnz  = pattern.size();
+    system_.nfix = fixed.size();
+  }
+
+  void circuit::setup_system_() {
 
     auto& sys = system_;
 
-    sys.m   = m;
-    sys.nnz = nnz;
+    const auto m   = sys.m;
+    const auto nnz = sys.nnz;
+    const auto nA  = sys.nnz + sys.nfix;
 
     //allocate index and value buffers
     sys.row = cuda_malloc_<int>(m+1);
     sys.col = cuda_malloc_<int>(nnz);
 
-    sys.A_static    = cuda_malloc_<float>(nnz);
-    sys.A_dynamic   = cuda_malloc_<float>(nnz);
-    sys.A_nonlinear = cuda_malloc_<float>(nnz);
+    sys.A_static    = cuda_malloc_<float>(nA);
+    sys.A_dynamic   = cuda_malloc_<float>(nA);
+    sys.A_nonlinear = cuda_malloc_<float>(nA);
 
     sys.b_static    = cuda_malloc_<float>(m);
     sys.b_dynamic   = cuda_malloc_<float>(m);
@@ -137,70 +359,165 @@ namespace rtspice::circuit {
     const auto m   = sys.m;
     const auto nnz = sys.nnz;
 
-    auto& names = nodes_.names;
-
-    //fill node_name -> index map
-    for_each(begin(names), end(names),
-                  [i = 0](auto&& p) mutable { p.second = i++; });
+    //gather coordinates, sorted by row then column
+    set<pair<ptrdiff_t, ptrdiff_t>> pattern;
+    for(auto&& [ij, _]: nodes_.pointers) {
+      const auto i = nodes_.rows.at(ij.first), j = nodes_.names.at(ij.second);
+      if(i >= 0 && j >= 0) pattern.emplace(i, j);
+    }
 
-    auto row_begin = nodes_.pointers.begin();
     //prepare initial sparsity figure
-    for(const auto& [row_name, row] : names) {
+    fill_n(sys.row.get(), m+1, 0);
+    auto offset = 0;
+    for(auto&& [i, j]: pattern) {
+      sys.col[offset++] = j;
+      ++sys.row[i+1];
+    }
+    partial_sum(sys.row.get(), sys.row.get() + m + 1, sys.row.get());
 
-      auto row_end = upper_bound(
-          row_begin,
-          nodes_.pointers.end(),
-          row_name,
-          [](auto&& rname, auto&& kv){ return rname < kv.first.first; });
+    assert(sys.row[m] == nnz && "row filling failure");
+
+    const auto row = sys.row.get(), col = sys.col.get();
 
-      //current row entries are in [row_begin, row_end) the list
+    //block triangular form, found once. without a zero free diagonal the
+    //whole system stays one block
+    const auto match = btf::transversal(m, row, col);
+    auto count = 1;
+    const auto comp = match.empty() ?
+      vector<int>(m, 0) : btf::components(m, row, col, match, count);
 
-      auto offset = sys.row[row]; //offset onto col/value buffers
-      auto entry_no  = 0;
+    vector<size_t> sizes(count, 0);
+    for(auto c: comp) ++sizes[c];
+
+    //rows and unknowns of each block, in the order of a fill reducing perm
+    const auto arrange = [&](const vector<int>& perm) {
+      vector<int> p(perm), q(perm);
+      stable_sort(q.begin(), q.end(), [&](int a, int b) { return comp[a] < comp[b]; });
+      for(size_t k = 0; k < m; ++k) p[k] = match.empty() ? q[k] : match[q[k]];
+      return make_pair(move(p), move(q));
+    };
 
-      for(; row_begin != row_end; ++row_begin, ++entry_no) {
-        const auto& col_name = row_begin->first.second;
-        const auto  col_idx  = nodes_.names.at(col_name);
-        sys.col[offset + entry_no] = col_idx;
-        row_begin->second = offset + entry_no;
+    //what factoring every diagonal block would take
+    const auto predict = [&](const vector<int>& p, const vector<int>& q) {
+      vector<int> at(m);
+      for(size_t k = 0; k < m; ++k) at[q[k]] = k;
+
+      ordering::cost c;
+      size_t begin = 0;
+      for(auto n: sizes) {
+        vector<set<int>> rows(n);
+        for(size_t r = 0; r < n; ++r) {
+          const auto i = p[begin + r];
+          for(auto k = row[i]; k < row[i+1]; ++k)
+            if(const size_t j = at[col[k]]; j >= begin && j < begin + n)
+              rows[r].insert(j - begin);
+        }
+        const auto b = ordering::compress(rows);
+        c += ordering::predict(n, b.row, b.col);
+        begin += n;
       }
+      return c;
+    };
+
+    //candidates: minimum degree and approximate minimum degree on A + A^T,
+    //approximate minimum degree on A^T A as column orderings do, reverse
+    //Cuthill-McKee, and nested dissection once the circuit is large
+    const auto sym = ordering::symmetric(m, row, col);
+    const auto ata = ordering::gram(m, row, col);
+    const auto h = context_.solver_handle;
+    const auto d = sys.desc_A;
+
+    using orderer = function<cusolverStatus_t(const ordering::pattern&, int*)>;
+    vector<tuple<string, const ordering::pattern*, orderer>> candidates {
+      {"MDQ", &sym, [&](auto&& a, int* x) {
+        return cusolverSpXcsrsymmdqHost(h, m, a.col.size(), d, a.row.data(), a.col.data(), x); }},
+      {"AMD", &sym, [&](auto&& a, int* x) {
+        return cusolverSpXcsrsymamdHost(h, m, a.col.size(), d, a.row.data(), a.col.data(), x); }},
+      {"COLAMD", &ata, [&](auto&& a, int* x) {
+        return cusolverSpXcsrsymamdHost(h, m, a.col.size(), d, a.row.data(), a.col.data(), x); }},
+      {"RCM", &sym, [&](auto&& a, int* x) {
+        return cusolverSpXcsrsymrcmHost(h, m, a.col.size(), d, a.row.data(), a.col.data(), x); }},
+    };
+    if(m >= nested_dissection)
+      candidates.emplace_back("ND", &sym, [&](auto&& a, int* x) {
+        return cusolverSpXcsrmetisndHost(h, m, a.col.size(), d, a.row.data(), a.col.data(),
+                                         nullptr, x); });
+
+    vector<int> p, q;
+    ordering::cost best;
+    string others;
 
-      //advance row
-      sys.row[row+1] = sys.row[row] + entry_no;
+    for(auto&& [name, a, order]: candidates) {
+
+      vector<int> perm(m);
+      if(order(*a, perm.data()) != CUSOLVER_STATUS_SUCCESS) continue;
+
+      auto [pc, qc] = arrange(perm);
+      const auto c = predict(pc, qc);
+
+      if(p.empty() || c < best) {
+        if(!p.empty()) others += ", " + ordering_ + " " + to_string(best.fill);
+        p = move(pc);
+        q = move(qc);
+        best = c;
+        ordering_ = name;
+      }
+      else
+        others += ", " + name + " " + to_string(c.fill);
     }
-    assert(sys.row[m] == nnz && "row filling failure");
-    assert(row_begin == nodes_.pointers.end() && "not all coordinates used");
 
-    //get optimal pattern
-    int perm[m];
-    auto status = cusolverSpXcsrsymmdqHost(context_.solver_handle, m, nnz,
-        sys.desc_A, sys.row.get(), sys.col.get(), perm);
-    assert(status == CUSOLVER_STATUS_SUCCESS);
+    log_.push_back("ordering: " + ordering_ + ", fill " + to_string(best.fill) +
+                   ", " + to_string(lround(best.flops)) + " flops" + others);
 
     //allocate permutation worksize
     size_t bsize;
-    status = cusolverSpXcsrperm_bufferSizeHost(context_.solver_handle, m, m, nnz,
-       sys.desc_A, sys.row.get(), sys.col.get(), perm, perm, &bsize);
+    auto status = cusolverSpXcsrperm_bufferSizeHost(context_.solver_handle, m, m, nnz,
+       sys.desc_A, sys.row.get(), sys.col.get(), p.data(), q.data(), &bsize);
     assert(status == CUSOLVER_STATUS_SUCCESS);
 
     uint8_t work[bsize];
     int     map[nnz];
     iota(map, map+nnz, 0);
 
-    //perform Q * A * Q^T
+    //perform P * A * Q^T
     status = cusolverSpXcsrpermHost(context_.solver_handle, m, m, nnz,
        sys.desc_A, sys.row.get(), sys.col.get(),
-       perm, perm, map, work);
+       p.data(), q.data(), map, work);
     assert(status == CUSOLVER_STATUS_SUCCESS);
 
-    //update node name map
-    for(auto&& [_, idx]: nodes_.names)
-      idx = find(perm, perm+m, idx) - perm;
+    //update node name maps
+    for(auto&& [idx, order]: {make_pair(&nodes_.names, &q), make_pair(&nodes_.rows, &p)})
+      for(auto&& [_, i]: *idx)
+        if(i >= 0) i = find(order->begin(), order->end(), i) - order->begin();
+
+    setup_blocks_(sizes);
+
+    //known voltage entries, stored past the sparse values
+    set<pair<ptrdiff_t, const float*>> fixed;
+    for(auto&& [ij, _]: nodes_.pointers)
+      if(const auto a = nodes_.rows.at(ij.first); a >= 0)
+        if(const auto it = nodes_.fixed.find(ij.second); it != nodes_.fixed.end())
+          fixed.emplace(a, it->second);
+    sys.fixed.assign(fixed.begin(), fixed.end());
+
+    assert(sys.fixed.size() == sys.nfix && "fixed entry failure");
 
     for(auto&& kv: nodes_.pointers){
 
       const auto& [na, nb] = kv.first;
-      const auto a = nodes_.names.at(na), b = nodes_.names.at(nb);
+      const auto a = nodes_.rows.at(na), b = nodes_.names.at(nb);
+
+      if(a >= 0 && nodes_.fixed.count(nb)) { //moved to b before solving
+        const auto k = find(sys.fixed.begin(), sys.fixed.end(),
+                            make_pair(a, nodes_.fixed.at(nb)));
+        kv.second = nnz + (k - sys.fixed.begin());
+        continue;
+      }
+
+      if(a < 0 || b < 0) { //folded into ground
+        kv.second = -1;
+        continue;
+      }
 
       const auto row = sys.row.get(),
                  col = sys.col.get();
@@ -208,13 +525,71 @@ namespace rtspice::circuit {
       const auto ofs = find(&col[row[a]], &col[row[a+1]], b) - col;
 
       assert(ofs != row[a+1]);
-      assert(map[ofs] == kv.second);
 
       kv.second = ofs;
     }
 
   }
 
+  void circuit::setup_blocks_(const vector<size_t>& sizes) {
+
+    auto& sys = system_;
+    const auto row = sys.row.get(), col = sys.col.get();
+
+    vector<size_t> block_of;
+    for(size_t k = 0; k < sizes.size(); ++k) block_of.insert(block_of.end(), sizes[k], k);
+
+    btf_.blocks.clear();
+
+    size_t begin = 0;
+    for(auto n: sizes) {
+
+      block_ b;
+      b.begin = begin;
+      b.end   = begin + n;
+      b.row.push_back(0);
+
+      set<size_t> reads;
+      for(auto i = b.begin; i < b.end; ++i) {
+        for(auto k = row[i]; k < row[i+1]; ++k)
+          if(size_t(col[k]) >= b.begin) {
+            assert(size_t(col[k]) < b.end && "block triangular form failure");
+            b.col.push_back(col[k] - b.begin);
+          }
+          else
+            reads.insert(block_of[col[k]]);
+        b.row.push_back(b.col.size());
+      }
+
+      b.reads.assign(reads.begin(), reads.end());
+      b.A.resize(b.col.size());
+      b.b.resize(n);
+
+      btf_.blocks.push_back(move(b));
+      begin += n;
+    }
+  }
+
+  void circuit::settle_blocks_(const set<ptrdiff_t>& nonlinear_rows) {
+
+    auto& blocks = btf_.blocks;
+
+    for(auto&& b: blocks) {
+      const auto r = nonlinear_rows.lower_bound(b.begin);
+      b.settled = (r == nonlinear_rows.end() || size_t(*r) >= b.end) &&
+        all_of(b.reads.begin(), b.reads.end(), [&](auto k) { return blocks[k].settled; });
+    }
+
+    if(blocks.size() > 1) {
+      const auto largest = max_element(blocks.begin(), blocks.end(), [](auto&& a, auto&& b) {
+        return a.end - a.begin < b.end - b.begin;
+      });
+      log_.push_back("btf: " + to_string(blocks.size()) + " blocks, largest " +
+                     to_string(largest->end - largest->begin) + ", " +
+                     to_string(settled_blocks()) + " settled");
+    }
+  }
+
   void circuit::teardown_context_() {
 
     int status;
@@ -229,43 +604,226 @@ namespace rtspice::circuit {
 
     for(auto&& c: components_.static_)   c->setup(*this);
     for(auto&& c: components_.dynamic)   c->setup(*this);
+
+    //rows nonlinear stamps reach, which keep their blocks iterating
+    set<ptrdiff_t> rows;
+    btf_.touched = &rows;
     for(auto&& c: components_.nonlinear) c->setup(*this);
+    btf_.touched = nullptr;
+
+    settle_blocks_(rows);
 
   }
 
   void circuit::setup_static_() {
 
     auto& sys = system_;
-    const auto m = sys.m, nnz = sys.nnz;
-
-    sys.A = sys.A_static.get();
-    sys.b = sys.b_static.get();
-
-    fill_n(sys.A, nnz, 0.0);
-    fill_n(sys.b, m,   0.0);
+    const auto m = sys.m, nnz = sys.nnz + sys.nfix;
 
     fill_n(sys.x,       m,   0.0);
     fill_n(sys.xn,      m,   0.0);
     fill_n(sys.x_state, m,   0.0);
 
-    for(auto&& c: components_.static_) c->fill();
+    fill_static_();
 
     copy_n(sys.A, nnz, sys.A_dynamic.get());
     copy_n(sys.A, nnz, sys.A_nonlinear.get());
 
-    copy_n(sys.b, nnz, sys.b_dynamic.get());
-    copy_n(sys.b, nnz, sys.b_nonlinear.get());
+    copy_n(sys.b, m, sys.b_dynamic.get());
+    copy_n(sys.b, m, sys.b_nonlinear.get());
 
   }
 
+  void circuit::fill_static_() {
+
+    auto& sys = system_;
+    const auto m = sys.m, nnz = sys.nnz + sys.nfix;
+
+    sys.A = sys.A_static.get();
+    sys.b = sys.b_static.get();
+
+    fill_n(sys.A, nnz, 0.0);
+    fill_n(sys.b, m,   0.0);
+
+    for(auto&& c: components_.static_) c->fill();
+
+  }
+
+  void circuit::prepare(float delta_t) {
+    for(auto&& s: slow_) s.c->prepare(s.ratio*delta_t);
+    for(auto&& t: threads_) {
+      settle_(*t);
+      t->c->prepare(delta_t);
+    }
+    const auto g = gamma*delta_t;
+    for(auto&& c: components_.dynamic)
+      if(staged_) {
+        c->prepare(g);
+        c->prepare(delta_t - g);
+      }
+      else
+        c->prepare(delta_t);
+  }
+
   int circuit::advance_(float delta_t) {
+
+    auto h = 0;
+    for(auto&& t: threads_)
+      if(const auto j = hand_over_(*t, delta_t); j < 0) h = j;
+
+    const auto i = staged_ ? stages_(delta_t) : step_(delta_t);
+    if(i < 0) return i;
+    if(h < 0) return h;
+
+    for(auto&& s: slow_)
+      if(const auto j = slow_step_(s, delta_t); j < 0) return j;
+
+    return i;
+  }
+
+  int circuit::slow_step_(slow_partition_& s, float delta_t) {
+
+    //charge the rest drew through the voltage sources
+    for(auto&& p: s.ports) p.q -= *p.j * delta_t;
+
+    auto i = 0;
+    if(++s.phase == s.ratio) {
+      //the very step prepare handed it, summing delta_t would round apart
+      const auto h = s.ratio*delta_t;
+      for(auto&& p: s.ports) {
+        *p.i = p.q / h;
+        p.q  = 0.0f;
+      }
+
+      i = s.c->advance_(h);
+
+      for(auto&& p: s.ports) {
+        p.v0 = p.v1;
+        p.v1 = *p.x;
+      }
+      s.phase = 0;
+    }
+
+    //for the next step, late by a slow step when interpolating
+    const auto w = float(s.phase + 1) / s.ratio;
+    for(auto&& p: s.ports)
+      *p.v = s.hold ? p.v1 : p.v0 + w*(p.v1 - p.v0);
+
+    return i;
+  }
+
+  namespace {
+    //waits on a sequence number, yielding the core after a few tries
+    template<class F>
+    void spin_(F&& ready) noexcept {
+      for(unsigned k = 0; !ready(); ++k)
+        if(k >= 64) this_thread::yield();
+    }
+  }
+
+  void circuit::settle_(thread_partition_& t) noexcept {
+    spin_([&] { return t.done.load(memory_order_acquire) == t.sent; });
+  }
+
+  int circuit::hand_over_(thread_partition_& t, float delta_t) noexcept {
+
+    //the worker's last step, usually done by now
+    settle_(t);
+
+    for(size_t k = 0; k < t.ports.size(); ++k) {
+      auto& p = t.ports[k];
+      *p.into_here   = t.to_host[k];
+      t.to_worker[k] = p.sign_here * *p.here;
+    }
+    t.delta_t = delta_t;
+
+    t.posted.store(++t.sent);
+
+    //only after the host went quiet, so the lock is almost never taken here
+    if(t.sleeping.load()) {
+      lock_guard l{t.m};
+      t.wake.notify_one();
+    }
+
+    return t.result;
+  }
+
+  void circuit::work_(thread_partition_& t) {
+
+    //yields for far longer than any host period before giving the core back
+    constexpr unsigned spins = 1u << 20;
+
+    for(uint64_t n = 0;;) {
+
+      const auto ready = [&] { return t.posted.load() != n || t.stop.load(); };
+
+      for(unsigned k = 0; !ready(); ++k)
+        if(k < spins)
+          this_thread::yield();
+        else {
+          unique_lock l{t.m};
+          t.sleeping = true;
+          t.wake.wait(l, ready);
+          t.sleeping = false;
+        }
+
+      if(t.stop) return;
+      ++n;
+
+      for(size_t k = 0; k < t.ports.size(); ++k)
+        *t.ports[k].into_there = t.to_worker[k];
+
+      const auto r = t.c->advance_(t.delta_t);
+
+      for(size_t k = 0; k < t.ports.size(); ++k) {
+        auto& p = t.ports[k];
+        t.to_host[k] = p.sign_there * *p.there;
+      }
+      t.result = r;
+
+      t.done.store(n, memory_order_release);
+    }
+  }
+
+  int circuit::stages_(float delta_t) {
+
+    //TR-BDF2: a trapezoidal stage, then BDF2 over both
+    auto& sys = system_;
+
+    sys.stage = 1;
+    auto i = step_(gamma*delta_t);
+
+    if(i >= 0) {
+      sys.stage = 2;
+      const auto j = step_(delta_t - gamma*delta_t);
+      i = j < 0 ? j : i + j;
+    }
+
+    sys.stage = 0;
+    return i;
+  }
+
+  int circuit::step_(float delta_t) {
     auto& sys = system_;
 
     //advance time
     sys.delta_time = delta_t;
     sys.time      += delta_t;
 
-    const auto m = sys.m, nnz = sys.nnz;
+    const auto m = sys.m, nnz = sys.nnz + sys.nfix;
+
+    //restamp if a static parameter moved, i.e. a knob
+    auto moved = false;
+    for(auto&& c: components_.update) moved |= c->update();
+    if(moved) fill_static_();
+
+    if(wdf_) {
+      wdf_->advance(delta_t);
+      const auto& v = wdf_->potentials();
+      for(auto&& [i, j]: wdf_x_) sys.x[j] = sys.x_state[j] = v[i];
+      for(auto&& c: components_.commit) c->commit();
+      return 1;
+    }
 
     //prefill with static data
 
@@ -296,13 +854,18 @@ namespace rtspice::circuit {
     copy_n(sys.x, m, sys.x_state);
 #endif     // -----  RTSPICE_USE_PSTL  -----
 
+    //reconstruct derived variables
+    for(auto&& c: components_.commit) c->commit();
+
     return i;
   }
 
   int circuit::nr_step_() {
 
+    if(pwl_.enabled) return pwl_step_();
+
     auto& sys = system_;
-    const auto m = sys.m, nnz = sys.nnz;
+    const auto m = sys.m, nnz = sys.nnz + sys.nfix;
 
     const auto rtol    = params_.rtol;
     const auto atol    = params_.atol;
@@ -334,16 +897,16 @@ namespace rtspice::circuit {
       swap(sys.x, sys.xn);
 
       //update solution
-      if(!solve_()) return -i;
+      if(!solve_(i == 1)) return -i;
 #if  RTSPICE_USE_PSTL
       auto good = std::transform_reduce(parallel_tag,
-                                        sys.x, sys.x + nnz,
+                                        sys.x, sys.x + m,
                                         sys.xn,
                                         true,
                                         logical_and<bool>{},
                                         close);
 #else
-      auto good = std::inner_product(sys.x, sys.x + nnz,
+      auto good = std::inner_product(sys.x, sys.x + m,
                                      sys.xn,
                                      true,
                                      logical_and<bool>{},
@@ -359,29 +922,146 @@ namespace rtspice::circuit {
 
   }
 
-  int circuit::solve_() {
+  int circuit::pwl_step_() {
+
     auto& sys = system_;
+    auto& pwl = pwl_;
+    const auto m = sys.m, nnz = sys.nnz + sys.nfix;
+
+    //factors only hold for the linear part they were built on, which moves
+    //with knobs and time steps
+    const auto A_dynamic = sys.A_dynamic.get();
+    if(!equal(A_dynamic, A_dynamic + sys.nnz, pwl.A_linear.begin(), pwl.A_linear.end())) {
+      pwl.A_linear.assign(A_dynamic, A_dynamic + sys.nnz);
+      pwl.factors.clear();
+    }
 
-    int singular = 0;
-    const auto status = cusolverSpScsrlsvluHost(context_.solver_handle,
-        sys.m, sys.nnz, sys.desc_A,
-        sys.A, sys.row.get(), sys.col.get(),
-        sys.b,
-        1e-16,
-        0, //no reordering, leaks memory
-        sys.x,
-        &singular);
+    sys.A = sys.A_nonlinear.get();
+    sys.b = sys.b_nonlinear.get();
 
-    assert(status == CUSOLVER_STATUS_SUCCESS);
-    assert(singular == -1);
+    //segments at the last solution
+    pwl.region.clear();
+    for(auto&& c: components_.nonlinear) c->region(pwl.region);
+
+    for(int i = 1; i <= params_.maxiter; ++i) {
+
+      copy_n(sys.A_dynamic.get(), nnz, sys.A);
+      copy_n(sys.b_dynamic.get(), m,   sys.b);
+
+      for(auto&& c: components_.nonlinear) c->fill();
+
+      fold_fixed_();
+
+      auto f = pwl.factors.find(pwl.region);
+
+      if(!f) {
+        dense::matrix A{m, m};
+        for(size_t r = 0; r < m; ++r)
+          for(auto k = sys.row[r]; k < sys.row[r+1]; ++k)
+            A(r, sys.col[k]) = sys.A[k];
+
+        dense::lu_factors<double> lu;
+        if(!dense::factor(move(A), lu)) return -i;
+        f = &pwl.factors.insert(pwl.region, move(lu));
+      }
+
+      swap(sys.x, sys.xn);
+      dense::solve(*f, sys.b, sys.x, pwl.scratch);
+
+      //the solution is exact once it stays on the segments it was solved for
+      pwl.next.clear();
+      for(auto&& c: components_.nonlinear) c->region(pwl.next);
+
+      if(pwl.next == pwl.region) return i;
+      pwl.region.swap(pwl.next);
+    }
+
+    //cycling between regions
+    return 0;
+  }
+
+  void circuit::fold_fixed_() {
+    auto& sys = system_;
+    for(size_t k = 0; k < sys.nfix; ++k) {
+      const auto [i, v] = sys.fixed[k];
+      sys.b[i] -= sys.A[sys.nnz + k] * *v;
+    }
+  }
+
+  int circuit::solve_(bool all) {
+    auto& sys = system_;
 
-    return status == CUSOLVER_STATUS_SUCCESS && singular == -1;
+    //move known voltages to the right hand side
+    fold_fixed_();
+
+    const auto row = sys.row.get(), col = sys.col.get();
+
+    for(auto&& blk: btf_.blocks) {
+
+      const auto n = blk.end - blk.begin;
+      const auto x = sys.x + blk.begin;
+
+      //settled blocks keep the last solution
+      if(blk.settled && !all) {
+        copy_n(sys.xn + blk.begin, n, x);
+        continue;
+      }
+
+      //diagonal block, and what the blocks before it leave of b
+      auto v = blk.A.begin();
+      for(size_t r = 0; r < n; ++r) {
+        const auto i = blk.begin + r;
+        auto bi = sys.b[i];
+        for(auto k = row[i]; k < row[i+1]; ++k)
+          if(size_t(col[k]) >= blk.begin) *v++ = sys.A[k];
+          else bi -= sys.A[k] * sys.x[col[k]];
+        blk.b[r] = bi;
+      }
+
+      if(n == 1) {
+        if(blk.A[0] == 0.0f) return 0;
+        *x = blk.b[0] / blk.A[0];
+        continue;
+      }
+
+      int singular = 0;
+      const auto status = cusolverSpScsrlsvluHost(context_.solver_handle,
+          n, blk.A.size(), sys.desc_A,
+          blk.A.data(), blk.row.data(), blk.col.data(),
+          blk.b.data(),
+          1e-16,
+          0, //no reordering, leaks memory
+          x,
+          &singular);
+
+      assert(status == CUSOLVER_STATUS_SUCCESS);
+      assert(singular == -1);
+
+      if(status != CUSOLVER_STATUS_SUCCESS || singular != -1) return 0;
+    }
+
+    return 1;
 
   }
 
   void circuit::register_node(const string& n) {
-    if(n != "0") //skip ground node
+    if(n != "0") { //skip ground node
       nodes_.names.emplace(n, 0);
+      nodes_.rows.emplace(n, 0);
+    }
+  }
+
+  void circuit::register_nullor(const pair<string, string>& norator,
+                                const pair<string, string>& nullator) {
+    nodes_.row_ties.push_back(norator);
+    nodes_.col_ties.push_back(nullator);
+  }
+
+  void circuit::register_constant(const string& n, float v) {
+    if(n != "0") { //ground is already known
+      nodes_.constants[n] = v;
+      nodes_.row_ties.emplace_back(n, "0");
+    }
   }
 
   void circuit::register_entry(const pair<string, string>& e) {
@@ -389,29 +1069,63 @@ namespace rtspice::circuit {
       nodes_.pointers.emplace(e, 0);
   }
 
+  void circuit::register_derived(const string& n) {
+    nodes_.derived.emplace(n, &system_.zero);
+  }
+
+  bool circuit::bind_derived(const string& n, const float* value) {
+    const auto it = nodes_.derived.find(n);
+    if(it == nodes_.derived.end())
+      return false;
+    it->second = value;
+    return true;
+  }
+
+  void circuit::register_commit(component* c) {
+    components_.commit.push_back(c);
+  }
+
+  void circuit::register_update(component* c) {
+    components_.update.push_back(c);
+  }
+
   entry_reference<float> circuit::get_A(const pair<string, string>& ij) {
     if(ij.first == "0" || ij.second == "0"){
       return {&system_.ground_A, 0};
     }
-    return {&system_.A, nodes_.pointers.at(ij)};
+    const auto ofs = nodes_.pointers.at(ij);
+    if(ofs < 0)
+      return {&system_.ground_A, 0};
+    if(btf_.touched) btf_.touched->insert(nodes_.rows.at(ij.first));
+    return {&system_.A, ofs};
   }
 
   entry_reference<float> circuit::get_b(const string& n) {
-    if(n == "0")
+    const auto i = n == "0" ? -1 : nodes_.rows.at(n);
+    if(i < 0)
       return {&system_.ground_A, 0};
-    return {&system_.b, nodes_.names.at(n)};
+    if(btf_.touched) btf_.touched->insert(i);
+    return {&system_.b, i};
   }
 
   entry_reference<const float> circuit::get_x(const string& n) const {
     if(n == "0")
       return {&system_.ground_x, 0};
-    return {&system_.x, nodes_.names.at(n)};
+    if(const auto it = nodes_.derived.find(n); it != nodes_.derived.end())
+      return {&it->second, 0};
+    if(const auto j = nodes_.names.at(n); j >= 0)
+      return {&system_.x, j};
+    return {&system_.ground_x, 0};
   }
 
   entry_reference<const float> circuit::get_state(const string& n) const {
     if(n == "0")
       return {&system_.ground_x, 0};
-    return {&system_.x_state, nodes_.names.at(n)};
+    if(const auto it = nodes_.derived.find(n); it != nodes_.derived.end())
+      return {&it->second, 0};
+    if(const auto j = nodes_.names.at(n); j >= 0)
+      return {&system_.x_state, j};
+    return {&system_.ground_x, 0};
   }
 
   const float* circuit::get_time() const {
@@ -422,4 +1136,8 @@ namespace rtspice::circuit {
     return &system_.delta_time;
   }
 
+  const unsigned* circuit::get_stage() const {
+    return &system_.stage;
+  }
+
 } // -----  end of namespace rtspice::circuit  -----
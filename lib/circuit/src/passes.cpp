@@ -0,0 +1,1138 @@
+/*!
+ *    @file  passes.cpp
+ *   @brief netlist simplification passes implementation
+ *
+ *  @author  Thadeu Luiz Barbosa Dias (tlbd)
+ *
+ *  @internal
+ *       Created:  10/18/2026
+ *      Revision:  none
+ *      Compiler:  g++
+ *  Organization:  SMT - Signals, Multimedia and Telecommunications Lab
+ *     Copyright:  Copyright (c) 2019, Thadeu Luiz Barbosa Dias
+ *
+ *  This source code is released for free distribution under the terms of the
+ *  GNU General Public License as published by the Free Software Foundation.
+ */
+
+#include "passes.hpp"
+#include "dense.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <tuple>
+
+#include "resistor.hpp"
+#include "sources.hpp"
+#include "dynamic.hpp"
+#include "probe.hpp"
+#include "block.hpp"
+#include "options.hpp"
+#include "fet.hpp"
+#include "opamp.hpp"
+#include "potentiometer.hpp"
+#include "switch.hpp"
+
+using namespace std;
+
+namespace rtspice::circuit::passes {
+
+  using namespace components;
+
+  namespace {
+
+    //branch currents of a component are read through these names
+    bool probed(const component& c, const node_set& pinned) {
+      return pinned.count("J@" + c.id()) || pinned.count("@J" + c.id());
+    }
+
+    //two terminal devices carrying no current when left open
+    bool passive(const component::ptr& c) {
+      return dynamic_pointer_cast<linear_resistor>(c) ||
+             capacitance(*c) > 0.0f || inductance(*c) > 0.0f;
+    }
+
+    map<string, size_t> degrees(const component_list& comps) {
+      map<string, size_t> deg;
+      for(auto&& c: comps)
+        for(auto&& n: c->terminals()) ++deg[n];
+      return deg;
+    }
+
+    template<class Pred>
+    size_t erase(component_list& comps, Pred&& pred) {
+      const auto it = remove_if(comps.begin(), comps.end(), pred);
+      const auto removed = comps.end() - it;
+      comps.erase(it, comps.end());
+      return removed;
+    }
+
+    size_t erase_at(component_list& comps, const set<size_t>& gone) {
+      component_list kept;
+      for(size_t i = 0; i < comps.size(); ++i)
+        if(!gone.count(i)) kept.push_back(move(comps[i]));
+      comps.swap(kept);
+      return gone.size();
+    }
+
+    auto resistance(const component::ptr& r) {
+      return 1.0f / static_pointer_cast<linear_resistor>(r)->function().conductance();
+    }
+
+    //nodes a linear pass may eliminate: only touched by admissible stamps,
+    //and not pinned unless probed, as the block then rebuilds the probe.
+    //pinned nodes with no probe are subcircuit ports, which must stay
+    template<class Pred>
+    map<string, bool> eliminable(const component_list& comps,
+                                 const node_set& pinned, Pred&& admissible) {
+
+      set<string> readable;
+      for(auto&& c: comps)
+        if(dynamic_pointer_cast<probe>(c))
+          for(auto&& n: c->terminals()) readable.insert(n);
+
+      map<string, bool> internal;
+      for(auto&& c: comps) {
+        if(dynamic_pointer_cast<probe>(c)) continue;
+        const auto ok = static_cast<bool>(admissible(c));
+        for(auto&& n: c->terminals())
+          if(n != "0") {
+            const auto [it, _] = internal.emplace(n, !pinned.count(n) || readable.count(n));
+            it->second = it->second && ok;
+          }
+      }
+      return internal;
+    }
+
+    //admissible stamps grouped by the inside nodes tying them together,
+    //stamps touching none are left out
+    template<class Pred, class Inside>
+    map<string, vector<size_t>> clusters_of(const component_list& comps,
+                                            Pred&& admissible, Inside&& inside) {
+
+      map<string, string> parent;
+      const auto find = [&parent](string n) {
+        parent.emplace(n, n);
+        while(parent[n] != n) n = parent[n] = parent[parent[n]];
+        return n;
+      };
+
+      for(auto&& c: comps) {
+        if(!admissible(c)) continue;
+        string first;
+        for(auto&& n: c->terminals())
+          if(inside(n)) {
+            if(first.empty()) first = n;
+            parent[find(n)] = find(first);
+          }
+      }
+
+      map<string, vector<size_t>> clusters;
+      for(size_t i = 0; i < comps.size(); ++i) {
+        if(!admissible(comps[i])) continue;
+        for(auto&& n: comps[i]->terminals())
+          if(inside(n)) { clusters[find(n)].push_back(i); break; }
+      }
+      return clusters;
+    }
+
+  }
+
+  float option(const component_list& comps, const string& key, float fallback) {
+    for(auto&& c: comps)
+      if(const auto o = dynamic_pointer_cast<options>(c))
+        for(auto&& [k, v]: o->values())
+          if(k == key) fallback = v;
+    return fallback;
+  }
+
+  size_t apply_method(component_list& comps, const node_set&) {
+
+    const auto m = static_cast<integration::method>(
+        option(comps, "METHOD", float(integration::method::unspecified)));
+    if(m == integration::method::unspecified) return 0;
+
+    size_t changed = 0;
+    for(auto&& c: comps) {
+      const auto ts = c->terminals();
+      if(const auto x = dynamic_pointer_cast<linear_capacitor>(c))
+        c = make_integrated<dynamic, linear_capacitor_branch>(m, x->id(), ts[0], ts[1], x->function());
+      else if(const auto x = dynamic_pointer_cast<linear_inductor>(c))
+        c = make_integrated<dynamic, linear_inductor_branch>(m, x->id(), ts[0], ts[1], x->function());
+      else if(const auto x = dynamic_pointer_cast<norton_capacitor>(c))
+        c = make_integrated<companion, linear_capacitor_norton>(m, x->id(), ts[0], ts[1], x->function());
+      else if(const auto x = dynamic_pointer_cast<norton_inductor>(c))
+        c = make_integrated<companion, linear_inductor_norton>(m, x->id(), ts[0], ts[1], x->function());
+      else
+        continue;
+      ++changed;
+    }
+    return changed;
+  }
+
+  vector<partition> split_partitions(component_list& comps) {
+
+    //outermost instances first, cards nested in a split instance are moot
+    vector<shared_ptr<partition_card>> cards;
+    for(auto&& c: comps)
+      if(const auto s = dynamic_pointer_cast<partition_card>(c))
+        if(!s->instance().empty()) cards.push_back(s);
+    erase(comps, [](auto&& c) { return dynamic_pointer_cast<partition_card>(c) != nullptr; });
+
+    stable_sort(cards.begin(), cards.end(), [](auto&& a, auto&& b) {
+      return a->instance().size() < b->instance().size();
+    });
+
+    //host inputs and knobs are only read by the top circuit, so they stay
+    const auto hosted = [](const component::ptr& c) {
+      return dynamic_pointer_cast<ext_voltage>(c)   ||
+             dynamic_pointer_cast<ext_current>(c)   ||
+             dynamic_pointer_cast<potentiometer>(c) ||
+             dynamic_pointer_cast<spst_switch>(c);
+    };
+
+    const auto within = [](const string& id, const string& instance) {
+      return id.rfind(instance, 0) == 0;
+    };
+
+    //branch current probes follow their component
+    const auto owner = [&](const component::ptr& c) {
+      if(dynamic_pointer_cast<probe>(c)) {
+        const auto t = c->terminals().front();
+        return t.rfind("@J", 0) == 0 || t.rfind("J@", 0) == 0 ? t.substr(2) : string{};
+      }
+      return hosted(c) ? string{} : c->id();
+    };
+
+    vector<partition> parts;
+    set<string> driven; //ports driven by the partitions split so far
+
+    for(auto&& s: cards) {
+
+      const auto& instance = s->instance();
+      if(any_of(parts.begin(), parts.end(),
+                [&](auto&& p) { return within(instance, p.instance); })) continue;
+
+      component_list inside, outside;
+      for(auto&& c: comps)
+        (within(owner(c), instance) ? inside : outside).push_back(c);
+      if(inside.empty()) continue;
+
+      set<string> mine, theirs, loaded, outputs;
+      for(auto&& c: inside)  for(auto&& n: c->terminals()) mine.insert(n);
+      for(auto&& c: outside) for(auto&& n: c->terminals()) theirs.insert(n);
+      for(auto&& c: outside)
+        if(!dynamic_pointer_cast<probe>(c))
+          for(auto&& n: c->terminals()) loaded.insert(n);
+      for(auto&& c: inside)
+        if(dynamic_pointer_cast<ideal_opamp>(c)) outputs.insert(c->terminals().front());
+      mine.erase("0");
+
+      const auto drives = [&](const string& n) {
+        return !s->threaded() || outputs.count(n) || !loaded.count(n);
+      };
+
+      //two partitions driving the same node would fight over it
+      if(any_of(mine.begin(), mine.end(),
+                [&](auto&& n) { return theirs.count(n) && drives(n) && driven.count(n); }))
+        continue;
+
+      partition p{instance, move(inside), max(s->ratio(), 1u), s->hold(),
+                  s->threaded(), {}};
+
+      for(auto&& c: comps)
+        if(dynamic_pointer_cast<options>(c)) p.components.push_back(c);
+
+      //the undriven side sees a voltage source, the driving side the current
+      //it draws
+      const auto tag = s->threaded() ? string{"PORT@"} : string{"SLOW@"};
+      for(auto&& n: mine) {
+        if(!theirs.count(n)) continue;
+        auto v = make_shared<float>(0.0f), i = make_shared<float>(0.0f);
+        if(drives(n)) {
+          outside.push_back(make_component<shared_voltage>(tag + n, n, "0", v));
+          p.components.push_back(make_component<shared_current>("LOAD@" + n, n, "0", i));
+          p.components.push_back(make_component<probe>(n));
+          p.ports.push_back({n, "J@" + tag + n, move(v), move(i), true});
+          driven.insert(n);
+        }
+        else {
+          p.components.push_back(make_component<shared_voltage>(tag + n, n, "0", v));
+          outside.push_back(make_component<shared_current>("LOAD@" + instance + n, n, "0", i));
+          p.ports.push_back({n, "J@" + tag + n, move(v), move(i), false});
+        }
+      }
+
+      comps.swap(outside);
+      parts.push_back(move(p));
+    }
+
+    return parts;
+  }
+
+  node_set pinned(const component_list& comps) {
+    node_set names;
+    for(auto&& c: comps)
+      if(dynamic_pointer_cast<probe>(c))
+        for(auto&& n: c->terminals()) names.insert(n);
+    return names;
+  }
+
+  size_t drop_floating(component_list& comps, const node_set& pinned) {
+
+    size_t removed = 0;
+
+    //union-find over terminals, every component connects all of its nodes
+    map<string, string> parent{{"0", "0"}};
+
+    const auto find = [&parent](string n) {
+      parent.emplace(n, n);
+      while(parent[n] != n) n = parent[n] = parent[parent[n]];
+      return n;
+    };
+
+    for(auto&& c: comps) {
+      const auto ts = c->terminals();
+      for(auto&& n: ts) {
+        auto ra = find(ts.front()), rb = find(n);
+        if(ra == "0") swap(ra, rb);
+        parent[ra] = rb;
+      }
+    }
+
+    set<string> anchored{find("0")};
+    for(auto&& n: pinned) anchored.insert(find(n));
+
+    removed += erase(comps, [&](auto&& c) {
+      const auto ts = c->terminals();
+      return !ts.empty() && !anchored.count(find(ts.front())) && !probed(*c, pinned);
+    });
+
+    //passives with a dangling end carry no current
+    for(auto done = false; !done;) {
+
+      const auto deg = degrees(comps);
+      const auto dangling = [&](const string& n) {
+        return n != "0" && !pinned.count(n) && deg.at(n) == 1;
+      };
+
+      const auto n = erase(comps, [&](auto&& c) {
+        const auto ts = c->terminals();
+        return passive(c) && !probed(*c, pinned) &&
+               any_of(ts.begin(), ts.end(), dangling);
+      });
+
+      removed += n;
+      done = n == 0;
+    }
+
+    return removed;
+  }
+
+  size_t fold_grounded_sources(component_list& comps, const node_set& pinned) {
+
+    set<string> fixed;
+    for(auto&& c: comps)
+      if(dynamic_pointer_cast<fixed_voltage>(c))
+        fixed.insert(c->terminals().front());
+
+    size_t folded = 0;
+
+    for(auto&& c: comps) {
+
+      const auto v = dynamic_pointer_cast<dc_voltage>(c);
+      if(!v || probed(*c, pinned)) continue;
+
+      const auto ts = v->terminals();
+      const auto V  = v->function().value();
+
+      //node held against ground, with the sign of the source
+      const auto [n, val] = ts[1] == "0" ? make_pair(ts[0],  V) :
+                            ts[0] == "0" ? make_pair(ts[1], -V) :
+                                           make_pair("0"s,   V);
+
+      if(n == "0" || !fixed.insert(n).second) continue;
+
+      c = make_component<fixed_voltage>(c->id(), n, val);
+      ++folded;
+    }
+
+    //the branch current unknowns are gone, the components are kept
+    return folded;
+  }
+
+  size_t merge_resistors(component_list& comps, const node_set& pinned) {
+
+    const auto is_resistor = [](auto&& c) {
+      return static_cast<bool>(dynamic_pointer_cast<linear_resistor>(c));
+    };
+
+    size_t removed = 0;
+
+    for(auto changed = true; changed;) {
+      changed = false;
+
+      //shorted resistors do nothing
+      removed += erase(comps, [&](auto&& c) {
+        if(!is_resistor(c) || probed(*c, pinned)) return false;
+        const auto ts = c->terminals();
+        return ts[0] == ts[1];
+      });
+
+      //parallel: same terminals, in any order
+      map<pair<string, string>, vector<size_t>> groups;
+      for(size_t i = 0; i < comps.size(); ++i) {
+        if(!is_resistor(comps[i]) || probed(*comps[i], pinned)) continue;
+        auto ts = comps[i]->terminals();
+        sort(ts.begin(), ts.end());
+        groups[{ts[0], ts[1]}].push_back(i);
+      }
+
+      set<size_t> gone;
+      for(auto&& [ab, idx]: groups) {
+        if(idx.size() < 2) continue;
+
+        auto G  = 0.0f;
+        auto id = string{};
+        for(auto i: idx) {
+          G  += 1.0f / resistance(comps[i]);
+          id += (id.empty() ? "" : "||") + comps[i]->id();
+          gone.insert(i);
+        }
+        gone.erase(idx.front());
+
+        comps[idx.front()] =
+          make_component<linear_resistor>(id, ab.first, ab.second, 1.0f / G);
+      }
+
+      if(!gone.empty()) {
+        removed += erase_at(comps, gone);
+        changed = true;
+        continue;
+      }
+
+      //series: internal node shared by exactly two resistors
+      const auto deg = degrees(comps);
+      map<string, vector<size_t>> incident;
+      for(size_t i = 0; i < comps.size(); ++i) {
+        if(!is_resistor(comps[i]) || probed(*comps[i], pinned)) continue;
+        for(auto&& n: comps[i]->terminals()) incident[n].push_back(i);
+      }
+
+      for(auto&& [n, idx]: incident) {
+        if(n == "0" || pinned.count(n) || deg.at(n) != 2 || idx.size() != 2)
+          continue;
+
+        const auto ra = comps[idx[0]], rb = comps[idx[1]];
+
+        const auto other = [&n = n](auto&& r) {
+          const auto ts = r->terminals();
+          return ts[0] == n ? ts[1] : ts[0];
+        };
+
+        comps[idx[0]] = make_component<linear_resistor>(
+            ra->id() + "+" + rb->id(), other(ra), other(rb),
+            resistance(ra) + resistance(rb));
+        comps.erase(comps.begin() + idx[1]);
+
+        ++removed;
+        changed = true;
+        break; //indices are stale
+      }
+    }
+
+    return removed;
+  }
+
+  size_t combine_static(component_list& comps, const node_set&) {
+
+    //stamps are keyed by their terminals, current sources in a canonical
+    //orientation, mapping to the surviving component and the summed value
+    struct stamp { size_t head; float value; string id; };
+    map<vector<string>, stamp> vccs, sources;
+    set<size_t> gone;
+
+    const auto add = [&gone](auto& table, auto key, size_t i,
+                             float value, const string& id) {
+      const auto [it, first] = table.emplace(move(key), stamp{i, 0.0f, {}});
+      it->second.value += value;
+      it->second.id    += (first ? "" : "+") + id;
+      if(!first) gone.insert(i);
+    };
+
+    for(size_t i = 0; i < comps.size(); ++i) {
+
+      if(const auto g = dynamic_pointer_cast<linear_vccs>(comps[i]))
+        add(vccs, g->terminals(), i, g->function().gain(), g->id());
+
+      if(const auto s = dynamic_pointer_cast<dc_current>(comps[i])) {
+        auto ts = s->terminals();
+        auto I  = s->function().value();
+        if(ts[1] < ts[0]) { swap(ts[0], ts[1]); I = -I; }
+        add(sources, ts, i, I, s->id());
+      }
+    }
+
+    if(gone.empty()) return 0;
+
+    for(auto&& [ts, s]: vccs)
+      if(s.id != comps[s.head]->id())
+        comps[s.head] = make_component<linear_vccs>(
+            s.id, ts[0], ts[1], ts[2], ts[3], s.value);
+
+    for(auto&& [ts, s]: sources)
+      if(s.id != comps[s.head]->id())
+        comps[s.head] = make_component<dc_current>(s.id, ts[0], ts[1], s.value);
+
+    return erase_at(comps, gone);
+  }
+
+  size_t kron_reduce(component_list& comps, const node_set& pinned) {
+
+    //pure admittance stamps, carrying no state and no branch unknowns
+    const auto admittance = [](auto&& c) {
+      return dynamic_pointer_cast<linear_resistor>(c) ||
+             dynamic_pointer_cast<linear_vccs>(c);
+    };
+
+    const auto admissible = [&](auto&& c) {
+      return admittance(c) && !probed(*c, pinned);
+    };
+
+    //clusters of internal nodes tied together by admittances
+    const auto internal = eliminable(comps, pinned, admissible);
+    const auto inside = [&internal](const string& n) {
+      const auto it = internal.find(n);
+      return it != internal.end() && it->second;
+    };
+
+    const auto clusters = clusters_of(comps, admissible, inside);
+
+    set<size_t> gone;
+    component_list blocks;
+
+    for(auto&& [root, members]: clusters) {
+
+      //ports first, then the eliminated nodes
+      vector<string> ports, nodes;
+      map<string, size_t> index;
+      set<pair<size_t, size_t>> pattern;
+
+      for(auto i: members)
+        for(auto&& n: comps[i]->terminals())
+          if(n != "0" && !inside(n) && index.emplace(n, 0).second)
+            ports.push_back(n);
+      for(auto i: members)
+        for(auto&& n: comps[i]->terminals())
+          if(inside(n) && index.emplace(n, 0).second)
+            nodes.push_back(n);
+
+      const auto p = ports.size(), k = nodes.size();
+      for(size_t i = 0; i < p; ++i) index[ports[i]]   = i;
+      for(size_t i = 0; i < k; ++i) index[nodes[i]] = p + i;
+
+      dense::matrix Y{p + k, p + k};
+      const auto stamp = [&](const string& a, const string& b, double y) {
+        if(a == "0" || b == "0") return;
+        Y(index.at(a), index.at(b)) += y;
+        pattern.emplace(index.at(a), index.at(b));
+      };
+
+      for(auto i: members) {
+        const auto ts = comps[i]->terminals();
+        if(const auto r = dynamic_pointer_cast<linear_resistor>(comps[i])) {
+          const double G = r->function().conductance();
+          stamp(ts[0], ts[0],  G); stamp(ts[0], ts[1], -G);
+          stamp(ts[1], ts[0], -G); stamp(ts[1], ts[1],  G);
+        } else {
+          const double G = static_pointer_cast<linear_vccs>(comps[i])->function().gain();
+          stamp(ts[0], ts[2],  G); stamp(ts[0], ts[3], -G);
+          stamp(ts[1], ts[2], -G); stamp(ts[1], ts[3],  G);
+        }
+      }
+
+      //only worth it if the dense port block is no larger than the stamps
+      if(p*p > pattern.size()) continue;
+
+      dense::matrix Ybb{p, p}, Ybi{p, k}, Yib{k, p}, Yii{k, k};
+      for(size_t i = 0; i < p + k; ++i)
+        for(size_t j = 0; j < p + k; ++j) {
+          const auto y = Y(i, j);
+          if(i < p && j < p)  Ybb(i,   j)   = y;
+          if(i < p && j >= p) Ybi(i,   j-p) = y;
+          if(i >= p && j < p) Yib(i-p, j)   = y;
+          if(i >= p && j >= p) Yii(i-p, j-p) = y;
+        }
+
+      //internal voltages are -Yii^-1 Yib v, the rest is the Schur complement
+      auto X = Yib;
+      if(!dense::solve(Yii, X)) continue;
+
+      const auto Yred = Ybb - Ybi * X;
+
+      //cancellation leftovers are dropped from the pattern
+      auto scale = 0.0;
+      for(auto v: Y.data) scale = max(scale, abs(v));
+
+      vector<float> y(p*p);
+      for(size_t i = 0; i < p*p; ++i)
+        y[i] = abs(Yred.data[i]) > 1e-9*scale ? Yred.data[i] : 0.0;
+
+      vector<string> probes;
+      vector<float>  H;
+      for(size_t i = 0; i < k; ++i) {
+        if(!pinned.count(nodes[i])) continue;
+        probes.push_back(nodes[i]);
+        for(size_t j = 0; j < p; ++j) H.push_back(-X(i, j));
+      }
+
+      //dangling clusters vanish altogether
+      if(!probes.empty() || any_of(y.begin(), y.end(), [](auto v) { return v != 0.0f; }))
+        blocks.push_back(make_component<admittance_block>(
+              "Y@" + root, ports, make_shared<const vector<float>>(move(y)),
+              move(probes), make_shared<const vector<float>>(move(H))));
+
+      gone.insert(members.begin(), members.end());
+    }
+
+    erase_at(comps, gone);
+    comps.insert(comps.end(), blocks.begin(), blocks.end());
+
+    return gone.size();
+  }
+
+  size_t prima_reduce(component_list& comps, const node_set& pinned) {
+
+    const int    order = option(comps, "PRIMA_ORDER", 0.0f);
+    const double tol   = option(comps, "PRIMA_TOL",   0.0f);
+
+    //approximate, so only done when asked for
+    if(order <= 0 && tol <= 0.0) return 0;
+
+    //linear stamps, keeping probed branch currents and rebuilt probes out
+    const auto linear = [&pinned](auto&& c) {
+      if(probed(*c, pinned)) return false;
+      if(const auto y = dynamic_pointer_cast<admittance_block>(c))
+        return y->probes().empty();
+      return dynamic_pointer_cast<linear_resistor>(c) ||
+             trapezoidal_capacitance(*c) > 0.0f ||
+             trapezoidal_inductance(*c) > 0.0f;
+    };
+
+    //internal nodes are only touched by linear stamps and are not probed,
+    //everything else they connect to becomes a port
+    map<string, bool> internal;
+    for(auto&& c: comps) {
+      const auto ok = static_cast<bool>(linear(c));
+      for(auto&& n: c->terminals())
+        if(n != "0") {
+          const auto [it, _] = internal.emplace(n, !pinned.count(n));
+          it->second = it->second && ok;
+        }
+    }
+
+    const auto inside = [&internal](const string& n) {
+      const auto it = internal.find(n);
+      return it != internal.end() && it->second;
+    };
+
+    const auto clusters = clusters_of(comps, linear, inside);
+
+    //audio band check points, for the tolerance driven order
+    constexpr double s0 = 2.0 * M_PI * 1.0e3;
+    vector<double> band;
+    for(auto f = 20.0; f <= 20.0e3; f *= 2.0) band.push_back(2.0 * M_PI * f);
+
+    set<size_t> gone;
+    component_list blocks;
+
+    for(auto&& [root, members]: clusters) {
+
+      if(members.empty()) continue;
+
+      //ports, internal nodes, then inductor currents
+      vector<string> vars;
+      map<string, size_t> index;
+      for(auto pass: {0, 1})
+        for(auto i: members)
+          for(auto&& n: comps[i]->terminals())
+            if(n != "0" && inside(n) == pass && index.emplace(n, vars.size()).second)
+              vars.push_back(n);
+
+      const size_t p = count_if(vars.begin(), vars.end(),
+                                [&](auto&& n) { return !inside(n); });
+
+      for(auto i: members)
+        if(trapezoidal_inductance(*comps[i]) > 0.0f) {
+          index.emplace("@J" + comps[i]->id(), vars.size());
+          vars.push_back("@J" + comps[i]->id());
+        }
+
+      const auto n = vars.size();
+      if(p == 0 || n == p) continue;
+
+      dense::matrix G{n, n}, C{n, n};
+      const auto stamp = [&index](dense::matrix& M, const string& a,
+                                  const string& b, double y) {
+        if(a != "0" && b != "0") M(index.at(a), index.at(b)) += y;
+      };
+      const auto two = [&](dense::matrix& M, const string& a,
+                           const string& b, double y) {
+        stamp(M, a, a, y); stamp(M, a, b, -y);
+        stamp(M, b, a, -y); stamp(M, b, b, y);
+      };
+      const auto branch = [&](const string& a, const string& b,
+                              const string& j, double L) {
+        stamp(G, a, j,  1.0); stamp(G, b, j, -1.0);
+        stamp(G, j, a, -1.0); stamp(G, j, b,  1.0);
+        stamp(C, j, j, L);
+      };
+
+      for(auto i: members) {
+        const auto& c  = comps[i];
+        const auto  ts = c->terminals();
+        if(const auto r = dynamic_pointer_cast<linear_resistor>(c))
+          two(G, ts[0], ts[1], r->function().conductance());
+        else if(const auto y = dynamic_pointer_cast<admittance_block>(c)) {
+          const auto& ps = y->ports();
+          const auto& Y  = y->admittance();
+          for(size_t a = 0; a < ps.size(); ++a)
+            for(size_t b = 0; b < ps.size(); ++b)
+              stamp(G, ps[a], ps[b], Y[a*ps.size() + b]);
+        }
+        else if(const auto k = trapezoidal_capacitance(*c); k > 0.0f)
+          two(C, ts[0], ts[1], k);
+        else if(const auto l = trapezoidal_inductance(*c); l > 0.0f)
+          branch(ts[0], ts[1], "@J" + c->id(), l);
+      }
+
+      //block Krylov space of (G + s0 C)^-1 C, starting from the ports
+      dense::matrix M{n, n};
+      for(size_t k = 0; k < n*n; ++k) M.data[k] = G.data[k] + s0*C.data[k];
+
+      dense::matrix X{n, p};
+      for(size_t i = 0; i < p; ++i) X(i, i) = 1.0;
+      if(!dense::solve(M, X)) continue;
+
+      //port preserving projection: V = diag(I, W), W spans the internal rows
+      const auto ki = n - p;
+      dense::matrix Q{n, 0}, W{ki, 0};
+
+      const auto project = [&](const dense::matrix& A) {
+        dense::matrix V{n, p + W.cols};
+        for(size_t i = 0; i < p; ++i) V(i, i) = 1.0;
+        for(size_t i = 0; i < ki; ++i)
+          for(size_t j = 0; j < W.cols; ++j) V(p + i, p + j) = W(i, j);
+        return dense::transpose(V) * A * V;
+      };
+
+      //port impedances B^T (G + sC)^-1 B, B selecting the ports
+      const auto impedance = [p](const dense::matrix& G, const dense::matrix& C,
+                                 double s) {
+        const auto m = G.rows;
+        dense::complex_matrix A{m, m}, Z{m, p};
+        for(size_t k = 0; k < m*m; ++k) A.data[k] = {G.data[k], s*C.data[k]};
+        for(size_t i = 0; i < p; ++i) Z(i, i) = 1.0;
+        dense::solve(A, Z);
+        Z.rows = p;
+        Z.data.resize(p*p);
+        return Z;
+      };
+
+      vector<dense::complex_matrix> full;
+      if(order <= 0)
+        for(auto s: band) full.push_back(impedance(G, C, s));
+
+      dense::matrix Gr, Cr;
+      auto good = false;
+
+      for(int it = 0; it < (order > 0 ? order : int(ki)); ++it) {
+
+        const auto before = Q.cols;
+        dense::orthonormalize(Q, X);
+        if(Q.cols == before) break; //Krylov space exhausted
+
+        dense::matrix Xi{ki, Q.cols - before};
+        for(size_t i = 0; i < ki; ++i)
+          for(size_t j = before; j < Q.cols; ++j)
+            Xi(i, j - before) = Q(p + i, j);
+        dense::orthonormalize(W, Xi);
+
+        if(W.cols >= ki) break;
+
+        //next block
+        dense::matrix Qj{n, Q.cols - before};
+        for(size_t i = 0; i < n; ++i)
+          for(size_t j = before; j < Q.cols; ++j)
+            Qj(i, j - before) = Q(i, j);
+        X = C * Qj;
+        if(!dense::solve(M, X)) break;
+
+        if(order > 0) continue;
+
+        //relative error against the full model across the band
+        Gr = project(G);
+        Cr = project(C);
+        auto err = 0.0;
+        for(size_t f = 0; f < band.size(); ++f) {
+          const auto Zr = impedance(Gr, Cr, band[f]);
+          auto num = 0.0, den = 0.0;
+          for(size_t k = 0; k < Zr.data.size(); ++k) {
+            num = max(num, abs(Zr.data[k] - full[f].data[k]));
+            den = max(den, abs(full[f].data[k]));
+          }
+          err = max(err, num / den);
+        }
+        if(err <= tol) { good = true; break; }
+      }
+
+      if(order > 0) {
+        Gr = project(G);
+        Cr = project(C);
+        good = true;
+      }
+
+      //not worth it, or not accurate enough before running out of space
+      if(!good || W.cols >= ki) continue;
+
+      const auto m = Gr.rows;
+      vector<float> g(m*m), c(m*m);
+      for(size_t k = 0; k < m*m; ++k) {
+        g[k] = Gr.data[k];
+        c[k] = Cr.data[k];
+      }
+
+      vector<string> ports(vars.begin(), vars.begin() + p);
+      blocks.push_back(make_component<reduced_block>(
+            "P@" + root, move(ports), W.cols,
+            make_shared<const vector<float>>(move(g)),
+            make_shared<const vector<float>>(move(c))));
+
+      gone.insert(members.begin(), members.end());
+    }
+
+    erase_at(comps, gone);
+    comps.insert(comps.end(), blocks.begin(), blocks.end());
+
+    return gone.size();
+  }
+
+  size_t expm_discretize(component_list& comps, const node_set& pinned) {
+
+    if(option(comps, "EXPM", 0.0f) == 0.0f) return 0;
+
+    const auto reactive = [](auto&& c) {
+      return capacitance(*c) > 0.0f || inductance(*c) > 0.0f;
+    };
+
+    //linear stamps, keeping probed branch currents and rebuilt probes out
+    const auto linear = [&](auto&& c) {
+      if(probed(*c, pinned)) return false;
+      if(const auto y = dynamic_pointer_cast<admittance_block>(c))
+        return y->probes().empty();
+      return dynamic_pointer_cast<linear_resistor>(c) ||
+             dynamic_pointer_cast<linear_vccs>(c)     ||
+             reactive(c);
+    };
+
+    const auto internal = eliminable(comps, pinned, linear);
+    const auto inside = [&internal](const string& n) {
+      const auto it = internal.find(n);
+      return it != internal.end() && it->second;
+    };
+
+    auto clusters = clusters_of(comps, linear, inside);
+
+    //an inductor between ports is a cluster of its own, a capacitor there
+    //would draw C u' from the ports and stays as it is
+    for(size_t i = 0; i < comps.size(); ++i) {
+      const auto ts = comps[i]->terminals();
+      if(linear(comps[i]) && inductance(*comps[i]) > 0.0f &&
+         none_of(ts.begin(), ts.end(), inside))
+        clusters["#" + comps[i]->id()].push_back(i);
+    }
+
+    set<size_t> gone;
+    component_list blocks;
+
+    for(auto&& [root, members]: clusters) {
+
+      if(none_of(members.begin(), members.end(),
+                 [&](auto i) { return reactive(comps[i]); })) continue;
+
+      //ports, then internal nodes
+      vector<string> ports, nodes;
+      map<string, size_t> index;
+      for(auto pass: {false, true})
+        for(auto i: members)
+          for(auto&& n: comps[i]->terminals())
+            if(n != "0" && inside(n) == pass && index.emplace(n, 0).second)
+              (pass ? nodes : ports).push_back(n);
+
+      const auto p = ports.size(), k = nodes.size();
+      for(size_t i = 0; i < p; ++i) index[ports[i]] = i;
+      for(size_t i = 0; i < k; ++i) index[nodes[i]] = p + i;
+
+      //conductances, then the reactive branches, a to b
+      dense::matrix Y{p + k, p + k};
+      const auto stamp = [&](const string& a, const string& b, double y) {
+        if(a != "0" && b != "0") Y(index.at(a), index.at(b)) += y;
+      };
+
+      vector<tuple<string, string, double>> caps, coils;
+
+      for(auto i: members) {
+        const auto& c  = comps[i];
+        const auto  ts = c->terminals();
+        if(const auto r = dynamic_pointer_cast<linear_resistor>(c)) {
+          const double G = r->function().conductance();
+          stamp(ts[0], ts[0],  G); stamp(ts[0], ts[1], -G);
+          stamp(ts[1], ts[0], -G); stamp(ts[1], ts[1],  G);
+        }
+        else if(const auto g = dynamic_pointer_cast<linear_vccs>(c)) {
+          const double G = g->function().gain();
+          stamp(ts[0], ts[2],  G); stamp(ts[0], ts[3], -G);
+          stamp(ts[1], ts[2], -G); stamp(ts[1], ts[3],  G);
+        }
+        else if(const auto y = dynamic_pointer_cast<admittance_block>(c)) {
+          const auto& ps = y->ports();
+          const auto& A  = y->admittance();
+          for(size_t a = 0; a < ps.size(); ++a)
+            for(size_t b = 0; b < ps.size(); ++b)
+              stamp(ps[a], ps[b], A[a*ps.size() + b]);
+        }
+        else if(const auto C = capacitance(*c); C > 0.0f)
+          caps.emplace_back(ts[0], ts[1], C);
+        else
+          coils.emplace_back(ts[0], ts[1], inductance(*c));
+      }
+
+      //states are the capacitor voltages and the inductor currents, z is
+      //[x; u]. the resistive network, with capacitors as voltage sources and
+      //inductors as current sources, gives w = [internal voltages;
+      //capacitor currents] as W z, from M w = R z
+      const auto nc = caps.size(), n = nc + coils.size();
+
+      dense::matrix M{k + nc, k + nc}, W{k + nc, n + p};
+
+      for(size_t i = 0; i < k; ++i)
+        for(size_t j = 0; j < p + k; ++j)
+          if(j < p) W(i, n + j) -= Y(p + i, j);
+          else      M(i, j - p)  = Y(p + i, j);
+
+      //sign of a node in a branch, and where its voltage comes from
+      const auto incident = [&](const string& t, double s, auto&& internal_row,
+                                auto&& port_column) {
+        if(t == "0") return;
+        const auto j = index.at(t);
+        if(j >= p) internal_row(j - p, s);
+        else       port_column(j, s);
+      };
+
+      for(size_t c = 0; c < nc; ++c) {
+        const auto& [a, b, C] = caps[c];
+        for(auto&& [t, s]: {pair{a, 1.0}, pair{b, -1.0}})
+          incident(t, s,
+              [&](size_t i, double s) { M(i, k + c) += s; M(k + c, i) += s; },
+              [&](size_t j, double s) { W(k + c, n + j) -= s; });
+        W(k + c, c) = 1.0;
+      }
+
+      for(size_t l = 0; l < coils.size(); ++l) {
+        const auto& [a, b, L] = coils[l];
+        for(auto&& [t, s]: {pair{a, 1.0}, pair{b, -1.0}})
+          incident(t, s, [&](size_t i, double s) { W(i, nc + l) -= s; },
+                         [](size_t, double) {});
+      }
+
+      //capacitor loops and inductor cutsets leave the network singular
+      if(!dense::solve(M, W)) continue;
+
+      //any voltage of the cluster, as a row on z
+      const auto voltage = [&](const string& t) {
+        vector<double> v(n + p, 0.0);
+        if(t == "0") return v;
+        const auto j = index.at(t);
+        if(j < p) v[n + j] = 1.0;
+        else for(size_t i = 0; i < n + p; ++i) v[i] = W(j - p, i);
+        return v;
+      };
+
+      auto model = make_shared<state_space>();
+      model->n = n;
+      model->p = p;
+      model->F = dense::matrix{n, n + p};
+      model->Y = dense::matrix{p, n + p};
+
+      for(size_t c = 0; c < nc; ++c)
+        for(size_t i = 0; i < n + p; ++i)
+          model->F(c, i) = W(k + c, i) / get<2>(caps[c]);
+
+      for(size_t l = 0; l < coils.size(); ++l) {
+        const auto& [a, b, L] = coils[l];
+        const auto va = voltage(a), vb = voltage(b);
+        for(size_t i = 0; i < n + p; ++i) model->F(nc + l, i) = (va[i] - vb[i]) / L;
+      }
+
+      //port currents, through the conductances and the reactive branches
+      for(size_t r = 0; r < p; ++r)
+        for(size_t j = 0; j < p + k; ++j) {
+          if(Y(r, j) == 0.0) continue;
+          const auto v = voltage(j < p ? ports[j] : nodes[j - p]);
+          for(size_t i = 0; i < n + p; ++i) model->Y(r, i) += Y(r, j)*v[i];
+        }
+
+      const auto branch = [&](const string& t, double s, const vector<double>& i) {
+        if(t == "0" || index.at(t) >= p) return;
+        for(size_t j = 0; j < n + p; ++j) model->Y(index.at(t), j) += s*i[j];
+      };
+
+      for(size_t c = 0; c < nc; ++c) {
+        vector<double> i(n + p);
+        for(size_t j = 0; j < n + p; ++j) i[j] = W(k + c, j);
+        branch(get<0>(caps[c]),  1.0, i);
+        branch(get<1>(caps[c]), -1.0, i);
+      }
+
+      for(size_t l = 0; l < coils.size(); ++l) {
+        vector<double> i(n + p, 0.0);
+        i[nc + l] = 1.0;
+        branch(get<0>(coils[l]),  1.0, i);
+        branch(get<1>(coils[l]), -1.0, i);
+      }
+
+      vector<string> probes;
+      for(auto&& t: nodes)
+        if(pinned.count(t)) probes.push_back(t);
+
+      model->H = dense::matrix{probes.size(), n + p};
+      for(size_t q = 0; q < probes.size(); ++q) {
+        const auto v = voltage(probes[q]);
+        for(size_t i = 0; i < n + p; ++i) model->H(q, i) = v[i];
+      }
+
+      blocks.push_back(make_component<exponential_block>(
+            "E@" + root, move(ports), move(probes), move(model)));
+
+      gone.insert(members.begin(), members.end());
+    }
+
+    erase_at(comps, gone);
+    comps.insert(comps.end(), blocks.begin(), blocks.end());
+
+    return gone.size();
+  }
+
+  size_t batch_fets(component_list& comps, const node_set&) {
+
+    vector<fet_device> devices;
+    string id;
+    set<size_t> gone;
+
+    for(size_t i = 0; i < comps.size(); ++i)
+      if(const auto f = dynamic_pointer_cast<fet_array>(comps[i])) {
+        devices.insert(devices.end(), f->devices().begin(), f->devices().end());
+        id += (gone.empty() ? "" : "+") + f->id();
+        gone.insert(i);
+      }
+
+    if(gone.size() < 2) return 0;
+
+    const auto removed = erase_at(comps, gone);
+    comps.push_back(make_component<fet_array>(id, move(devices)));
+    return removed;
+  }
+
+  size_t couple_inductors(component_list& comps, const node_set&,
+                          vector<string>& log) {
+
+    //inductors by id, with their value
+    map<string, pair<size_t, double>> inductors;
+    for(size_t i = 0; i < comps.size(); ++i)
+      if(const auto L = inductance(*comps[i]); L > 0.0f)
+        inductors.emplace(comps[i]->id(), pair{i, double{L}});
+
+    map<string, string> parent;
+    const auto find = [&parent](string n) {
+      parent.emplace(n, n);
+      while(parent[n] != n) n = parent[n] = parent[parent[n]];
+      return n;
+    };
+
+    set<size_t> gone;
+    vector<shared_ptr<inductor_coupling>> couplings;
+
+    for(size_t i = 0; i < comps.size(); ++i)
+      if(const auto k = dynamic_pointer_cast<inductor_coupling>(comps[i])) {
+        gone.insert(i);
+        //netlist_builder rejects cards naming unknown inductors, but the
+        //pass takes any list
+        if(!inductors.count(k->first()) || !inductors.count(k->second())) {
+          log.push_back("coupling: " + k->id() + " names no inductor, dropped");
+          continue;
+        }
+        if(std::abs(k->coefficient()) > 0.9999f)
+          log.push_back("coupling: " + k->id() + " clamped to 0.9999");
+        parent[find(k->first())] = find(k->second());
+        couplings.push_back(k);
+      }
+
+    if(gone.empty()) return 0;
+
+    map<string, vector<string>> groups;
+    for(auto&& [id, _]: inductors)
+      if(parent.count(id)) groups[find(id)].push_back(id);
+
+    component_list blocks;
+
+    for(auto&& [root, members]: groups) {
+
+      const auto n = members.size();
+
+      map<string, size_t> index;
+      for(size_t k = 0; k < n; ++k) index[members[k]] = k;
+
+      //M = k sqrt(La Lb), perfect coupling would leave L singular
+      dense::matrix L{n, n}, Gamma{n, n};
+      for(size_t k = 0; k < n; ++k) {
+        L(k, k) = inductors.at(members[k]).second;
+        Gamma(k, k) = 1.0;
+      }
+      for(auto&& c: couplings) {
+        if(find(c->first()) != root) continue;
+        const auto a = index.at(c->first()), b = index.at(c->second());
+        const auto k = clamp<double>(c->coefficient(), -0.9999, 0.9999);
+        L(a, b) = L(b, a) = k*sqrt(L(a, a)*L(b, b));
+      }
+
+      string id;
+      for(auto&& m: members) id += (id.empty() ? "" : "+") + m;
+
+      if(!dense::solve(L, Gamma)) {
+        log.push_back("coupling: " + id + " has a singular L, left uncoupled");
+        continue;
+      }
+
+      vector<string> na, nb;
+      for(auto&& m: members) {
+        const auto i = inductors.at(m).first;
+        const auto ts = comps[i]->terminals();
+        na.push_back(ts[0]);
+        nb.push_back(ts[1]);
+        gone.insert(i);
+      }
+
+      auto stamp = make_shared<vector<float>>(Gamma.data.begin(), Gamma.data.end());
+
+      blocks.push_back(make_component<coupled_inductors>(
+            "K(" + id + ")", members, move(na), move(nb), move(stamp)));
+    }
+
+    const auto removed = erase_at(comps, gone);
+    comps.insert(comps.end(), blocks.begin(), blocks.end());
+    return removed;
+  }
+
+}		// -----  end of namespace rtspice::circuit::passes  -----
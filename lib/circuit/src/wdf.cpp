@@ -0,0 +1,730 @@
+/*!
+ *    @file  wdf.cpp
+ *   @brief wave digital filter engine implementation
+ *
+ *  @author  Thadeu Luiz Barbosa Dias (tlbd)
+ *
+ *  @internal
+ *       Created:  10/18/2026
+ *      Revision:  none
+ *      Compiler:  g++
+ *  Organization:  SMT - Signals, Multimedia and Telecommunications Lab
+ *     Copyright:  Copyright (c) 2019, Thadeu Luiz Barbosa Dias
+ *
+ *  This source code is released for free distribution under the terms of the
+ *  GNU General Public License as published by the Free Software Foundation.
+ */
+
+#include "wdf.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+#include "resistor.hpp"
+#include "sources.hpp"
+#include "dynamic.hpp"
+#include "probe.hpp"
+#include "potentiometer.hpp"
+
+using namespace std;
+
+namespace rtspice::circuit::wdf {
+
+  using namespace components;
+
+  namespace {
+
+    //ADAA divided differences closer than this fall back to midpoints
+    constexpr double eps = 1e-5;
+
+    //grid of the integral of I^2, for the second order
+    constexpr double q_step = 2.5e-4, q_range = 2.0;
+
+    double hermite(double t, double h, double y0, double y1, double d0, double d1) {
+      const auto t2 = t*t, t3 = t2*t;
+      return (2*t3 - 3*t2 + 1)*y0 + (t3 - 2*t2 + t)*h*d0 +
+             (3*t2 - 2*t3)*y1 + (t3 - t2)*h*d1;
+    }
+
+    //a wave digital voltage source reflects its value, so any voltage
+    //source with a readable value qualifies
+    template<class S>
+    function<float()> reader(const component::ptr& c) {
+      if(const auto s = dynamic_pointer_cast<S>(c))
+        return [s] { return s->function()(); };
+      return {};
+    }
+
+    //in place, row major, false if singular
+    bool invert(vector<double>& A, size_t m) {
+
+      vector<size_t> perm(m);
+      for(size_t i = 0; i < m; ++i) perm[i] = i;
+
+      for(size_t k = 0; k < m; ++k) {
+
+        auto piv = k;
+        for(auto i = k + 1; i < m; ++i)
+          if(std::abs(A[i*m + k]) > std::abs(A[piv*m + k])) piv = i;
+        if(A[piv*m + k] == 0.0) return false;
+
+        if(piv != k) {
+          swap_ranges(A.begin() + k*m, A.begin() + (k+1)*m, A.begin() + piv*m);
+          swap(perm[k], perm[piv]);
+        }
+
+        //Gauss-Jordan, the inverse builds up in the eliminated columns
+        const auto d = 1.0/A[k*m + k];
+        A[k*m + k] = 1.0;
+        for(size_t j = 0; j < m; ++j) A[k*m + j] *= d;
+
+        for(size_t i = 0; i < m; ++i) {
+          if(i == k) continue;
+          const auto f = A[i*m + k];
+          A[i*m + k] = 0.0;
+          for(size_t j = 0; j < m; ++j) A[i*m + j] -= f*A[k*m + j];
+        }
+      }
+
+      //undo the row swaps on the columns of the inverse
+      vector<double> B(m*m);
+      for(size_t i = 0; i < m; ++i)
+        for(size_t j = 0; j < m; ++j)
+          B[i*m + perm[j]] = A[i*m + j];
+      A = move(B);
+
+      return true;
+    }
+
+  }
+
+  unique_ptr<tree> tree::build(const component_list& comps, string& why) {
+
+    auto t = unique_ptr<tree>{ new tree };
+
+    map<string, size_t> index;
+    const auto node = [&](const string& n) {
+      const auto [it, added] = index.emplace(n, t->nodes_.size());
+      if(added) t->nodes_.push_back(n);
+      return it->second;
+    };
+
+    struct edge { size_t u, v, e; };
+    vector<edge> edges;
+
+    const auto leaf = [&](kind k, const string& a, const string& b, float value,
+                          function<float()> source = {}) {
+      element e{};
+      e.k      = k;
+      e.value  = value;
+      e.p      = node(a);
+      e.n      = node(b);
+      e.source = move(source);
+      edges.push_back({ e.p, e.n, t->tree_.size() });
+      t->tree_.push_back(move(e));
+    };
+
+    vector<tuple<const diode_resistance*, string, string>> diodes;
+
+    for(auto&& c: comps) {
+
+      const auto ts = c->terminals();
+      if(ts.empty() || dynamic_pointer_cast<probe>(c)) continue;
+
+      t->held_.push_back(c);
+
+      if(const auto r = dynamic_pointer_cast<linear_resistor>(c))
+        leaf(kind::resistor, ts[0], ts[1], 1.0f/r->function().conductance());
+      else if(const auto p = dynamic_pointer_cast<potentiometer>(c)) {
+        const auto pos = p->position();
+        const auto [G1, G2] = p->conductances(pos);
+        t->knobs_.push_back({ p.get(), pos, t->tree_.size(), t->tree_.size() + 1 });
+        leaf(kind::resistor, ts[0], ts[1], 1.0f/G1);
+        leaf(kind::resistor, ts[1], ts[2], 1.0f/G2);
+      }
+      else if(const auto C = trapezoidal_capacitance(*c); C > 0.0f)
+        leaf(kind::capacitor, ts[0], ts[1], C);
+      else if(const auto L = trapezoidal_inductance(*c); L > 0.0f)
+        leaf(kind::inductor, ts[0], ts[1], L);
+      else if(const auto d = dynamic_pointer_cast<basic_diode>(c))
+        diodes.emplace_back(&d->function(), ts[0], ts[1]);
+      else if(const auto f = dynamic_pointer_cast<fixed_voltage>(c))
+        leaf(kind::source, ts[0], ts[1], 0.0f, [V = f->value()] { return V; });
+      else if(auto s = reader<dc_voltage>(c); s ||
+              (s = reader<ac_voltage>(c)) || (s = reader<ext_voltage>(c)))
+        leaf(kind::source, ts[0], ts[1], 0.0f, move(s));
+      else {
+        why = c->id() + " has no wave digital model";
+        return nullptr;
+      }
+    }
+
+    if(!index.count("0")) {
+      why = "nothing is grounded";
+      return nullptr;
+    }
+    t->ground_ = index.at("0");
+
+    //the root: the diodes, all across the same nodes, or a source
+    size_t rp, rn;
+
+    if(!diodes.empty()) {
+      const auto& [_, a, b] = diodes.front();
+      rp = node(a);
+      rn = node(b);
+      for(auto&& [f, na, nb]: diodes) {
+        const auto p = node(na), n = node(nb);
+        if(p == rp && n == rn)      t->diodes_.emplace_back(f, 1.0f);
+        else if(p == rn && n == rp) t->diodes_.emplace_back(f, -1.0f);
+        else {
+          why = "nonlinear devices across more than one port";
+          return nullptr;
+        }
+      }
+
+      for(auto&& [d, _]: t->diodes_) t->adaa_ = max(t->adaa_, d->model()->ADAA);
+
+      //I^2 and its integral from 0, Simpson on each step, for the second order
+      if(t->adaa_ == 2) {
+
+        const auto I2 = [&](double v) { const auto I = t->junction_(v).I; return I*I; };
+        const auto n  = static_cast<size_t>(q_range/q_step);
+
+        t->Q_table_.assign(2*n + 1, 0.0);
+        t->I2_table_.resize(2*n + 1);
+
+        for(size_t k = 0; k <= 2*n; ++k)
+          t->I2_table_[k] = I2((double(k) - n)*q_step);
+
+        for(size_t k = n; k < 2*n; ++k) {
+          const auto v = (double(k) - n)*q_step;
+          t->Q_table_[k+1] = t->Q_table_[k] + q_step/6.0*
+            (t->I2_table_[k] + 4.0*I2(v + 0.5*q_step) + t->I2_table_[k+1]);
+        }
+        for(size_t k = n; k > 0; --k) {
+          const auto v = (double(k) - n)*q_step;
+          t->Q_table_[k-1] = t->Q_table_[k] - q_step/6.0*
+            (t->I2_table_[k] + 4.0*I2(v - 0.5*q_step) + t->I2_table_[k-1]);
+        }
+      }
+    } else {
+      const auto it = find_if(edges.begin(), edges.end(), [&](auto&& e) {
+            return t->tree_[e.e].k == kind::source;
+          });
+      if(it == edges.end()) {
+        why = "nothing drives the circuit";
+        return nullptr;
+      }
+      rp = it->u;
+      rn = it->v;
+      t->root_source_ = t->tree_[it->e].source;
+      edges.erase(it);
+    }
+
+    const auto adaptor = [&](kind k, size_t p, size_t n, vector<child> cs) {
+      element e{};
+      e.k     = k;
+      e.p     = p;
+      e.n     = n;
+      e.first = t->children_.size();
+      t->children_.insert(t->children_.end(), cs.begin(), cs.end());
+      e.last  = t->children_.size();
+      t->tree_.push_back(move(e));
+      return t->tree_.size() - 1;
+    };
+
+    //series-parallel reduction of everything but the root, down to one port
+    //across the root nodes
+    for(auto reduced = true; reduced && edges.size() > 1;) {
+
+      reduced = false;
+
+      //parallel: every edge across the same pair of nodes
+      for(size_t i = 0; i < edges.size() && !reduced; ++i) {
+        const auto [u, v, _] = edges[i];
+        vector<child> cs;
+        vector<size_t> gone;
+        for(size_t j = i; j < edges.size(); ++j) {
+          const auto& e = edges[j];
+          if((e.u == u && e.v == v) || (e.u == v && e.v == u)) {
+            cs.push_back({ e.e, e.u == u ? 1.0f : -1.0f });
+            gone.push_back(j);
+          }
+        }
+        if(cs.size() < 2) continue;
+        for(auto j = gone.rbegin(); j != gone.rend(); ++j) edges.erase(edges.begin() + *j);
+        edges.push_back({ u, v, adaptor(kind::parallel, u, v, move(cs)) });
+        reduced = true;
+      }
+
+      //series: a node other than the root ones, touched by two edges
+      for(size_t k = 0; k < t->nodes_.size() && !reduced; ++k) {
+
+        if(k == rp || k == rn) continue;
+
+        vector<size_t> at;
+        for(size_t j = 0; j < edges.size(); ++j)
+          if(edges[j].u == k || edges[j].v == k) at.push_back(j);
+
+        if(at.size() == 1) {
+          why = "node " + t->nodes_[k] + " is dangling";
+          return nullptr;
+        }
+        if(at.size() != 2) continue;
+
+        const auto e1 = edges[at[0]], e2 = edges[at[1]];
+        const auto u = e1.u == k ? e1.v : e1.u;
+        const auto w = e2.u == k ? e2.v : e2.u;
+        if(u == k || w == k) continue; //loops are left to the parallel rule
+
+        vector<child> cs{ { e1.e, e1.v == k ? 1.0f : -1.0f },
+                          { e2.e, e2.u == k ? 1.0f : -1.0f } };
+
+        edges.erase(edges.begin() + at[1]);
+        edges.erase(edges.begin() + at[0]);
+        edges.push_back({ u, w, adaptor(kind::series, u, w, move(cs)) });
+        reduced = true;
+      }
+    }
+
+    //what is left, such as a bridge, is one R-type adaptor across the root
+    if(edges.size() > 1) {
+
+      scattering r;
+      map<size_t, int> local;
+      const auto at = [&](size_t k) {
+        if(k == rn) return -1;
+        const auto [it, added] = local.emplace(k, int(r.nodes.size()));
+        if(added) r.nodes.push_back(k);
+        return it->second;
+      };
+
+      r.p = at(rp);
+      vector<child> cs;
+      for(auto&& e: edges) {
+        r.branches.emplace_back(at(e.u), at(e.v));
+        cs.push_back({ e.e, 1.0f });
+      }
+
+      t->waves_.resize(cs.size() + 1);
+      t->rtypes_.push_back(move(r));
+
+      const auto e = adaptor(kind::rtype, rp, rn, move(cs));
+      t->tree_[e].r = t->rtypes_.size() - 1;
+
+      edges.assign(1, { rp, rn, e });
+    }
+
+    if(edges.size() != 1 ||
+       !((edges[0].u == rp && edges[0].v == rn) || (edges[0].u == rn && edges[0].v == rp))) {
+      why = "nothing connects to its root";
+      return nullptr;
+    }
+
+    //a one port parallel adaptor reversing the top, if needed
+    if(edges[0].u != rp)
+      adaptor(kind::parallel, rp, rn, { { edges[0].e, -1.0f } });
+
+    //node voltages, from the top down: in a series adaptor each child shares
+    //a node with the previous one, starting from the adaptor NODE+
+    vector<bool> known(t->nodes_.size(), false);
+    const auto top = t->tree_.size() - 1;
+    known[t->tree_[top].n] = true;
+    t->walk_.push_back({ t->tree_[top].p, t->tree_[top].n, top, 1.0f });
+    known[t->tree_[top].p] = true;
+
+    for(auto e = t->tree_.size(); e-- > 0;) {
+      const auto& x = t->tree_[e];
+      if(x.k == kind::rtype) {
+        //the branches of a bridge, each from a node already reached
+        for(auto grown = true; grown;) {
+          grown = false;
+          for(auto c = x.first; c < x.last; ++c) {
+            const auto& y = t->tree_[t->children_[c].e];
+            if(known[y.n] == known[y.p]) continue;
+            if(known[y.p]) t->walk_.push_back({ y.n, y.p, t->children_[c].e, -1.0f });
+            else           t->walk_.push_back({ y.p, y.n, t->children_[c].e,  1.0f });
+            known[y.n] = known[y.p] = grown = true;
+          }
+        }
+        continue;
+      }
+      if(x.k != kind::series && x.k != kind::parallel) continue;
+      for(auto c = x.first; c < x.last; ++c) {
+        const auto& y = t->tree_[t->children_[c].e];
+        if(!known[y.n]) t->walk_.push_back({ y.n, y.p, t->children_[c].e, -1.0f });
+        if(!known[y.p]) t->walk_.push_back({ y.p, y.n, t->children_[c].e,  1.0f });
+        known[y.n] = known[y.p] = true;
+      }
+    }
+
+    t->potentials_.assign(t->nodes_.size(), 0.0f);
+    t->resize_(1.0f);
+
+    //adaptors need a resistance on every port
+    for(auto&& e: t->tree_)
+      if(e.k == kind::parallel || e.k == kind::rtype)
+        for(auto c = e.first; c < e.last; ++c)
+          if(t->tree_[t->children_[c].e].R == 0.0f) {
+            why = e.k == kind::parallel ? "voltage source in parallel"
+                                        : "voltage source inside a bridge";
+            return nullptr;
+          }
+
+    for(auto&& e: t->tree_)
+      if(e.k == kind::rtype && e.R == 0.0f) {
+        why = "a node floats inside a bridge";
+        return nullptr;
+      }
+
+    if(t->tree_[top].R == 0.0f) {
+      why = "the root sees no resistance";
+      return nullptr;
+    }
+
+    return t;
+  }
+
+  void tree::resize_(float delta_t) {
+
+    delta_t_ = delta_t;
+
+    for(auto&& e: tree_) {
+      switch(e.k) {
+        case kind::resistor:  e.R = e.value;                 break;
+        case kind::capacitor:
+        case kind::inductor: {
+          const auto R = e.k == kind::capacitor ? 0.5f*delta_t/e.value
+                                                : 2.0f*e.value/delta_t;
+          //keep the last voltage and current, v + R i under the new step
+          if(e.R > 0.0f) e.state = 0.5f*(e.a + e.b) + 0.5f*(e.a - e.b)*R/e.R;
+          e.R = R;
+          break;
+        }
+        case kind::source:    e.R = 0.0f;                    break;
+        case kind::series: {
+          auto R = 0.0f;
+          for(auto c = e.first; c < e.last; ++c) R += tree_[children_[c].e].R;
+          e.R = R;
+          for(auto c = e.first; c < e.last; ++c)
+            children_[c].gamma = R > 0.0f ? tree_[children_[c].e].R/R : 0.0f;
+          break;
+        }
+        case kind::parallel: {
+          auto G = 0.0f;
+          for(auto c = e.first; c < e.last; ++c) G += 1.0f/tree_[children_[c].e].R;
+          e.R = 1.0f/G;
+          for(auto c = e.first; c < e.last; ++c)
+            children_[c].gamma = e.R/tree_[children_[c].e].R;
+          break;
+        }
+        case kind::rtype:
+          if(!scatter_(e)) e.R = 0.0f;
+          break;
+      }
+    }
+
+    //the antiderivatives move with the root port resistance
+    if(adaa_ == 1) G1a1_ = G1_(a1_);
+    if(adaa_ == 2) {
+      G2a1_ = G2_(a1_);
+      D12_  = D_(a1_, a2_);
+    }
+  }
+
+  bool tree::scatter_(element& e) {
+
+    auto& s = rtypes_[e.r];
+    const auto m = s.nodes.size(), N = e.last - e.first;
+
+    //nodal conductances of the children, n grounded
+    vector<double> Z(m*m, 0.0), G(N);
+    for(size_t j = 0; j < N; ++j) {
+      const auto R = tree_[children_[e.first + j].e].R;
+      if(R <= 0.0f) return false;
+      G[j] = 1.0/R;
+      const auto [x, y] = s.branches[j];
+      if(x >= 0) Z[x*m + x] += G[j];
+      if(y >= 0) Z[y*m + y] += G[j];
+      if(x >= 0 && y >= 0) {
+        Z[x*m + y] -= G[j];
+        Z[y*m + x] -= G[j];
+      }
+    }
+    if(!invert(Z, m)) return false;
+
+    const auto z = [&](int i, int j) { return i < 0 || j < 0 ? 0.0 : Z[i*m + j]; };
+
+    //voltage across child k per unit current into node q
+    const auto d = [&](size_t k, int q) {
+      return z(s.branches[k].first, q) - z(s.branches[k].second, q);
+    };
+
+    //each child is its wave b behind its port resistance. with the top
+    //port open, b0 = sum w_j b_j, and the current it then lets in moves
+    //child k by c_k per ampere
+    const auto R0 = z(s.p, s.p);
+    if(!(R0 > 0.0)) return false;
+
+    vector<double> c(N), w(N);
+    for(size_t k = 0; k < N; ++k) {
+      c[k] = d(k, s.p);
+      w[k] = G[k]*c[k];
+    }
+
+    //a_k = 2 v_k - b_k, with i0 = (a0 - b0)/2 R0
+    s.S.assign((N + 1)*(N + 1), 0.0f);
+    for(size_t j = 0; j < N; ++j) s.S[j + 1] = w[j];
+    for(size_t k = 0; k < N; ++k) {
+      auto row = s.S.begin() + (k + 1)*(N + 1);
+      row[0] = c[k]/R0;
+      for(size_t j = 0; j < N; ++j) {
+        const auto [x, y] = s.branches[j];
+        row[j + 1] = 2.0*G[j]*(d(k, x) - d(k, y)) - c[k]*w[j]/R0 - (k == j);
+      }
+    }
+
+    e.R = R0;
+    return true;
+  }
+
+  tree::junction tree::junction_(double v) const noexcept {
+
+    junction j{ 0.0, 0.0, 0.0, 0.0 };
+
+    for(auto&& [d, s]: diodes_) {
+      const auto& m = *d->model();
+      const auto x = s*v;
+      if(m.PWL) {
+        const auto [f, df] = (*d)(x);
+        j.I += s*f;
+        j.G += df;
+      } else {
+        j.I  += s*m.j(x);
+        j.G  += m.dj(x);
+        j.J  += m.J1(x);
+        j.J2 += s*m.J2(x);
+      }
+    }
+
+    return j;
+  }
+
+  double tree::solve_(double a) const noexcept {
+
+    //I(v) = (a - v)/R, by Newton from the last v
+    const auto R = tree_.back().R;
+    auto v = v_root_;
+
+    for(int i = 0; i < 100; ++i) {
+      const auto j  = junction_(v);
+      const auto dv = (j.I - (a - v)/R)/(j.G + 1.0/R);
+      v -= dv;
+      if(std::abs(dv) <= 1e-12 + 1e-9*std::abs(v)) break;
+    }
+
+    return v;
+  }
+
+  double tree::Q_(double v) const noexcept {
+
+    const auto I2 = [&](double x) { const auto I = junction_(x).I; return I*I; };
+
+    const auto n = static_cast<double>(Q_table_.size()/2);
+    const auto x = std::clamp(v/q_step, -n, n);
+    const auto k = std::min(static_cast<std::size_t>(std::floor(x + n)), Q_table_.size() - 2);
+    const auto t = x + n - k;
+
+    auto Q = hermite(t, q_step, Q_table_[k], Q_table_[k+1], I2_table_[k], I2_table_[k+1]);
+
+    //past the grid the junctions are linear, where Simpson is exact
+    if(std::abs(v) > q_range) {
+      const auto v0 = std::copysign(q_range, v);
+      Q += (v - v0)/6.0*(I2(v0) + 4.0*I2(0.5*(v0 + v)) + I2(v));
+    }
+
+    return Q;
+  }
+
+  //g = 2v - a, and a = v + R I(v) turns the integrals over a into integrals
+  //over v, solved by parts
+  double tree::G1_(double a) const noexcept {
+    const auto R = tree_.back().R;
+    const auto v = solve_(a);
+    const auto j = junction_(v);
+    return v*v + 2.0*R*(v*j.I - j.J) - 0.5*a*a;
+  }
+
+  double tree::G2_(double a) const noexcept {
+    const auto R = tree_.back().R;
+    const auto v = solve_(a);
+    const auto j = junction_(v);
+    return v*v*v/3.0 + R*v*j.I*(v + R*j.I) + R*R*(Q_(v) - 2.0*j.J*j.I)
+         - 2.0*R*j.J2 - a*a*a/6.0;
+  }
+
+  double tree::D_(double a, double b) const noexcept {
+    if(std::abs(a - b) < eps) return G1_(0.5*(a + b));
+    return (G2_(a) - G2_(b))/(a - b);
+  }
+
+  float tree::root_(float a) {
+
+    if(diodes_.empty()) return 2.0f*root_source_() - a;
+
+    const auto g = [&](double x) { return 2.0*solve_(x) - x; };
+
+    const auto v = solve_(a);
+    auto b = 2.0*v - a;
+
+    if(adaa_ == 1) {
+
+      a_aligned_ = 0.5*(a + a1_);
+
+      const auto G1 = G1_(a);
+      const auto d  = a - a1_;
+      b = std::abs(d) < eps ? g(0.5*(a + a1_)) : (G1 - G1a1_)/d;
+
+      G1a1_ = G1;
+
+    } else if(adaa_ == 2) {
+
+      a_aligned_ = (a + a1_ + a2_)/3.0;
+
+      const auto G2 = G2_(a);
+      const auto d1 = a - a1_;
+      const auto D  = std::abs(d1) < eps ? G1_(0.5*(a + a1_)) : (G2 - G2a1_)/d1;
+      const auto d  = a - a2_;
+
+      if(std::abs(d) >= eps)
+        b = 2.0*(D - D12_)/d;
+      else {
+        //back where it was two samples ago, expand around the midpoint
+        const auto xm = 0.5*(a + a2_), h = xm - a1_;
+        b = std::abs(h) < eps ? g(0.5*(xm + a1_))
+                              : 2.0*(G1_(xm) + (G2a1_ - G2_(xm))/h)/h;
+      }
+
+      G2a1_ = G2;
+      D12_  = D;
+    }
+
+    a2_     = a1_;
+    a1_     = a;
+    v_root_ = v;
+
+    return b;
+  }
+
+  void tree::advance(float delta_t) {
+
+    //a knob moves the port resistances up from its halves
+    auto moved = false;
+    for(auto&& k: knobs_) {
+      const auto pos = k.pot->position();
+      if(pos == k.pos) continue;
+      const auto [G1, G2] = k.pot->conductances(pos);
+      tree_[k.a].value = 1.0f/G1;
+      tree_[k.b].value = 1.0f/G2;
+      k.pos = pos;
+      moved = true;
+    }
+
+    if(moved || delta_t != delta_t_) resize_(delta_t);
+
+    //reflected waves, leaves up
+    for(auto&& e: tree_) {
+      switch(e.k) {
+        case kind::resistor:  e.b = 0.0f;       break;
+        case kind::capacitor: e.b = e.state;    break;
+        case kind::inductor:  e.b = -e.state;   break;
+        case kind::source:    e.b = e.source(); break;
+        case kind::series: {
+          auto s = 0.0f;
+          for(auto c = e.first; c < e.last; ++c)
+            s += children_[c].sign*tree_[children_[c].e].b;
+          e.b = s;
+          break;
+        }
+        case kind::parallel: {
+          auto s = 0.0f;
+          for(auto c = e.first; c < e.last; ++c)
+            s += children_[c].gamma*children_[c].sign*tree_[children_[c].e].b;
+          e.b = s;
+          break;
+        }
+        case kind::rtype: {
+          //the first row of S, adapted: no a0 in it
+          const auto S = rtypes_[e.r].S.data() + 1;
+          auto s = 0.0f;
+          for(auto c = e.first; c < e.last; ++c)
+            s += S[c - e.first]*tree_[children_[c].e].b;
+          e.b = s;
+          break;
+        }
+      }
+    }
+
+    auto& top = tree_.back();
+    top.a = root_(top.b);
+
+    //incident waves, top down
+    for(auto e = tree_.size(); e-- > 0;) {
+
+      auto& x = tree_[e];
+
+      switch(x.k) {
+        case kind::capacitor:
+        case kind::inductor:
+          x.state = x.a;
+          break;
+        case kind::series: {
+          //twice the port current, times R0
+          const auto S = x.a - x.b;
+          for(auto c = x.first; c < x.last; ++c) {
+            auto& [ch, sign, gamma] = children_[c];
+            tree_[ch].a = tree_[ch].b + sign*gamma*S;
+          }
+          break;
+        }
+        case kind::parallel: {
+          //twice the port voltage
+          const auto P = x.a + x.b;
+          for(auto c = x.first; c < x.last; ++c) {
+            auto& [ch, sign, gamma] = children_[c];
+            tree_[ch].a = sign*P - tree_[ch].b;
+          }
+          break;
+        }
+        case kind::rtype: {
+          const auto N = x.last - x.first + 1;
+          const auto S = rtypes_[x.r].S.data();
+          const auto in = waves_.data();
+          in[0] = x.a;
+          for(auto c = x.first; c < x.last; ++c)
+            in[c - x.first + 1] = tree_[children_[c].e].b;
+          for(size_t k = 1; k < N; ++k) {
+            auto a = 0.0f;
+            for(size_t j = 0; j < N; ++j) a += S[k*N + j]*in[j];
+            tree_[children_[x.first + k - 1].e].a = a;
+          }
+          break;
+        }
+        default:
+          break;
+      }
+    }
+
+    //ADAA is exact on linear g, where it averages the last 2 or 3 incident
+    //waves, so the root port voltage is read against that same average
+    if(adaa_) top.b = a_aligned_;
+
+    for(auto&& [to, from, e, sign]: walk_)
+      potentials_[to] = potentials_[from] + sign*0.5f*(tree_[e].a + tree_[e].b);
+
+    const auto v0 = potentials_[ground_];
+    for(auto&& v: potentials_) v -= v0;
+  }
+
+}		// -----  end of namespace rtspice::circuit::wdf  -----
@@ -17,6 +17,7 @@
 
 #include <string>
 #include <chrono>
+#include <thread>
 #include <numeric>
 
 #include <fstream>
@@ -32,6 +33,18 @@
 #include "dynamic.hpp"
 #include "opamp.hpp"
 #include "bipolar.hpp"
+#include "probe.hpp"
+#include "options.hpp"
+#include "block.hpp"
+#include "potentiometer.hpp"
+#include "switch.hpp"
+#include "line.hpp"
+#include "tube.hpp"
+#include "fet.hpp"
+#include "passes.hpp"
+#include "ordering.hpp"
+#include "resampler.hpp"
+#include "oversampler.hpp"
 
 
 using namespace std::string_literals;
@@ -162,72 +175,1563 @@ SCENARIO("dynamic simulation", "[circuit]") {
 
 }
 
+SCENARIO("Norton companion simulation", "[circuit]") {
+
+  GIVEN("an RLC circuit in both formulations") {
+
+    vector<component::ptr> branch {
+      make_component<ac_voltage>      ("V1", "1", "0", 1.0f, 1.0e3, 0.0f),
+      make_component<linear_resistor> ("R1", "1", "2", 100.0f),
+      make_component<linear_inductor> ("L1", "2", "3", 10e-3),
+      make_component<linear_capacitor>("C1", "3", "0", 1e-6),
+      make_component<linear_capacitor>("C2", "3", "0", 2.2e-6),
+    };
+
+    vector<component::ptr> norton {
+      make_component<ac_voltage>      ("V1", "1", "0", 1.0f, 1.0e3, 0.0f),
+      make_component<linear_resistor> ("R1", "1", "2", 100.0f),
+      make_component<norton_inductor> ("L1", "2", "3", 10e-3),
+      make_component<norton_capacitor>("C1", "3", "0", 1e-6),
+      make_component<norton_capacitor>("C2", "3", "0", 2.2e-6),
+      make_component<probe>           ("@JC1"),
+    };
+
+    circuit cb{branch}, cn{norton};
+
+    THEN("branch unknowns are dropped") {
+      REQUIRE(cn.nodes().size() + 3 == cb.nodes().size());
+      REQUIRE(cn.nodes().find("@JC1") == cn.nodes().end());
+    }
+
+    THEN("both formulations agree") {
+
+      constexpr float delta_t = 1.0 / 44100.0;
+
+      const auto vb = cb.get_x("3"), vn = cn.get_x("3");
+      const auto jb = cb.get_x("@JC1"), jn = cn.get_x("@JC1");
+
+      for(auto i = 0; i < 256; ++i) {
+        REQUIRE(cb.advance_(delta_t) > 0);
+        REQUIRE(cn.advance_(delta_t) > 0);
+
+        CHECK(*vn == Approx(*vb).margin(1e-4));
+        CHECK(*jn == Approx(*jb).margin(1e-6));
+      }
+    }
+  }
+}
+
+SCENARIO("coupled inductors", "[coupled_inductors]") {
+
+  GIVEN("a transformer and its T equivalent") {
+
+    //M = 0.25 sqrt(1m 4m) = 0.5m
+    vector<component::ptr> coupled {
+      make_component<ac_voltage>       ("V1", "1", "0", 1.0f, 1.0e3, 0.0f),
+      make_component<linear_resistor>  ("R1", "1", "P", 10.0f),
+      make_component<linear_inductor>  ("L1", "P", "0", 1e-3),
+      make_component<linear_inductor>  ("L2", "S", "0", 4e-3),
+      make_component<inductor_coupling>("K1", "L1", "L2", 0.25f),
+      make_component<linear_resistor>  ("RL", "S", "0", 100.0f),
+      make_component<probe>            ("@JL2"),
+    };
+
+    vector<component::ptr> tee {
+      make_component<ac_voltage>       ("V1", "1", "0", 1.0f, 1.0e3, 0.0f),
+      make_component<linear_resistor>  ("R1", "1", "P", 10.0f),
+      make_component<linear_inductor>  ("LP", "P", "M", 0.5e-3),
+      make_component<linear_inductor>  ("LS", "S", "M", 3.5e-3),
+      make_component<linear_inductor>  ("LM", "M", "0", 0.5e-3),
+      make_component<linear_resistor>  ("RL", "S", "0", 100.0f),
+    };
+
+    circuit ck{coupled}, ct{tee};
+
+    THEN("the windings add no branch unknowns") {
+      //1, P, S and J@V1
+      REQUIRE(ck.size() == 4);
+    }
+
+    THEN("both agree") {
+
+      constexpr float delta_t = 1.0 / 44100.0;
+
+      const auto vk = ck.get_x("S"), vt = ct.get_x("S");
+      const auto jk = ck.get_x("@JL2");
+
+      for(auto i = 0; i < 256; ++i) {
+        REQUIRE(ck.advance_(delta_t) > 0);
+        REQUIRE(ct.advance_(delta_t) > 0);
+
+        CHECK(*vk == Approx(*vt).margin(1e-4));
+        CHECK(*jk == Approx(-*vk/100.0f).margin(1e-6));
+      }
+    }
+  }
+
+  GIVEN("a coupling past unity, and three windings whose L is singular") {
+
+    //equal windings, each pair at -1/2: every row of L sums to 0
+    circuit c{vector<component::ptr>{
+      make_component<ac_voltage>       ("V1", "1", "0", 1.0f, 1.0e3, 0.0f),
+      make_component<linear_resistor>  ("R1", "1", "P", 10.0f),
+      make_component<linear_inductor>  ("L1", "P", "0", 1e-3),
+      make_component<linear_inductor>  ("L2", "S", "0", 4e-3),
+      make_component<inductor_coupling>("K1", "L1", "L2", 1.0f),
+      make_component<linear_resistor>  ("RL", "S", "0", 100.0f),
+      make_component<linear_inductor>  ("L3", "P", "A", 1e-3),
+      make_component<linear_inductor>  ("L4", "A", "B", 1e-3),
+      make_component<linear_inductor>  ("L5", "B", "0", 1e-3),
+      make_component<inductor_coupling>("K2", "L3", "L4", -0.5f),
+      make_component<inductor_coupling>("K3", "L4", "L5", -0.5f),
+      make_component<inductor_coupling>("K4", "L3", "L5", -0.5f),
+    }};
+
+    const auto logged = [&](const std::string& line) {
+      return std::find(c.log().begin(), c.log().end(), line) != c.log().end();
+    };
+
+    THEN("both are logged") {
+      REQUIRE(logged("coupling: K1 clamped to 0.9999"));
+      REQUIRE(logged("coupling: L3+L4+L5 has a singular L, left uncoupled"));
+      REQUIRE(c.advance_(1.0f/44100.0f) > 0);
+    }
+  }
+}
+
 SCENARIO("nonlinear dynamic simulation", "[circuit]") {
 
-  GIVEN("a nonlinear dynamic circuit") {
+  GIVEN("a nonlinear dynamic circuit") {
+
+    vector<component::ptr> components {
+
+      make_component<ac_voltage>      ("V1", "1", "0", 12.0f, 1.0e3, 0.0f), //12 V, 1 kHz
+      make_component<basic_diode>     ("D1", "1", "2", 4.352e-9f, 1.906f),  //1n4148
+      make_component<linear_resistor> ("R1", "2", "0", 2.2e+3f),            //2.2 kR
+      make_component<linear_capacitor>("C1", "2", "0", 10e-6),              //1 uF
+
+    };
+    circuit c{components};
+
+    constexpr float delta_t = 1.0e-6f;
+    constexpr int   niter   = 10;
+
+    THEN("time simulation converges") {
+      const auto i = c.advance_(delta_t);
+      INFO("V[cap] = " << *c.get_x("2") << " V");
+      REQUIRE( i > 0 );
+    }
+
+    THEN("time moves forward") {
+
+      std::vector<float> vs(niter);
+      std::vector<int>   is(niter);
+
+      const auto vptr = c.get_x("2");
+
+      for(auto iter = 0; iter < niter; ++iter) {
+        is[iter] = c.advance_(delta_t);
+        vs[iter] = *vptr;
+      }
+
+      for(auto iter = 0; iter < niter; ++iter) {
+        INFO("V[cap] = " << vs[iter] << " V");
+        REQUIRE(is[iter] > 0);
+      }
+
+    }
+
+    THEN("basic simulation") {
+
+      const int sim_size = 5.0e-3f / delta_t;
+
+      std::vector<float> vs(sim_size);
+      std::vector<int>   is(sim_size);
+
+      const auto vptr = c.get_x("2");
+
+      for(auto iter = 0; iter < sim_size; ++iter) {
+        is[iter] = c.advance_(delta_t);
+        vs[iter] = *vptr;
+      }
+
+      REQUIRE(std::all_of(is.cbegin(), is.cend(), [](auto i){ return i > 0; }));
+
+      std::ofstream v_file("sim_v.txt");
+      std::copy(vs.cbegin(), vs.cend(), std::ostream_iterator<float>(v_file, "\n"));
+
+      std::ofstream i_file("sim_i.txt");
+      std::copy(is.cbegin(), is.cend(), std::ostream_iterator<int>(i_file, "\n"));
+
+    }
+
+  }
+}
+
+SCENARIO("piecewise linear mode", "[pwl]") {
+
+  GIVEN("a diode clipper with piecewise linear junctions") {
+
+    const auto pwl = std::make_shared<const diode_model>(2.52e-9f, 1.752f, 8);
+
+    const auto clipper = [](diode_model::ptr m) {
+      return vector<component::ptr>{
+        make_component<ac_voltage>      ("V1", "IN", "0", 2.0f, 1e3f, 0.0f),
+        make_component<linear_resistor> ("R1", "IN", "OUT", 1e3f),
+        make_component<linear_capacitor>("C1", "OUT", "0", 10e-9),
+        make_component<basic_diode>     ("D1", "OUT", "0", m),
+        make_component<basic_diode>     ("D2", "0", "OUT", m),
+      };
+    };
+
+    circuit c{clipper(pwl)};
+    circuit r{clipper(std::make_shared<const diode_model>(2.52e-9f, 1.752f))};
+
+    constexpr float delta_t = 1.0f/48e3f;
+
+    THEN("regions are searched instead of NR") {
+      REQUIRE(c.piecewise());
+      REQUIRE(!r.piecewise());
+    }
+
+    THEN("it follows the smooth junction, with fewer solves") {
+
+      const auto out = c.get_x("OUT"), ref = r.get_x("OUT");
+      auto nc = 0, nr = 0;
+
+      for(auto i = 0; i < 96; ++i) {
+        const auto ic = c.advance_(delta_t), ir = r.advance_(delta_t);
+        REQUIRE(ic > 0);
+        REQUIRE(ir > 0);
+        nc += ic;
+        nr += ir;
+        //chords overestimate the junction current, so the clip comes lower
+        CHECK(*out == Approx(*ref).margin(3e-2));
+      }
+
+      INFO(nc << " against " << nr << " solves");
+      CHECK(nc < nr);
+      //one segment per diode, so far fewer than every combination
+      CHECK(c.regions().size() <= 20);
+    }
+
+    THEN("a small cache only costs refactorizations") {
+
+      c.regions().resize(2);
+      const auto out = c.get_x("OUT"), ref = r.get_x("OUT");
+
+      for(auto i = 0; i < 96; ++i) {
+        REQUIRE(c.advance_(delta_t) > 0);
+        REQUIRE(r.advance_(delta_t) > 0);
+        CHECK(*out == Approx(*ref).margin(3e-2));
+        CHECK(c.regions().size() <= 2);
+      }
+    }
+  }
+}
+
+SCENARIO("wave digital mode", "[wdf]") {
+
+  const auto wave = [](vector<component::ptr> cs) {
+    cs.push_back(make_component<options>(options::list{{"WDF", 1.0f}}));
+    return cs;
+  };
+
+  constexpr float delta_t = 1.0f/48e3f;
+
+  GIVEN("a driven RLC tank") {
+
+    const auto tank = [] {
+      return vector<component::ptr>{
+        make_component<ac_voltage>      ("V1", "IN", "0", 1.0f, 1e3f, 0.0f),
+        make_component<linear_resistor> ("R1", "IN", "A", 100.0f),
+        make_component<linear_inductor> ("L1", "A", "OUT", 10e-3f),
+        make_component<linear_capacitor>("C1", "OUT", "0", 1e-6f),
+        make_component<linear_resistor> ("R2", "OUT", "0", 1e3f),
+      };
+    };
+
+    circuit w{wave(tank())}, r{tank()};
+
+    THEN("it runs on the adaptor tree") {
+      REQUIRE(w.wave_digital());
+      REQUIRE(!r.wave_digital());
+    }
+
+    THEN("it matches MNA") {
+      const auto a = w.get_x("A"), out = w.get_x("OUT");
+      const auto ra = r.get_x("A"), rout = r.get_x("OUT");
+      for(auto i = 0; i < 256; ++i) {
+        REQUIRE(w.advance_(delta_t) > 0);
+        REQUIRE(r.advance_(delta_t) > 0);
+        CHECK(*a   == Approx(*ra).margin(1e-4));
+        CHECK(*out == Approx(*rout).margin(1e-4));
+      }
+    }
+
+    THEN("it follows MNA through changes of step") {
+      const auto out = w.get_x("OUT"), rout = r.get_x("OUT");
+      for(auto i = 0; i < 1024; ++i) {
+        const auto dt = (i/64) % 2 ? delta_t/4 : delta_t;
+        REQUIRE(w.advance_(dt) > 0);
+        REQUIRE(r.advance_(dt) > 0);
+        CHECK(*out == Approx(*rout).margin(1e-4));
+      }
+    }
+  }
+
+  GIVEN("a diode clipper") {
+
+    const auto clipper = [] {
+      return vector<component::ptr>{
+        make_component<ac_voltage>      ("V1", "IN", "0", 2.0f, 1e3f, 0.0f),
+        make_component<linear_resistor> ("R1", "IN", "OUT", 1e3f),
+        make_component<linear_capacitor>("C1", "OUT", "0", 10e-9),
+        make_component<basic_diode>     ("D1", "OUT", "0", 2.52e-9f, 1.752f),
+        make_component<basic_diode>     ("D2", "0", "OUT", 2.52e-9f, 1.752f),
+      };
+    };
+
+    circuit w{wave(clipper())}, r{clipper()};
+
+    THEN("the diodes are the root and it matches MNA") {
+      REQUIRE(w.wave_digital());
+      const auto out = w.get_x("OUT"), ref = r.get_x("OUT");
+      for(auto i = 0; i < 96; ++i) {
+        REQUIRE(w.advance_(delta_t) > 0);
+        REQUIRE(r.advance_(delta_t) > 0);
+        CHECK(*out == Approx(*ref).margin(1e-3));
+      }
+    }
+  }
+
+  GIVEN("a bridge, which is not series-parallel") {
+
+    const auto bridge = [](component::ptr R5) {
+      return vector<component::ptr>{
+        make_component<dc_voltage>      ("V1", "IN", "0", 1.0f),
+        make_component<linear_resistor> ("R1", "IN", "A", 1e3f),
+        make_component<linear_resistor> ("R2", "IN", "B", 2e3f),
+        make_component<linear_resistor> ("R3", "A", "0", 3e3f),
+        make_component<linear_resistor> ("R4", "B", "0", 4e3f),
+        move(R5),
+      };
+    };
+
+    circuit c{wave(bridge(make_component<linear_resistor>("R5", "A", "B", 5e3f)))};
+    circuit v{wave(bridge(make_component<dc_voltage>     ("V5", "A", "B", 0.1f)))};
+
+    THEN("it runs on an R-type adaptor") {
+      REQUIRE(c.wave_digital());
+      REQUIRE(c.advance_(delta_t) > 0);
+      //B = (IN G2 + A G5)/(G2 + G4 + G5), A = (IN G1 + B G5)/(G1 + G3 + G5)
+      CHECK(*c.get_x("A") == Approx(0.7412f).margin(1e-3));
+    }
+
+    THEN("a source inside it falls back to MNA") {
+      REQUIRE(!v.wave_digital());
+      REQUIRE(v.advance_(delta_t) > 0);
+    }
+  }
+
+  GIVEN("a tone stack, bridged through its bass and mid caps") {
+
+    const auto stack = [] {
+      return vector<component::ptr>{
+        make_component<ac_voltage>      ("V1", "IN", "0", 1.0f, 1e3f, 0.0f),
+        make_component<linear_resistor> ("R1", "IN", "A", 100e3f),
+        make_component<linear_capacitor>("C1", "IN", "T", 250e-12f),
+        make_component<linear_capacitor>("C2", "A", "BT", 100e-9f),
+        make_component<linear_capacitor>("C3", "A", "M", 47e-9f),
+        make_component<potentiometer>   ("PT", "T", "OUT", "BT", 250e3f, "treble"),
+        make_component<linear_resistor> ("RB", "BT", "M", 500e3f),
+        make_component<linear_resistor> ("RM", "M", "0", 10e3f),
+        make_component<linear_resistor> ("RL", "OUT", "0", 1e6f),
+      };
+    };
+
+    circuit w{wave(stack())}, r{stack()};
+
+    THEN("it runs on the adaptor tree and matches MNA as the knob moves") {
+      REQUIRE(w.wave_digital());
+      const auto out = w.get_x("OUT"), rout = r.get_x("OUT");
+      for(auto i = 0; i < 1024; ++i) {
+        w.get_param("treble") = r.get_param("treble") = float(i/256)/3.0f;
+        REQUIRE(w.advance_(delta_t) > 0);
+        REQUIRE(r.advance_(delta_t) > 0);
+        CHECK(*out == Approx(*rout).margin(1e-4));
+      }
+    }
+
+    THEN("it follows MNA through changes of step") {
+      const auto m = w.get_x("M"), rm = r.get_x("M");
+      for(auto i = 0; i < 1024; ++i) {
+        const auto dt = (i/64) % 2 ? delta_t/4 : delta_t;
+        REQUIRE(w.advance_(dt) > 0);
+        REQUIRE(r.advance_(dt) > 0);
+        CHECK(*m == Approx(*rm).margin(1e-4));
+      }
+    }
+  }
+}
+
+SCENARIO("antiderivative antialiasing", "[adaa]") {
+
+  GIVEN("a hard diode clipper in wave digital mode, at 1x with and without ADAA, and at 4x") {
+
+    constexpr float fs = 48e3f, f0 = 5010.0f; //odd harmonics fold between the even ones
+    constexpr int   N  = 4800;                //10 Hz bins, 501 whole periods
+
+    const auto clipper = [=](unsigned adaa) {
+      const auto m = std::make_shared<const diode_model>(2.52e-9f, 1.752f, 0, adaa);
+      return vector<component::ptr>{
+        make_component<ac_voltage>     ("V1", "IN", "0", 4.0f, f0, 0.0f),
+        make_component<linear_resistor>("R1", "IN", "OUT", 1e3f),
+        make_component<basic_diode>    ("D1", "OUT", "0", m),
+        make_component<basic_diode>    ("D2", "0", "OUT", m),
+        make_component<options>        (options::list{{"WDF", 1.0f}}),
+      };
+    };
+
+    //output power on each 10 Hz bin up to 24 kHz, os samples per 1x sample
+    const auto spectrum = [&](unsigned adaa, int os) {
+      circuit c{clipper(adaa)};
+      REQUIRE(c.wave_digital());
+      const auto out = c.get_x("OUT");
+      for(auto i = 0; i < os*N/10; ++i) c.advance_(1.0f/(os*fs)); //settle the history
+
+      vector<double> x(os*N);
+      for(auto&& v: x) {
+        REQUIRE(c.advance_(1.0f/(os*fs)) > 0);
+        v = *out;
+      }
+
+      vector<double> P(N/2);
+      for(auto k = 1; k < N/2; ++k) {
+        const auto w = 2.0*std::cos(2.0*M_PI*k/(os*N));
+        double s1 = 0.0, s2 = 0.0;
+        for(auto v: x) {
+          const auto s0 = v + w*s1 - s2;
+          s2 = s1;
+          s1 = s0;
+        }
+        P[k] = s1*s1 + s2*s2 - w*s1*s2;
+      }
+      return P;
+    };
+
+    //fundamental amplitude, then harmonic distortion and aliased power
+    //against it, in dB
+    const auto measure = [&](const vector<double>& P, int os) {
+      constexpr auto k0 = int(f0/10.0f);
+      double harmonics = 0.0, alias = 0.0;
+      for(auto k = 1; k < N/2; ++k)
+        if(k == k0) continue;
+        else if(k % k0 == 0) harmonics += P[k];
+        else alias += P[k];
+      return std::tuple{ 10.0*std::log10(4.0*P[k0])  - 20.0*std::log10(os*N),
+                         10.0*std::log10(harmonics/P[k0]),
+                         10.0*std::log10(alias/P[k0]) };
+    };
+
+    THEN("ADAA cuts the aliases at 1x, towards 4x oversampling") {
+
+      const auto [a0, thd0, alias0] = measure(spectrum(0, 1), 1);
+      const auto [a1, thd1, alias1] = measure(spectrum(1, 1), 1);
+      const auto [a2, thd2, alias2] = measure(spectrum(2, 1), 1);
+      const auto [a4, thd4, alias4] = measure(spectrum(0, 4), 4);
+
+      WARN("THD / aliases, dB: 1x " << thd0 << " / " << alias0 <<
+           ", ADAA1 " << thd1 << " / " << alias1 <<
+           ", ADAA2 " << thd2 << " / " << alias2 <<
+           ", 4x "    << thd4 << " / " << alias4);
+
+      CHECK(alias1 < alias0 - 3.0);
+      CHECK(alias2 < alias1 - 2.0);
+      CHECK(alias2 == Approx(alias4).margin(1.0)); //as good as 4x, at 1x
+
+      //ADAA is also a mild lowpass: the fundamental barely moves, the upper
+      //harmonics drop a little
+      CHECK(a1 == Approx(a4).margin(1.0));
+      CHECK(a2 == Approx(a4).margin(1.0));
+      CHECK(thd1 < thd0);
+    }
+
+    THEN("benchmark") {
+
+      circuit c1{clipper(0)}, ca{clipper(2)};
+
+      BENCHMARK("1x step") {
+        return c1.advance_(1.0f/fs);
+      };
+
+      BENCHMARK("ADAA2 1x step") {
+        return ca.advance_(1.0f/fs);
+      };
+
+      BENCHMARK("4x oversampled step") {
+        auto i = 0;
+        for(auto k = 0; k < 4; ++k) i += c1.advance_(0.25f/fs);
+        return i;
+      };
+    }
+  }
+}
+
+SCENARIO("oversampling", "[resampler]") {
+
+  GIVEN("a 4x interpolator and decimator") {
+
+    using rtspice::circuit::interpolator;
+    using rtspice::circuit::decimator;
+
+    interpolator up{4};
+    decimator    down{4};
+
+    constexpr int N = 4800;
+    const auto w = 2.0*M_PI*1e3/48e3; //1 kHz at 48 kHz
+
+    vector<float> x(N), hi(4*N), y(N);
+    for(auto i = 0; i < N; ++i) x[i] = std::sin(w*i);
+
+    //in two blocks, the state carries over
+    up.process(x.data(), N/2, hi.data());
+    up.process(x.data() + N/2, N/2, hi.data() + 2*N);
+    down.process(hi.data(), N, y.data());
+
+    THEN("a band limited signal comes back, delayed") {
+      const auto D = up.delay() + down.delay();
+      for(auto i = 200; i < N; ++i)
+        REQUIRE(y[i] == Approx(std::sin(w*(i - D))).margin(1e-3));
+    }
+
+    THEN("the images are rejected") {
+
+      //10 Hz bins over 90 whole periods, past the start
+      const auto power = [&](double f) {
+        const auto c = 2.0*std::cos(2.0*M_PI*f/192e3);
+        double s1 = 0.0, s2 = 0.0;
+        for(auto i = 1920; i < 4*N; ++i) {
+          const auto s0 = hi[i] + c*s1 - s2;
+          s2 = s1;
+          s1 = s0;
+        }
+        return s1*s1 + s2*s2 - c*s1*s2;
+      };
+
+      CHECK(10.0*std::log10(power(47e3)/power(1e3)) < -60.0);
+      CHECK(10.0*std::log10(power(49e3)/power(1e3)) < -60.0);
+    }
+  }
+
+  GIVEN("circuits asking for it") {
+
+    const auto rc = [](float factor) {
+      return vector<component::ptr>{
+        make_component<ac_voltage>      ("V1", "IN", "0", 1.0f, 1e3f, 0.0f),
+        make_component<linear_resistor> ("R1", "IN", "OUT", 1e3f),
+        make_component<linear_capacitor>("C1", "OUT", "0", 1e-6f),
+        make_component<options>         (options::list{{"OVERSAMPLE", factor}}),
+      };
+    };
+
+    THEN("the factor is kept when supported") {
+      REQUIRE(circuit{rc(4.0f)}.oversampling() == 4);
+      REQUIRE(circuit{rc(8.0f)}.oversampling() == 8);
+
+      circuit c{rc(3.0f)};
+      REQUIRE(c.oversampling() == 1);
+      REQUIRE(!c.log().empty());
+    }
+  }
+}
+
+SCENARIO("integration methods", "[integration]") {
+
+  using namespace rtspice::components::integration;
+  using rtspice::components::make_integrated;
+
+  const auto rc = [](method m, float R, float C, vector<component::ptr> more = {}) {
+    more.push_back(make_component<ext_voltage>    ("V1", "IN", "0", "in"));
+    more.push_back(make_component<linear_resistor>("R1", "IN", "OUT", R));
+    more.push_back(make_integrated<dynamic, linear_capacitor_branch>(m, "C1", "OUT", "0", C));
+    return more;
+  };
+
+  const method all[] = { method::be, method::tr, method::bdf2, method::tr_bdf2 };
+
+  GIVEN("an RC lowpass driven by a sine from rest") {
+
+    //worst error against the exact response over 10 ms
+    const auto error = [&](method m, float delta_t) {
+      circuit c{rc(m, 1e3f, 1e-6f)};
+      auto& in = c.get_input("in");
+      const auto out = c.get_x("OUT");
+
+      const auto w = 2.0*M_PI*1e3, tau = 1e-3, wt = w*tau;
+      auto e = 0.0;
+      for(auto t = delta_t; t < 10e-3; t += delta_t) {
+        in = std::sin(w*t);
+        REQUIRE(c.advance_(delta_t) > 0);
+        const auto v = (std::sin(w*t) - wt*std::cos(w*t) + wt*std::exp(-t/tau))/(1.0 + wt*wt);
+        e = std::max(e, std::abs(*out - v));
+      }
+      return e;
+    };
+
+    THEN("each method converges at its order") {
+      const auto r = [&](method m) { return error(m, 1.0f/48e3f)/error(m, 1.0f/96e3f); };
+      CHECK(r(method::be) == Approx(2.0).epsilon(0.15));
+      CHECK(r(method::tr) > 3.3);
+      CHECK(r(method::bdf2) > 3.3);
+      CHECK(r(method::tr_bdf2) > 3.3);
+    }
+  }
+
+  GIVEN("a stiff RC lowpass stepped from 0 to 1 V") {
+
+    constexpr float delta_t = 1.0f/48e3f;
+
+    //tau = 0.1 us, far below the step: the capacitor current, a charge
+    //pulse in the first step, should be gone by the next
+    const auto step = [&](vector<component::ptr> cs) {
+      circuit c{cs};
+      c.get_input("in") = 1.0f;
+      const auto j = c.get_x("@JC1");
+      vector<float> i;
+      for(auto n = 0; n < 32; ++n) {
+        REQUIRE(c.advance_(delta_t) > 0);
+        i.push_back(*j);
+      }
+      return i;
+    };
+
+    const auto pulse = 10e-9f/delta_t; //C dv/dt, over the first step
+
+    THEN("the trapezoidal rule rings at the Nyquist frequency") {
+      const auto i = step(rc(method::tr, 10.0f, 10e-9f));
+      CHECK(std::abs(i[30]) > 0.3f*pulse);
+      CHECK(i[30]*i[31] < 0.0f);
+    }
+
+    THEN("the damped methods settle at once") {
+      for(auto m: { method::be, method::bdf2, method::tr_bdf2 }) {
+        const auto i = step(rc(m, 10.0f, 10e-9f));
+        for(auto n = 4; n < 32; ++n) CHECK(std::abs(i[n]) < 1e-3f*pulse);
+      }
+    }
+
+    THEN("METHOD applies to every capacitor naming no method") {
+      const auto opts = make_component<options>(options::list{{"METHOD", float(method::bdf2)}});
+      const auto i = step(rc(method::unspecified, 10.0f, 10e-9f, {opts}));
+      for(auto n = 4; n < 32; ++n) CHECK(std::abs(i[n]) < 1e-3f*pulse);
+    }
+
+    THEN("an explicit TR survives METHOD") {
+      const auto opts = make_component<options>(options::list{{"METHOD", float(method::be)}});
+      const auto i = step(rc(method::tr, 10.0f, 10e-9f, {opts}));
+      CHECK(std::abs(i[30]) > 0.3f*pulse);
+      CHECK(i[30]*i[31] < 0.0f);
+    }
+  }
+
+  GIVEN("a method for every capacitor") {
+    THEN("TR-BDF2 alone solves twice per step") {
+      circuit tr{rc(method::tr, 1e3f, 1e-6f)};
+      const auto solves = tr.advance_(1e-3f);
+
+      for(auto m: all) {
+        circuit c{rc(m, 1e3f, 1e-6f)};
+        CHECK(c.advance_(1e-3f) == (m == method::tr_bdf2 ? 2 : 1)*solves);
+        CHECK(*c.get_time() == Approx(1e-3f));
+      }
+    }
+  }
+}
+
+SCENARIO("adaptive oversampling", "[adaptive]") {
+
+  using rtspice::circuit::oversampler;
+
+  constexpr std::size_t n = 256;
+  constexpr float delta_t = 1.0f/48e3f;
+
+  const auto clipper = [](bool adaptive) {
+    return vector<component::ptr>{
+      make_component<ext_voltage>     ("V1", "IN", "0", "in"),
+      make_component<linear_resistor> ("R1", "IN", "OUT", 1e3f),
+      make_component<linear_capacitor>("C1", "OUT", "0", 10e-9),
+      make_component<basic_diode>     ("D1", "OUT", "0", 2.52e-9f, 1.752f),
+      make_component<basic_diode>     ("D2", "0", "OUT", 2.52e-9f, 1.752f),
+      make_component<options>         (options::list{{"OVERSAMPLE", 4.0f},
+                                                     {"ADAPTIVE", adaptive}}),
+    };
+  };
+
+  GIVEN("a clipper driven quiet, loud and quiet again") {
+
+    circuit a{clipper(true)}, f{clipper(false)};
+
+    REQUIRE(a.adaptive());
+    REQUIRE(!f.adaptive());
+
+    oversampler as{a, {&a.get_input("in")}, {a.get_x("OUT")}, 4, a.adaptive()};
+    oversampler fs{f, {&f.get_input("in")}, {f.get_x("OUT")}, 4, f.adaptive()};
+    as.resize(n);
+    fs.resize(n);
+
+    REQUIRE(as.latency() == fs.latency());
+
+    //1 kHz, 0.1 V for 20 blocks, 4 V for 20 and 0.1 V for 30
+    constexpr int blocks = 70;
+    const auto level = [](int b) { return b >= 20 && b < 40 ? 4.0f : 0.1f; };
+
+    vector<unsigned> rate;
+    vector<float> error;
+    vector<float> x(n), ya(n), yf(n);
+
+    for(auto b = 0; b < blocks; ++b) {
+      for(std::size_t s = 0; s < n; ++s)
+        x[s] = level(b)*std::sin(2.0*M_PI*1e3*(b*n + s)*delta_t);
+
+      const float* in[] = { x.data() };
+      float* oa[] = { ya.data() };
+      float* of[] = { yf.data() };
+      as.process(in, oa, n, delta_t);
+      fs.process(in, of, n, delta_t);
+
+      rate.push_back(as.rate());
+      auto e = 0.0f;
+      for(std::size_t s = 0; s < n; ++s) e = std::max(e, std::abs(ya[s] - yf[s]));
+      error.push_back(e);
+    }
+
+    THEN("it only runs at the full rate while clipping") {
+      for(auto b = 0; b < 20; ++b) CHECK(rate[b] == 1);
+      for(auto b = 22; b < 40; ++b) CHECK(rate[b] == 4);
+      for(auto b = 60; b < blocks; ++b) CHECK(rate[b] == 1);
+      CHECK(fs.rate() == 4);
+    }
+
+    THEN("it sounds like the fixed rate") {
+      //quiet blocks lose little to the linear reconstruction
+      for(auto b = 4; b < 20; ++b) CHECK(error[b] < 1e-3f);
+      for(auto b = 60; b < blocks; ++b) CHECK(error[b] < 1e-3f);
+      //loud ones match once the filters hold full rate blocks only
+      for(auto b = 24; b < 40; ++b) CHECK(error[b] < 1e-3f);
+    }
+  }
+}
+
+SCENARIO("ideal opamp elimination", "[ideal_opamp]") {
+
+  GIVEN("a non-inverting amplifier") {
+
+    vector<component::ptr> components {
+      make_component<dc_voltage>      ("V1", "IN", "0", 0.5f),
+      make_component<ideal_opamp>     ("U1", "OUT", "0", "IN", "N"),
+      make_component<linear_resistor> ("R1", "OUT", "N", 9e3f),
+      make_component<linear_resistor> ("R2", "N", "0", 1e3f),
+    };
+    circuit c{components};
+
+    THEN("the nullor removes two unknowns") {
+      //IN, OUT, N and J@V1, with IN and N merged and no output current
+      REQUIRE(c.size() == 3);
+    }
+
+    THEN("the gain is preserved") {
+      REQUIRE(c.nr_step_() > 0);
+      CHECK(*c.get_x("OUT") == Approx(5.0f));
+      CHECK(*c.get_x("N")   == Approx(0.5f));
+    }
+  }
+
+  GIVEN("an inverting amplifier") {
+
+    vector<component::ptr> components {
+      make_component<dc_voltage>      ("V1", "IN", "0", 0.5f),
+      make_component<linear_resistor> ("R1", "IN", "N", 1e3f),
+      make_component<linear_resistor> ("R2", "N", "OUT", 4.7e3f),
+      make_component<ideal_opamp>     ("U1", "OUT", "0", "0", "N"),
+    };
+    circuit c{components};
+
+    THEN("the virtual ground is folded") {
+      REQUIRE(c.size() == 3);
+      REQUIRE(c.nr_step_() > 0);
+      CHECK(*c.get_x("N")   == 0.0f);
+      CHECK(*c.get_x("OUT") == Approx(-2.35f));
+    }
+  }
+}
+
+SCENARIO("rail limited opamp", "[rail_opamp]") {
+
+  constexpr float delta_t = 1.0f/48e3f;
+
+  //inverting amplifier, gain -10
+  const auto amplifier = [](float A, float f, float GBW) {
+    return vector<component::ptr>{
+      make_component<ac_voltage>      ("V1", "IN", "0", A, f, 0.0f),
+      make_component<linear_resistor> ("R1", "IN", "N", 1e3f),
+      make_component<linear_resistor> ("R2", "N", "OUT", 10e3f),
+      make_component<rail_opamp>      ("U1", "OUT", "0", "0", "N",
+                                       1e5f, -4.5f, 4.5f, GBW),
+    };
+  };
+
+  GIVEN("an amplifier driven into its rails") {
+
+    circuit c{amplifier(1.0f, 1e3f, 0.0f)};
+
+    const auto in = c.get_x("IN"), out = c.get_x("OUT");
+
+    THEN("it is linear away from the rails and never crosses them") {
+      for(auto i = 0; i < 96; ++i) {
+        REQUIRE(c.advance_(delta_t) > 0);
+        CHECK(std::abs(*out) <= 4.5f);
+        if(std::abs(*in) < 0.3f)
+          CHECK(*out == Approx(-10.0f * *in).margin(1e-2));
+      }
+    }
+  }
+
+  GIVEN("the diode clamp emulation") {
+
+    circuit c{amplifier(1.0f, 1e3f, 0.0f)};
+
+    vector<component::ptr> emulation {
+      make_component<ac_voltage>      ("V1", "IN", "0", 1.0f, 1e3f, 0.0f),
+      make_component<linear_resistor> ("R1", "IN", "N", 1e3f),
+      make_component<linear_resistor> ("R2", "N", "O", 10e3f),
+      make_component<ideal_opamp>     ("U1", "O", "0", "0", "N"),
+      make_component<linear_resistor> ("RO", "O", "OUT", 1e3f),
+      make_component<dc_voltage>      ("VP", "VP", "0", 4.0f),
+      make_component<dc_voltage>      ("VN", "VN", "0", -4.0f),
+      make_component<basic_diode>     ("D1", "OUT", "VP", 4.352e-9f, 1.906f),
+      make_component<basic_diode>     ("D2", "VN", "OUT", 4.352e-9f, 1.906f),
+    };
+    circuit e{emulation};
+
+    THEN("the macromodel needs fewer Newton iterations") {
+      auto nc = 0, ne = 0;
+      for(auto i = 0; i < 96; ++i) {
+        const auto ic = c.advance_(delta_t), ie = e.advance_(delta_t);
+        REQUIRE(ic > 0);
+        REQUIRE(ie > 0);
+        nc += ic;
+        ne += ie;
+      }
+      INFO(nc << " against " << ne << " iterations");
+      CHECK(nc < ne);
+    }
+  }
+
+  GIVEN("a finite gain bandwidth product") {
+
+    //closed loop bandwidth around 9 kHz
+    circuit slow{amplifier(0.1f, 12e3f, 100e3f)};
+    circuit fast{amplifier(0.1f, 12e3f, 0.0f)};
+
+    THEN("high frequencies roll off") {
+      auto peak_slow = 0.0f, peak_fast = 0.0f;
+      for(auto i = 0; i < 480; ++i) {
+        REQUIRE(slow.advance_(delta_t) > 0);
+        REQUIRE(fast.advance_(delta_t) > 0);
+        if(i < 240) continue; //settle
+        peak_slow = std::max(peak_slow, std::abs(*slow.get_x("OUT")));
+        peak_fast = std::max(peak_fast, std::abs(*fast.get_x("OUT")));
+      }
+      CHECK(peak_fast == Approx(1.0f).epsilon(2e-2));
+      CHECK(peak_slow < 0.8f*peak_fast);
+      CHECK(peak_slow > 0.4f*peak_fast);
+    }
+  }
+}
+
+SCENARIO("potentiometer", "[potentiometer]") {
+
+  GIVEN("a loaded volume pot") {
+
+    vector<component::ptr> components {
+      make_component<dc_voltage>      ("V1", "IN", "0", 1.0f),
+      make_component<potentiometer>   ("P1", "IN", "W", "0", 10e3f, "vol", taper::log),
+      make_component<linear_resistor> ("RL", "W", "0", 1e9f),
+    };
+    circuit c{components};
+    auto& vol = c.get_param("vol");
+
+    const auto w = c.get_x("W");
+
+    THEN("the wiper follows the taper") {
+      vol = 0.5f;
+      REQUIRE(c.advance_(1e-3f) > 0);
+      CHECK(*w == Approx(0.1f).epsilon(1e-3));
+
+      vol = 1.0f;
+      REQUIRE(c.advance_(1e-3f) > 0);
+      CHECK(*w == Approx(1.0f).epsilon(1e-3));
+    }
+
+    THEN("knob moves rebuild the static stamp") {
+      for(auto x: {0.2f, 0.9f, 0.35f, 0.5f}) {
+        vol = x;
+        REQUIRE(c.advance_(1e-3f) > 0);
+      }
+      //back to the initial position, so back to the initial solution
+      CHECK(*w == Approx(0.1f).epsilon(1e-3));
+    }
+  }
+
+  GIVEN("the three resistor emulation") {
+
+    vector<component::ptr> pot {
+      make_component<dc_voltage>       ("V1", "X", "0", 1.0f),
+      make_component<potentiometer>    ("P1", "X", "Y", "Z", 10e3f, "pos"),
+      make_component<linear_resistor>  ("RL", "Y", "0", 4.7e3f),
+      make_component<linear_resistor>  ("RZ", "Z", "0", 1e3f),
+    };
+
+    vector<component::ptr> emulation {
+      make_component<dc_voltage>       ("V1", "X", "0", 1.0f),
+      make_component<linear_resistor>  ("RpotX", "X", "XY", 10e3f),
+      make_component<variable_resistor>("RpotY", "XY", "Y", -10e3f, "pos"),
+      make_component<variable_resistor>("RpotZ", "Y", "Z", 10e3f, "pos"),
+      make_component<linear_resistor>  ("RL", "Y", "0", 4.7e3f),
+      make_component<linear_resistor>  ("RZ", "Z", "0", 1e3f),
+    };
+
+    circuit c{pot}, r{emulation};
+
+    THEN("both agree on the linear taper") {
+      const auto y = c.get_x("Y"), yr = r.get_x("Y");
+      for(auto x: {0.5f, 0.1f, 0.75f}) {
+        c.get_param("pos") = x;
+        r.get_param("pos") = x;
+        REQUIRE(c.advance_(1e-3f) > 0);
+        REQUIRE(r.advance_(1e-3f) > 0);
+        CHECK(*y == Approx(*yr).epsilon(1e-3));
+      }
+    }
+  }
+}
+
+SCENARIO("switch", "[spst_switch]") {
+
+  GIVEN("a two way selector") {
 
     vector<component::ptr> components {
+      make_component<dc_voltage>      ("V1", "IN", "0", 1.0f),
+      make_component<linear_resistor> ("R1", "IN", "OUT", 1e3f),
+      make_component<spst_switch>     ("S1", "OUT", "A", "sel"),
+      make_component<spst_switch>     ("S2", "OUT", "B", "sel", true),
+      make_component<linear_resistor> ("RA", "A", "0", 1e3f),
+      make_component<linear_resistor> ("RB", "B", "0", 3e3f),
+    };
+    circuit c{components};
+    auto& sel = c.get_param("sel");
 
-      make_component<ac_voltage>      ("V1", "1", "0", 12.0f, 1.0e3, 0.0f), //12 V, 1 kHz
-      make_component<basic_diode>     ("D1", "1", "2", 4.352e-9f, 1.906f),  //1n4148
-      make_component<linear_resistor> ("R1", "2", "0", 2.2e+3f),            //2.2 kR
-      make_component<linear_capacitor>("C1", "2", "0", 10e-6),              //1 uF
+    const auto out = c.get_x("OUT");
+
+    THEN("each position selects one leg") {
+      for(auto i = 0; i < 3; ++i) {
+        sel = 0.0f;
+        REQUIRE(c.advance_(1e-3f) > 0);
+        CHECK(*out == Approx(0.75f).epsilon(1e-3));
+
+        sel = 1.0f;
+        REQUIRE(c.advance_(1e-3f) > 0);
+        CHECK(*out == Approx(0.5f).epsilon(1e-3));
+      }
+    }
+  }
+}
+
+SCENARIO("slow partitions", "[slow]") {
+
+  constexpr float delta_t = 1.0f/48e3f;
+
+  //a capacitor telling which step sizes it was prepared for, and stepped by
+  struct watched_capacitor : linear_capacitor {
+    watched_capacitor(std::string id, std::string a, std::string b, float C,
+                      vector<float>& seen, vector<float>& stepped) :
+      linear_capacitor{std::move(id), std::move(a), std::move(b), C},
+      seen_{seen}, stepped_{stepped} {}
+
+    void prepare(float h) override { seen_.push_back(h); }
+
+    void setup(rtspice::circuit::circuit& c) override {
+      linear_capacitor::setup(c);
+      delta_t_ = c.get_delta_time();
+    }
+
+    void fill() const noexcept override {
+      linear_capacitor::fill();
+      stepped_.push_back(*delta_t_);
+    }
+
+    vector<float>& seen_;
+    vector<float>& stepped_;
+    const float* delta_t_ = nullptr;
+  };
+
+  GIVEN("a bias network under a sine load, with and without .SLOW 8") {
+
+    vector<float> seen, stepped;
+
+    const auto bias = [&](vector<component::ptr> more) {
+      more.push_back(make_component<dc_voltage>       ("X1.V1", "X1.vcc", "0", 9.0f));
+      more.push_back(make_component<linear_resistor>  ("X1.R1", "X1.vcc", "b", 10e3f));
+      more.push_back(make_component<watched_capacitor>("X1.C1", "b", "0", 10e-6f, seen, stepped));
+      more.push_back(make_component<linear_resistor>  ("R2", "b", "0", 10e3f));
+      more.push_back(make_component<ext_current>      ("I1", "b", "0", "load"));
+      return more;
+    };
+
+    circuit r{bias({})};
+    circuit i{bias({make_component<partition_card>("X1..SLOW", 8)})};
+    circuit h{bias({make_component<partition_card>("X1..SLOW", 8, true)})};
+
+    THEN("the subcircuit runs on its own") {
+      REQUIRE(i.slow_partitions() == 1);
+      REQUIRE(h.slow_partitions() == 1);
+      REQUIRE(r.slow_partitions() == 0);
+    }
+
+    THEN("prepare reaches it with the slow step") {
+      seen.clear();
+      i.prepare(delta_t);
+      REQUIRE(seen == vector<float>{8*delta_t});
+    }
+
+    THEN("it is stepped by exactly that step") {
+      i.prepare(delta_t);
+      stepped.clear();
+      for(auto n = 0; n < 32; ++n) REQUIRE(i.advance_(delta_t) > 0);
+      REQUIRE(stepped.size() == 4);
+      for(auto h: stepped) CHECK(h == 8*delta_t);
+    }
+
+    THEN("the port follows the single rate circuit, held or interpolated") {
+
+      const auto vr = r.get_x("b"), vi = i.get_x("b"), vh = h.get_x("b");
+
+      //charging at up to 90 V/s, a slow step moves the port by 15 mV
+      auto ei = 0.0f, eh = 0.0f;
+      for(auto n = 1; n <= 9600; ++n) {
+        const auto load = 100e-6f*std::sin(2.0f*float(M_PI)*20.0f*n*delta_t);
+        for(auto c: {&r, &i, &h}) {
+          c->get_input("load") = load;
+          REQUIRE(c->advance_(delta_t) > 0);
+        }
+        ei = std::max(ei, std::abs(*vi - *vr));
+        eh = std::max(eh, std::abs(*vh - *vr));
+      }
+
+      CHECK(ei < 0.05f);
+      CHECK(eh < 0.05f);
+      CHECK(*vi == Approx(*vr).epsilon(5e-3));
+    }
+  }
+
+  GIVEN("a lone capacitor under .SLOW 8 HOLD, drained through its port") {
+
+    constexpr float C = 1e-6f;
+
+    circuit c{vector<component::ptr>{
+      make_integrated<dynamic, linear_capacitor_branch>(integration::method::be, "X1.C1", "b", "0", C),
+      make_component<linear_resistor>("R1", "b", "0", 1e3f),
+      make_component<ac_current>     ("I1", "0", "b", 1e-3f, 1e3f, 0.0f),
+      make_component<partition_card> ("X1..SLOW", 8, true),
+    }};
+
+    THEN("it loses exactly the charge the rest drew") {
+
+      const auto v = c.get_x("b"), j = c.get_x("J@SLOW@b");
+
+      //the port holds the capacitor voltage of the last slow step
+      auto drawn = 0.0, held = 0.0;
+      for(auto n = 1; n <= 480; ++n) {
+        REQUIRE(c.advance_(delta_t) > 0);
+        CHECK(*v == Approx(-held/C).margin(1e-4));
+        drawn -= *j*delta_t;
+        if(n % 8 == 0) held = drawn;
+      }
+    }
+  }
+}
+
+SCENARIO("threaded partitions", "[partition]") {
+
+  constexpr float delta_t = 1.0f/48e3f;
 
+  GIVEN("an RC, a buffer marked .PARTITION and another RC") {
+
+    const auto stages = [](vector<component::ptr> more) {
+      more.push_back(make_component<ext_voltage>     ("V1", "in", "0", "in"));
+      more.push_back(make_component<linear_resistor> ("R1", "in", "a", 1e3f));
+      more.push_back(make_component<linear_capacitor>("C1", "a", "0", 100e-9f));
+      more.push_back(make_component<ideal_opamp>     ("X1.U1", "b", "0", "a", "b"));
+      more.push_back(make_component<linear_resistor> ("R2", "b", "c", 1e3f));
+      more.push_back(make_component<linear_capacitor>("C2", "c", "0", 100e-9f));
+      more.push_back(make_component<probe>           ("c"));
+      return more;
+    };
+
+    circuit r{stages({})};
+    circuit c{stages({make_component<partition_card>("X1..PARTITION", 1, true, true)})};
+
+    THEN("the buffer runs on a worker thread") {
+      REQUIRE(c.threaded_partitions() == 1);
+      REQUIRE(r.threaded_partitions() == 0);
+    }
+
+    THEN("its handle is there for the host to raise") {
+      REQUIRE(c.worker_threads().size() == 1);
+      REQUIRE(r.worker_threads().empty());
+    }
+
+    THEN("the output is the single threaded one, a step late per handoff") {
+
+      constexpr int late = 2; //into and out of the buffer
+
+      const auto v = c.get_x("c"), vr = r.get_x("c");
+      vector<float> ref;
+      for(auto n = 0; n < 480; ++n) {
+        const auto in = std::sin(2.0f*float(M_PI)*1e3f*n*delta_t);
+        c.get_input("in") = r.get_input("in") = in;
+        REQUIRE(c.advance_(delta_t) > 0);
+        REQUIRE(r.advance_(delta_t) > 0);
+        ref.push_back(*vr);
+        if(n >= late) CHECK(*v == Approx(ref[n - late]).margin(1e-5));
+      }
+    }
+
+    THEN("a worker gone to sleep wakes up, and is joined on destruction") {
+
+      REQUIRE(c.advance_(delta_t) > 0);
+
+      const auto asleep = [&] {
+        const auto until = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+        while(c.sleeping_partitions() == 0 && std::chrono::steady_clock::now() < until)
+          std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        return c.sleeping_partitions() == 1;
+      };
+
+      REQUIRE(asleep());
+      REQUIRE(c.advance_(delta_t) > 0);
+      REQUIRE(asleep());
+    }
+  }
+
+  GIVEN("a partition whose solve fails") {
+
+    //an open resistor leaves nothing on the diagonal of its far node
+    circuit c{vector<component::ptr>{
+      make_component<ext_voltage>    ("V1", "a", "0", "in"),
+      make_component<linear_resistor>("X1.R1", "a", "X1.k", INFINITY),
+      make_component<partition_card> ("X1..PARTITION", 1, true, true),
+    }};
+
+    THEN("the host reports it with the step after") {
+      REQUIRE(c.threaded_partitions() == 1);
+      REQUIRE(c.advance_(delta_t) > 0);
+      REQUIRE(c.advance_(delta_t) < 0);
+      REQUIRE(c.advance_(delta_t) < 0);
+    }
+  }
+}
+
+SCENARIO("delay line", "[delay_line]") {
+
+  GIVEN("a matched line between two resistors") {
+
+    constexpr unsigned N = 37;
+
+    vector<component::ptr> components {
+      make_component<ext_voltage>     ("V1", "IN", "0", "in"),
+      make_component<linear_resistor> ("R1", "IN", "A", 600.0f),
+      make_component<delay_line>      ("T1", "A", "0", "B", "0", 600.0f, N),
+      make_component<linear_resistor> ("R2", "B", "0", 600.0f),
     };
     circuit c{components};
+    auto& in = c.get_input("in");
 
-    constexpr float delta_t = 1.0e-6f;
-    constexpr int   niter   = 10;
+    const auto out = c.get_x("B");
 
-    THEN("time simulation converges") {
-      const auto i = c.advance_(delta_t);
-      INFO("V[cap] = " << *c.get_x("2") << " V");
-      REQUIRE( i > 0 );
+    THEN("half the input comes out N steps later") {
+      vector<float> x;
+      for(auto n = 0u; n < 200; ++n) {
+        x.push_back(std::sin(0.1f*n) + (n % 7 == 0));
+        in = x.back();
+        REQUIRE(c.advance_(1e-5f) > 0);
+        CHECK(*out == Approx(n < N ? 0.0f : 0.5f*x[n - N]).margin(1e-5));
+      }
     }
+  }
+}
 
-    THEN("time moves forward") {
+SCENARIO("FET simulation", "[fet_array]") {
 
-      std::vector<float> vs(niter);
-      std::vector<int>   is(niter);
+  using type = fet_device::type;
 
-      const auto vptr = c.get_x("2");
+  GIVEN("an NMOS common source stage") {
 
-      for(auto iter = 0; iter < niter; ++iter) {
-        is[iter] = c.advance_(delta_t);
-        vs[iter] = *vptr;
+    const auto stage = [](bool swapped) {
+      return vector<component::ptr> {
+        make_component<dc_voltage>      ("VD", "DD", "0", 10.0f),
+        make_component<dc_voltage>      ("VG", "G", "0", 2.0f),
+        make_component<linear_resistor> ("RD", "DD", "D", 1e3f),
+        swapped ? make_component<fet_array>("M1", "0", "G", "D", type::nmos, 1.0f, 2e-3f, 0.0f)
+                : make_component<fet_array>("M1", "D", "G", "0", type::nmos, 1.0f, 2e-3f, 0.0f),
+      };
+    };
+
+    THEN("the square law is followed") {
+      circuit c{stage(false)};
+      REQUIRE(c.nr_step_() > 0);
+      CHECK(*c.get_x("D") == Approx(9.0f)); //1 mA
+    }
+
+    THEN("drain and source are interchangeable") {
+      //the grounded end acts as source, with Vgs = 2 V as well
+      circuit c{stage(true)};
+      REQUIRE(c.nr_step_() > 0);
+      CHECK(*c.get_x("D") == Approx(9.0f));
+    }
+  }
+
+  GIVEN("a mixed set of FETs") {
+
+    const auto netlist = [] {
+      vector<component::ptr> components {
+        make_component<dc_voltage>      ("VD", "DD", "0", 9.0f),
+        make_component<ac_voltage>      ("VI", "IN", "0", 0.5f, 1e3f, 0.0f),
+        //JFET source follower
+        make_component<fet_array>       ("J1", "DD", "IN", "S1", type::njf, -2.0f, 1.3e-3f, 2e-3f),
+        make_component<linear_resistor> ("RS1", "S1", "0", 2.2e3f),
+        //NMOS and PMOS inverters on the follower output
+        make_component<fet_array>       ("M1", "O1", "S1", "0", type::nmos, 1.0f, 1e-3f, 1e-2f),
+        make_component<linear_resistor> ("R1", "DD", "O1", 4.7e3f),
+        make_component<fet_array>       ("M2", "O2", "S1", "DD", type::pmos, -1.0f, 1e-3f, 1e-2f),
+        make_component<linear_resistor> ("R2", "O2", "0", 4.7e3f),
+      };
+      return components;
+    };
+
+    auto batched = netlist();
+    REQUIRE(rtspice::circuit::passes::batch_fets(batched, {}) == 3);
+    REQUIRE(batched.size() == 6);
+
+    circuit c{netlist()}, cb{batched};
+
+    THEN("one batch matches the separate devices") {
+
+      constexpr float delta_t = 1.0 / 48000.0;
+
+      const auto o1 = c.get_x("O1"), o1b = cb.get_x("O1");
+      const auto o2 = c.get_x("O2"), o2b = cb.get_x("O2");
+
+      for(auto i = 0; i < 96; ++i) {
+        REQUIRE(c.advance_(delta_t) > 0);
+        REQUIRE(cb.advance_(delta_t) > 0);
+        CHECK(*o1b == Approx(*o1).margin(1e-4));
+        CHECK(*o2b == Approx(*o2).margin(1e-4));
       }
+    }
 
-      for(auto iter = 0; iter < niter; ++iter) {
-        INFO("V[cap] = " << vs[iter] << " V");
-        REQUIRE(is[iter] > 0);
+    THEN("benchmark") {
+      BENCHMARK("batched FET step") {
+        return cb.advance_(1.0f / 48000.0f);
+      };
+    }
+  }
+}
+
+SCENARIO("netlist simplification", "[passes]") {
+
+  GIVEN("a reducible RC network") {
+
+    const auto netlist = [](bool island) {
+      vector<component::ptr> components {
+        make_component<dc_voltage>      ("V1", "1", "0", 10.0f),
+        make_component<linear_resistor> ("R1", "1", "2", 1e3f),
+        make_component<linear_resistor> ("R2", "2", "3", 1e3f),
+        make_component<linear_resistor> ("R3", "3", "0", 2e3f),
+        make_component<linear_resistor> ("R4", "0", "3", 2e3f),
+        make_component<dc_current>      ("I1", "3", "0", 1e-3f),
+        make_component<dc_current>      ("I2", "0", "3", 2e-3f),
+        make_component<linear_capacitor>("C1", "3", "0", 1e-6f),
+        make_component<linear_resistor> ("R5", "3", "X", 1e3f),
+        make_component<probe>           ("3"),
+      };
+      if(island) {
+        components.push_back(make_component<linear_resistor>("R6", "A", "B", 1e3f));
+        components.push_back(make_component<dc_current>     ("I3", "A", "B", 1e-3f));
       }
+      return components;
+    };
+
+    circuit c{netlist(false)}, cs{netlist(true), true};
 
+    THEN("every pass is logged") {
+      REQUIRE(cs.log().size() > 1);
+      REQUIRE(cs.size() < c.size());
+      //only the probed node and the capacitor branch are left
+      REQUIRE(cs.size() == 2);
     }
 
-    THEN("basic simulation") {
+    THEN("probe outputs are preserved") {
 
-      const int sim_size = 5.0e-3f / delta_t;
+      constexpr float delta_t = 1.0 / 44100.0;
 
-      std::vector<float> vs(sim_size);
-      std::vector<int>   is(sim_size);
+      const auto v = c.get_x("3"), vs = cs.get_x("3");
 
-      const auto vptr = c.get_x("2");
+      for(auto i = 0; i < 64; ++i) {
+        REQUIRE(c.advance_(delta_t) > 0);
+        REQUIRE(cs.advance_(delta_t) > 0);
+        CHECK(*vs == Approx(*v).margin(1e-5));
+      }
+    }
+  }
+}
 
-      for(auto iter = 0; iter < sim_size; ++iter) {
-        is[iter] = c.advance_(delta_t);
-        vs[iter] = *vptr;
+SCENARIO("Kron reduction", "[passes]") {
+
+  GIVEN("an R-2R ladder driving a capacitor") {
+
+    const auto netlist = [] {
+      return vector<component::ptr> {
+        make_component<ac_voltage>      ("V1", "in", "0", 1.0f, 1.0e3, 0.0f),
+        make_component<linear_resistor> ("R1", "in", "n1", 1e3f),
+        make_component<linear_resistor> ("R2", "n1", "0",  2e3f),
+        make_component<linear_resistor> ("R3", "n1", "n2", 1e3f),
+        make_component<linear_resistor> ("R4", "n2", "0",  2e3f),
+        make_component<linear_resistor> ("R5", "n2", "n3", 1e3f),
+        make_component<linear_resistor> ("R6", "n3", "0",  2e3f),
+        make_component<linear_resistor> ("R7", "n3", "out", 1e3f),
+        make_component<linear_resistor> ("R8", "out", "0", 2e3f),
+        make_component<linear_capacitor>("C1", "out", "0", 100e-9f),
+        make_component<probe>           ("out"),
+        make_component<probe>           ("n2"),
+      };
+    };
+
+    circuit c{netlist()}, cs{netlist(), true};
+
+    THEN("the ladder shrinks to its ports") {
+      //in, out, J@V1 and J@C1
+      REQUIRE(cs.size() == 4);
+      REQUIRE(c.size() == 7);
+    }
+
+    THEN("outputs and eliminated probes are preserved") {
+
+      constexpr float delta_t = 1.0 / 44100.0;
+
+      const auto out = c.get_x("out"), outs = cs.get_x("out");
+      const auto n2  = c.get_x("n2"),  n2s  = cs.get_x("n2");
+
+      for(auto i = 0; i < 128; ++i) {
+        REQUIRE(c.advance_(delta_t) > 0);
+        REQUIRE(cs.advance_(delta_t) > 0);
+        CHECK(*outs == Approx(*out).margin(1e-5));
+        CHECK(*n2s  == Approx(*n2).margin(1e-5));
+      }
+    }
+  }
+}
+
+SCENARIO("Krylov model order reduction", "[passes]") {
+
+  GIVEN("a long RC ladder") {
+
+    const auto netlist = [](options::list opts) {
+      vector<component::ptr> components {
+        make_component<ac_voltage>      ("V1", "in", "0", 1.0f, 1.0e3, 0.0f),
+        make_component<linear_resistor> ("R0", "in", "n0", 1e3f),
+        make_component<probe>           ("n40"),
+        make_component<options>         (std::move(opts)),
+      };
+      for(auto i = 0; i < 40; ++i) {
+        const auto a = "n" + std::to_string(i), b = "n" + std::to_string(i+1);
+        components.push_back(make_component<linear_resistor> ("R" + b, a, b, 100.0f));
+        components.push_back(make_component<linear_capacitor>("C" + b, b, "0", 10e-9f));
       }
+      return components;
+    };
 
-      REQUIRE(std::all_of(is.cbegin(), is.cend(), [](auto i){ return i > 0; }));
+    circuit c {netlist({})},
+            ct{netlist({{"PRIMA_TOL",   1e-3f}}), true},
+            co{netlist({{"PRIMA_ORDER", 3.0f}}),  true};
 
-      std::ofstream v_file("sim_v.txt");
-      std::copy(vs.cbegin(), vs.cend(), std::ostream_iterator<float>(v_file, "\n"));
+    THEN("the ladder is replaced by a small block") {
+      REQUIRE(ct.size() < 16);
+      //two ports and three block moments, plus J@V1 and the output capacitor
+      REQUIRE(co.size() == 2 + 6 + 2);
+      REQUIRE(c.size() > 80);
+    }
 
-      std::ofstream i_file("sim_i.txt");
-      std::copy(is.cbegin(), is.cend(), std::ostream_iterator<int>(i_file, "\n"));
+    THEN("audio band outputs match the full model") {
+
+      constexpr float delta_t = 1.0 / 44100.0;
+
+      const auto v = c.get_x("n40"), vt = ct.get_x("n40");
+
+      for(auto i = 0; i < 256; ++i) {
+        REQUIRE(c.advance_(delta_t)  > 0);
+        REQUIRE(ct.advance_(delta_t) > 0);
+        CHECK(*vt == Approx(*v).margin(2e-3));
+      }
+    }
+  }
+}
+
+SCENARIO("block triangular form", "[btf]") {
+
+  GIVEN("a linear stage buffered into a diode clipper") {
+
+    const auto m = std::make_shared<const diode_model>(2.52e-9f, 1.752f);
+
+    const auto clipper = [&] {
+      return vector<component::ptr> {
+        make_component<linear_resistor> ("R3", "B", "OUT", 1e3f),
+        make_component<basic_diode>     ("D1", "OUT", "0", m),
+        make_component<basic_diode>     ("D2", "0", "OUT", m),
+        make_component<linear_capacitor>("C1", "OUT", "0", 10e-9f),
+      };
+    };
+
+    auto chain = clipper();
+    chain.insert(chain.end(), {
+      make_component<ext_voltage>     ("V1", "IN", "0", "in"),
+      make_component<linear_resistor> ("R1", "IN", "A", 1e3f),
+      make_component<linear_resistor> ("R2", "A", "0", 1e3f),
+      make_component<linear_vcvs>     ("E1", "B", "0", "A", "0", 2.0f),
+    });
+
+    auto alone = clipper();
+    alone.push_back(make_component<ext_voltage>("V1", "B", "0", "in"));
+
+    circuit c{chain}, r{alone};
+
+    THEN("the stage before the buffer is solved once per step") {
+      REQUIRE(c.blocks() > 1);
+      REQUIRE(c.settled_blocks() > 0);
+      REQUIRE(c.settled_blocks() < c.blocks());
+    }
 
+    THEN("the clipper sees its input as if driven directly") {
+      auto& in = c.get_input("in");
+      auto& ir = r.get_input("in");
+      const auto out = c.get_x("OUT"), ref = r.get_x("OUT");
+      for(auto n = 0; n < 480; ++n) {
+        in = ir = 2.0f*std::sin(2.0*M_PI*1e3*n/48e3);
+        REQUIRE(c.advance_(1.0f/48e3f) > 0);
+        REQUIRE(r.advance_(1.0f/48e3f) > 0);
+        CHECK(*out == Approx(*ref).margin(1e-4));
+      }
+    }
+  }
+}
+
+SCENARIO("fill reducing orderings", "[ordering]") {
+
+  GIVEN("an arrow pattern, dense along its first row and column") {
+
+    constexpr int n = 5;
+
+    const auto arrow = [](bool first) {
+      const auto hub = first ? 0 : n - 1;
+      vector<std::set<int>> rows(n);
+      for(auto i = 0; i < n; ++i) {
+        rows[i].insert({i, hub});
+        if(i == hub) for(auto j = 0; j < n; ++j) rows[i].insert(j);
+      }
+      return rtspice::circuit::ordering::compress(rows);
+    };
+
+    THEN("eliminating the hub first fills everything, last fills nothing") {
+      const auto a = arrow(true), b = arrow(false);
+      const auto ca = rtspice::circuit::ordering::predict(n, a.row, a.col);
+      const auto cb = rtspice::circuit::ordering::predict(n, b.row, b.col);
+      REQUIRE(ca.fill == std::size_t(n*n) - a.col.size());
+      REQUIRE(cb.fill == 0);
+      REQUIRE(cb < ca);
+    }
+  }
+
+  GIVEN("a loaded circuit") {
+
+    circuit c{vector<component::ptr>{
+      make_component<dc_voltage>      ("V1", "IN", "0", 1.0f),
+      make_component<linear_resistor> ("R1", "IN", "A", 1e3f),
+      make_component<linear_resistor> ("R2", "A", "0", 1e3f),
+      make_component<linear_capacitor>("C1", "A", "0", 1e-6f),
+    }};
+
+    THEN("the cheapest candidate is kept and logged") {
+      const vector<std::string> names{"MDQ", "AMD", "COLAMD", "RCM", "ND"};
+      REQUIRE(std::find(names.begin(), names.end(), c.ordering()) != names.end());
+      REQUIRE(std::any_of(c.log().begin(), c.log().end(), [](auto&& l) {
+        return l.rfind("ordering: ", 0) == 0;
+      }));
+    }
+  }
+}
+
+SCENARIO("exact discretization", "[expm]") {
+
+  GIVEN("a series RLC resonating at 5 kHz, with Q = 20") {
+
+    constexpr float L = 1e-3f, C = 1.0132e-6f, R = 1.5708f;
+
+    const auto netlist = [&](options::list opts) {
+      return vector<component::ptr> {
+        make_component<ext_voltage>     ("V1", "IN", "0", "in"),
+        make_component<linear_resistor> ("R1", "IN", "A", R),
+        make_component<linear_inductor> ("L1", "A", "OUT", L),
+        make_component<linear_capacitor>("C1", "OUT", "0", C),
+        make_component<probe>           ("OUT"),
+        make_component<options>         (std::move(opts)),
+      };
+    };
+
+    circuit tr{netlist({})}, ex{netlist({{"EXPM", 1.0f}})};
+
+    THEN("the whole RLC becomes a block on the source node") {
+      REQUIRE(tr.size() == 6);
+      REQUIRE(ex.size() == 2);
     }
 
+    THEN("at 48 kHz only the trapezoidal rule detunes the resonance") {
+
+      constexpr float delta_t = 1.0f/48e3f;
+      constexpr double f = 5e3;
+
+      ex.prepare(delta_t);
+
+      //peak over the last millisecond of 40, settled
+      const auto peak = [&](circuit& c) {
+        auto& in = c.get_input("in");
+        const auto out = c.get_x("OUT");
+        auto y = 0.0f;
+        for(auto n = 1; n <= 1920; ++n) {
+          in = std::sin(2.0*M_PI*f*n*delta_t);
+          REQUIRE(c.advance_(delta_t) > 0);
+          if(n > 1872) y = std::max(y, std::abs(*out));
+        }
+        return y;
+      };
+
+      //Q, less the linear interpolation of the input, sinc^2(f dt)
+      const auto x = M_PI*f*delta_t;
+      const auto gain = 20.0*std::pow(std::sin(x)/x, 2);
+
+      CHECK(peak(ex) == Approx(gain).epsilon(1e-3));
+      CHECK(peak(tr) < 0.7*gain);
+    }
   }
 }
 
@@ -340,3 +1844,84 @@ SCENARIO("basic transistor simulation", "[bipolar_npn]") {
 
   }
 }
+
+SCENARIO("tube simulation", "[triode]") {
+
+  const auto ecc83 = std::make_shared<const triode_model>(
+      100.0f, 1.4f, 1060.0f, 600.0f, 300.0f, 2000.0f);
+
+  GIVEN("the tabulated 12AX7 characteristic") {
+
+    THEN("it follows the model equations") {
+      for(auto vgk = -4.0f; vgk <= 1.0f; vgk += 0.37f)
+        for(auto vpk = 20.0f; vpk <= 400.0f; vpk += 13.0f) {
+          const auto t = (*ecc83)(vgk, vpk), e = ecc83->exact(vgk, vpk);
+          CHECK(t.f  == Approx(e.f).margin(2e-6));
+          CHECK(t.fx == Approx(e.fx).margin(2e-5));
+          CHECK(t.fy == Approx(e.fy).margin(2e-7));
+        }
+    }
+  }
+
+  GIVEN("a 12AX7 common cathode stage") {
+
+    constexpr float delta_t = 1.0 / 48000.0;
+
+    vector<component::ptr> components {
+      make_component<dc_voltage>      ("VB", "B", "0", 250.0f),
+      make_component<ac_voltage>      ("VI", "IN", "0", 0.1f, 1e3f, 0.0f),
+      make_component<linear_capacitor>("CI", "IN", "G", 22e-9f),
+      make_component<linear_resistor> ("RG", "G", "0", 1e6f),
+      make_component<triode>          ("V1", "P", "G", "K", ecc83),
+      make_component<linear_resistor> ("RA", "B", "P", 100e3f),
+      make_component<linear_resistor> ("RK", "K", "0", 1.5e3f),
+      make_component<linear_capacitor>("CK", "K", "0", 22e-6f),
+    };
+    circuit c{components};
+
+    THEN("the stage biases and amplifies") {
+
+      const auto p = c.get_x("P");
+
+      auto lo = 1e9f, hi = -1e9f;
+      for(auto i = 0; i < 4800; ++i) {
+        REQUIRE(c.advance_(delta_t) > 0);
+        if(i >= 2400) {
+          lo = std::min(lo, *p);
+          hi = std::max(hi, *p);
+        }
+      }
+
+      CHECK(*c.get_x("K") > 0.5f);
+      CHECK(*c.get_x("K") < 3.0f);
+      CHECK((hi - lo)/0.2f > 30.0f); //peak to peak gain
+    }
+
+    THEN("benchmark") {
+      BENCHMARK("12AX7 gain stage step at 48 kHz") {
+        return c.advance_(delta_t);
+      };
+    }
+  }
+
+  GIVEN("an EL34 with a resistive load") {
+
+    const auto el34 = std::make_shared<const pentode_model>(
+        11.0f, 1.35f, 650.0f, 4200.0f, 60.0f, 24.0f, 2000.0f);
+
+    vector<component::ptr> components {
+      make_component<dc_voltage>      ("VB", "B", "0", 400.0f),
+      make_component<dc_voltage>      ("VG", "G", "0", -30.0f),
+      make_component<pentode>         ("V1", "P", "B", "G", "0", el34),
+      make_component<linear_resistor> ("RA", "B", "P", 2e3f),
+    };
+    circuit c{components};
+
+    THEN("the operating point is found") {
+      REQUIRE(c.nr_step_() > 0);
+      const auto ip = (400.0f - *c.get_x("P"))/2e3f;
+      CHECK(ip > 10e-3f);
+      CHECK(ip < 200e-3f);
+    }
+  }
+}
@@ -23,6 +23,25 @@
 
 namespace rtspice::components {
 
+  /*!
+   * @brief Ebers-Moll constants, computed once per .MODEL and shared, read
+   * only, by all of its transistors
+   */
+  struct bipolar_model {
+
+    using ptr = std::shared_ptr<const bipolar_model>;
+
+    bipolar_model(float IS, float BF, float BR, unsigned PWL = 0) :
+      BF{ BF },
+      BR{ BR },
+      alpha_f{ BF/(1.0f + BF) },
+      alpha_r{ BR/(1.0f + BR) },
+      junction{ std::make_shared<const diode_model>(IS, 1.0f, PWL) } {}
+
+    const float BF, BR, alpha_f, alpha_r;
+    const diode_model::ptr junction;
+  };
+
   class bipolar_npn : public component {
     public:
       virtual bool is_static()    const override { return false; }
@@ -36,16 +55,25 @@ namespace rtspice::components {
               float IS,
               float BF,
               float BR) :
+        bipolar_npn{ std::move(id), std::move(nc), std::move(nb), std::move(ne),
+                     std::make_shared<const bipolar_model>(IS, BF, BR) } {}
+
+      bipolar_npn(std::string id,
+              std::string nc,
+              std::string nb,
+              std::string ne,
+              bipolar_model::ptr model) :
         component{ std::move(id) },
         nc_{ std::move(nc) },
         nb_{ std::move(nb) },
         ne_{ std::move(ne) },
+        model_{ std::move(model) },
         nbe_{ "be@" + id_ },
         nbc_{ "bc@" + id_ },
-        De_{ "De@" + id_, nbe_, ne_, IS, 1.0f },
-        Dc_{ "Dc@" + id_, nbc_, nc_, IS, 1.0f },
-        Fforward_{ "Ff@" + id_, nc_, nb_, nb_, nbe_, BF/(1.0f + BF) },
-        Freverse_{ "Fr@" + id_, ne_, nb_, nb_, nbc_, BR/(1.0f + BR) } {}
+        De_{ "De@" + id_, nbe_, ne_, model_->junction },
+        Dc_{ "Dc@" + id_, nbc_, nc_, model_->junction },
+        Fforward_{ "Ff@" + id_, nc_, nb_, nb_, nbe_, model_->alpha_f },
+        Freverse_{ "Fr@" + id_, ne_, nb_, nb_, nbc_, model_->alpha_r } {}
 
       virtual void register_(circuit::circuit &c) override {
         De_.register_(c);
@@ -61,6 +89,15 @@ namespace rtspice::components {
         Freverse_.setup(c);
       }
 
+      virtual std::vector<std::string> terminals() const override {
+        return {nc_, nb_, ne_};
+      }
+
+      virtual ptr clone(const renamer& r) const override {
+        return make_component<bipolar_npn>(r.id(id_), r.node(nc_), r.node(nb_),
+                                  r.node(ne_), model_);
+      }
+
       virtual void fill() const noexcept override {
         De_.fill();
         Dc_.fill();
@@ -68,8 +105,18 @@ namespace rtspice::components {
         Freverse_.fill();
       }
 
+      virtual bool is_piecewise() const override { return De_.is_piecewise(); }
+
+      virtual void region(std::vector<std::uint8_t>& key) const noexcept override {
+        De_.region(key);
+        Dc_.region(key);
+      }
+
+      const auto& model() const noexcept { return model_; }
+
     private:
       const std::string nc_, nb_, ne_;
+      const bipolar_model::ptr model_;
       const std::string nbe_, nbc_; //internal nodes
       basic_diode De_, Dc_;
       linear_cccs Fforward_, Freverse_;
@@ -88,16 +135,25 @@ namespace rtspice::components {
               float IS,
               float BF,
               float BR) :
+        bipolar_pnp{ std::move(id), std::move(nc), std::move(nb), std::move(ne),
+                     std::make_shared<const bipolar_model>(IS, BF, BR) } {}
+
+      bipolar_pnp(std::string id,
+              std::string nc,
+              std::string nb,
+              std::string ne,
+              bipolar_model::ptr model) :
         component{ std::move(id) },
         nc_{ std::move(nc) },
         nb_{ std::move(nb) },
         ne_{ std::move(ne) },
+        model_{ std::move(model) },
         nbe_{ "be@" + id_ },
         nbc_{ "bc@" + id_ },
-        De_{ "De@" + id_, ne_, nbe_, IS, 1.0f },
-        Dc_{ "Dc@" + id_, nc_, nbc_, IS, 1.0f },
-        Fforward_{ "Ff@" + id_, nc_, nb_, nb_, nbe_, BF/(1.0f + BF) },
-        Freverse_{ "Fr@" + id_, ne_, nb_, nb_, nbc_, BR/(1.0f + BR) } {}
+        De_{ "De@" + id_, ne_, nbe_, model_->junction },
+        Dc_{ "Dc@" + id_, nc_, nbc_, model_->junction },
+        Fforward_{ "Ff@" + id_, nc_, nb_, nb_, nbe_, model_->alpha_f },
+        Freverse_{ "Fr@" + id_, ne_, nb_, nb_, nbc_, model_->alpha_r } {}
 
       virtual void register_(circuit::circuit &c) override {
         De_.register_(c);
@@ -113,6 +169,15 @@ namespace rtspice::components {
         Freverse_.setup(c);
       }
 
+      virtual std::vector<std::string> terminals() const override {
+        return {nc_, nb_, ne_};
+      }
+
+      virtual ptr clone(const renamer& r) const override {
+        return make_component<bipolar_pnp>(r.id(id_), r.node(nc_), r.node(nb_),
+                                  r.node(ne_), model_);
+      }
+
       virtual void fill() const noexcept override {
         De_.fill();
         Dc_.fill();
@@ -120,8 +185,18 @@ namespace rtspice::components {
         Freverse_.fill();
       }
 
+      virtual bool is_piecewise() const override { return De_.is_piecewise(); }
+
+      virtual void region(std::vector<std::uint8_t>& key) const noexcept override {
+        De_.region(key);
+        Dc_.region(key);
+      }
+
+      const auto& model() const noexcept { return model_; }
+
     private:
       const std::string nc_, nb_, ne_;
+      const bipolar_model::ptr model_;
       const std::string nbe_, nbc_;
       basic_diode De_, Dc_;
       linear_cccs Fforward_, Freverse_;
@@ -0,0 +1,639 @@
+/*!
+ *    @file  block.hpp
+ *   @brief  dense multiport blocks produced by the netlist reductions
+ *
+ *  @author  Thadeu Luiz Barbosa Dias (tlbd)
+ *
+ *  @internal
+ *       Created:  10/18/2026
+ *      Revision:  none
+ *      Compiler:  g++
+ *  Organization:  SMT - Signals, Multimedia and Telecommunications Lab
+ *     Copyright:  Copyright (c) 2019, Thadeu Luiz Barbosa Dias
+ *
+ *  This source code is released for free distribution under the terms of the
+ *  GNU General Public License as published by the Free Software Foundation.
+ */
+
+#ifndef  block_INC
+#define  block_INC
+
+#include <array>
+#include <cassert>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "component.hpp"
+#include "circuit.hpp"
+
+namespace rtspice::components {
+
+  //dense row major matrix, shared by every instance of a subcircuit
+  using shared_stamp = std::shared_ptr<const std::vector<float>>;
+
+  /*!
+   * @brief static multiport admittance, referenced to ground
+   *
+   * Stamps the dense p x p matrix Y (row major) on the port nodes. Eliminated
+   * nodes that were probed are kept as derived variables, reconstructed from
+   * the port voltages after every step as H * v, with H a q x p matrix.
+   */
+  class admittance_block : public component {
+    public:
+      admittance_block(std::string id,
+                       std::vector<std::string> ports,
+                       shared_stamp Y,
+                       std::vector<std::string> probes = {},
+                       shared_stamp H = {}) :
+        component{ std::move(id) },
+        ports_{ std::move(ports) },
+        probes_{ std::move(probes) },
+        Y_{ std::move(Y) },
+        H_{ std::move(H) },
+        values_(probes_.size(), 0.0f) {}
+
+      virtual bool is_static()    const override { return true; }
+      virtual bool is_dynamic()   const override { return false; }
+      virtual bool is_nonlinear() const override { return false; }
+
+      virtual void register_(circuit::circuit& c) override {
+
+        const auto p = ports_.size();
+
+        for(auto&& n: ports_) c.register_node(n);
+        for(auto&& n: probes_) c.register_derived(n);
+
+        for(std::size_t i = 0; i < p; ++i)
+          for(std::size_t j = 0; j < p; ++j)
+            if((*Y_)[i*p + j] != 0.0f) c.register_entry({ports_[i], ports_[j]});
+
+      }
+
+      virtual void setup(circuit::circuit& c) override {
+
+        const auto p = ports_.size();
+
+        A_.clear();
+        for(std::size_t i = 0; i < p; ++i)
+          for(std::size_t j = 0; j < p; ++j)
+            if((*Y_)[i*p + j] != 0.0f)
+              A_.emplace_back(c.get_A({ports_[i], ports_[j]}), (*Y_)[i*p + j]);
+
+        x_.clear();
+        for(auto&& n: ports_) x_.push_back(c.get_state(n));
+
+        auto bound = false;
+        for(std::size_t k = 0; k < probes_.size(); ++k)
+          bound |= c.bind_derived(probes_[k], &values_[k]);
+
+        if(bound) c.register_commit(this);
+
+      }
+
+      virtual std::vector<std::string> terminals() const override {
+        auto ts = ports_;
+        ts.push_back("0");
+        return ts;
+      }
+
+      virtual void fill() const noexcept override {
+        for(auto&& [a, y]: A_) *a += y;
+      }
+
+      virtual void commit() noexcept override {
+        const auto p = ports_.size();
+        for(std::size_t k = 0; k < values_.size(); ++k) {
+          auto v = 0.0f;
+          for(std::size_t j = 0; j < p; ++j) v += (*H_)[k*p + j] * *x_[j];
+          values_[k] = v;
+        }
+      }
+
+      const auto& ports()      const noexcept { return ports_; }
+      const auto& probes()     const noexcept { return probes_; }
+      const auto& admittance() const noexcept { return *Y_; }
+
+      virtual ptr clone(const renamer& r) const override {
+        std::vector<std::string> ports, probes;
+        for(auto&& n: ports_)  ports.push_back(r.node(n));
+        for(auto&& n: probes_) probes.push_back(r.node(n));
+        return make_component<admittance_block>(r.id(id_), std::move(ports),
+                                                Y_, std::move(probes), H_);
+      }
+
+    private:
+      const std::vector<std::string> ports_, probes_;
+      const shared_stamp Y_, H_;
+
+      std::vector<std::pair<circuit::entry_reference<float>, float>> A_;
+      std::vector<circuit::entry_reference<const float>> x_;
+      std::vector<float> values_; //reconstructed probes
+  };
+
+  /*!
+   * @brief reduced order linear dynamic block
+   *
+   * Holds G x + C x' = i on the port voltages plus q internal states, with G
+   * and C dense (p+q) x (p+q) row major matrices. C is integrated with the
+   * trapezoidal rule as a matrix Norton companion, the capacitive currents
+   * being kept as a recursion on the previous stamp.
+   */
+  class reduced_block : public component {
+    public:
+      reduced_block(std::string id,
+                    std::vector<std::string> ports,
+                    std::size_t q,
+                    shared_stamp G,
+                    shared_stamp C) :
+        component{ std::move(id) },
+        vars_{ std::move(ports) },
+        p_{ vars_.size() },
+        G_{ std::move(G) },
+        C_{ std::move(C) },
+        J_(vars_.size() + q, 0.0f),
+        v_(vars_.size() + q, 0.0f) {
+          for(std::size_t j = 0; j < q; ++j)
+            vars_.push_back(id_ + "#" + std::to_string(j));
+        }
+
+      virtual bool is_static()    const override { return false; }
+      virtual bool is_dynamic()   const override { return true; }
+      virtual bool is_nonlinear() const override { return false; }
+
+      virtual void register_(circuit::circuit& c) override {
+
+        const auto n = vars_.size();
+
+        for(auto&& v: vars_) c.register_node(v);
+
+        for(std::size_t i = 0; i < n; ++i)
+          for(std::size_t j = 0; j < n; ++j)
+            if((*G_)[i*n + j] != 0.0f || (*C_)[i*n + j] != 0.0f)
+              c.register_entry({vars_[i], vars_[j]});
+
+      }
+
+      virtual void setup(circuit::circuit& c) override {
+
+        const auto n = vars_.size();
+
+        A_.clear();
+        for(std::size_t i = 0; i < n; ++i)
+          for(std::size_t j = 0; j < n; ++j)
+            if((*G_)[i*n + j] != 0.0f || (*C_)[i*n + j] != 0.0f)
+              A_.push_back({c.get_A({vars_[i], vars_[j]}), i*n + j});
+
+        b_.clear();
+        x_.clear();
+        for(auto&& v: vars_) {
+          b_.push_back(c.get_b(v));
+          x_.push_back(c.get_state(v));
+        }
+
+        delta_t_ = c.get_delta_time();
+
+      }
+
+      virtual std::vector<std::string> terminals() const override {
+        std::vector<std::string> ts(vars_.begin(), vars_.begin() + p_);
+        ts.push_back("0");
+        return ts;
+      }
+
+      virtual ptr clone(const renamer& r) const override {
+        std::vector<std::string> ports;
+        for(auto i = 0u; i < p_; ++i) ports.push_back(r.node(vars_[i]));
+        return make_component<reduced_block>(r.id(id_), std::move(ports),
+                                             vars_.size() - p_, G_, C_);
+      }
+
+      virtual void fill() const noexcept override {
+
+        const auto n = vars_.size();
+        const auto k = 2.0f / *delta_t_;
+        const auto& G = *G_;
+        const auto& C = *C_;
+
+        for(std::size_t i = 0; i < n; ++i) v_[i] = *x_[i];
+
+        //j = C x' from the previous stamp, then the new history source
+        for(std::size_t i = 0; i < n; ++i) {
+          auto Cv = 0.0f;
+          for(std::size_t j = 0; j < n; ++j) Cv += C[i*n + j]*v_[j];
+          const auto j = k_*Cv + J_[i];
+          J_[i] = -(k*Cv + j);
+          *b_[i] -= J_[i];
+        }
+
+        for(auto&& [a, ij]: A_) *a += G[ij] + k*C[ij];
+
+        k_ = k;
+
+      }
+
+    private:
+      std::vector<std::string> vars_; //ports, then internal states
+      const std::size_t p_;
+      const shared_stamp G_, C_;
+
+      std::vector<std::pair<circuit::entry_reference<float>, std::size_t>> A_;
+      std::vector<circuit::entry_reference<float>> b_;
+      std::vector<circuit::entry_reference<const float>> x_;
+      const float *delta_t_;
+
+      mutable std::vector<float> J_, v_; //history sources, scratch
+      mutable float k_ = 0.0f;           //last 2/dt
+  };
+
+  /*!
+   * @brief continuous time model of a linear cluster
+   *
+   * x' = A x + B u and i = C x + D u, with x its n capacitor voltages and
+   * inductor currents, u its p port voltages and i the currents into it.
+   * F = [A B] and Y = [C D] are stored whole, H [x; u] are the voltages of
+   * its probed internal nodes.
+   */
+  struct state_space {
+    std::size_t n, p;
+    circuit::dense::matrix F, Y, H;
+  };
+
+  /*!
+   * @brief linear cluster discretized by its matrix exponential
+   *
+   * With u linear over each step (first order hold) the step is exact,
+   * x1 = Phi x0 + Ga u0 + Gb u1, with Phi, Ga and Gb read off the exponential
+   * of an augmented matrix. The ports see the Norton stamp C Gb + D, with the
+   * history source C (Phi x0 + Ga u0), so there is no frequency warping at
+   * any step size. prepare discretizes each step size the host will use,
+   * off the audio thread, and fill only looks them up.
+   */
+  class exponential_block : public component {
+    public:
+      exponential_block(std::string id,
+                        std::vector<std::string> ports,
+                        std::vector<std::string> probes,
+                        std::shared_ptr<const state_space> model) :
+        component{ std::move(id) },
+        ports_{ std::move(ports) },
+        probes_{ std::move(probes) },
+        model_{ std::move(model) },
+        s_(model_->n, 0.0f), next_(model_->n, 0.0f),
+        u_(model_->p, 0.0f), u1_(model_->p, 0.0f),
+        values_(probes_.size(), 0.0f) {}
+
+      virtual bool is_static()    const override { return false; }
+      virtual bool is_dynamic()   const override { return true; }
+      virtual bool is_nonlinear() const override { return false; }
+
+      virtual void register_(circuit::circuit& c) override {
+        for(auto&& n: ports_) c.register_node(n);
+        for(auto&& n: probes_) c.register_derived(n);
+        for(auto&& a: ports_)
+          for(auto&& b: ports_) c.register_entry({a, b});
+      }
+
+      virtual void setup(circuit::circuit& c) override {
+
+        A_.clear();
+        for(auto&& a: ports_)
+          for(auto&& b: ports_) A_.push_back(c.get_A({a, b}));
+
+        b_.clear();
+        v_.clear();
+        for(auto&& n: ports_) {
+          b_.push_back(c.get_b(n));
+          v_.push_back(c.get_state(n));
+        }
+
+        delta_t_ = c.get_delta_time();
+
+        for(std::size_t k = 0; k < probes_.size(); ++k)
+          c.bind_derived(probes_[k], &values_[k]);
+
+        c.register_commit(this);
+
+      }
+
+      virtual std::vector<std::string> terminals() const override {
+        auto ts = ports_;
+        ts.push_back("0");
+        return ts;
+      }
+
+      virtual ptr clone(const renamer& r) const override {
+        std::vector<std::string> ports, probes;
+        for(auto&& n: ports_)  ports.push_back(r.node(n));
+        for(auto&& n: probes_) probes.push_back(r.node(n));
+        return make_component<exponential_block>(r.id(id_), std::move(ports),
+                                                 std::move(probes), model_);
+      }
+
+      virtual void prepare(float delta_t) override {
+        auto it = steps_.find(delta_t);
+        if(it == steps_.end())
+          it = steps_.emplace(delta_t, discretize_(delta_t)).first;
+        d_ = &it->second;
+      }
+
+      virtual void fill() const noexcept override {
+
+        const auto n = model_->n, p = model_->p;
+
+        //never discretizes here, a step size nobody prepared for keeps the
+        //last one
+        const auto it = steps_.find(*delta_t_);
+        assert(it != steps_.end() && "exponential_block: step size not prepared");
+        if(it != steps_.end()) d_ = &it->second;
+        if(!d_) return;
+
+        const auto& d = *d_;
+
+        for(std::size_t k = 0; k < p; ++k) {
+          auto J = 0.0f;
+          for(std::size_t j = 0; j < n; ++j) J += d.Hx[k*n + j]*s_[j];
+          for(std::size_t j = 0; j < p; ++j) J += d.Hu[k*p + j]*u_[j];
+          *b_[k] -= J;
+        }
+
+        for(std::size_t kl = 0; kl < A_.size(); ++kl) *A_[kl] += d.G[kl];
+
+      }
+
+      virtual void commit() noexcept override {
+
+        if(!d_) return;
+
+        const auto n = model_->n, p = model_->p;
+        const auto& d = *d_;
+
+        for(std::size_t k = 0; k < p; ++k) u1_[k] = *v_[k];
+
+        for(std::size_t i = 0; i < n; ++i) {
+          auto x = 0.0f;
+          for(std::size_t j = 0; j < n; ++j) x += d.Phi[i*n + j]*s_[j];
+          for(std::size_t j = 0; j < p; ++j) x += d.Ga[i*p + j]*u_[j] + d.Gb[i*p + j]*u1_[j];
+          next_[i] = x;
+        }
+
+        s_.swap(next_);
+        u_.swap(u1_);
+
+        const auto& H = model_->H;
+        for(std::size_t k = 0; k < values_.size(); ++k) {
+          auto v = 0.0;
+          for(std::size_t j = 0; j < n; ++j) v += H(k, j)*s_[j];
+          for(std::size_t j = 0; j < p; ++j) v += H(k, n + j)*u_[j];
+          values_[k] = v;
+        }
+
+      }
+
+      const auto& ports()  const noexcept { return ports_; }
+      const auto& probes() const noexcept { return probes_; }
+      const auto& model()  const noexcept { return *model_; }
+
+      //step sizes discretized so far
+      auto prepared() const noexcept { return steps_.size(); }
+
+    private:
+      //one step size: the state update, and the Norton stamp C Gb + D with
+      //the history C Phi x0 + C Ga u0
+      struct discrete_ {
+        std::vector<float> Phi, Ga, Gb, G, Hx, Hu;
+      };
+
+      discrete_ discretize_(float h) const {
+
+        using circuit::dense::matrix;
+
+        const auto n = model_->n, p = model_->p;
+        const auto& F = model_->F;
+        const auto& Y = model_->Y;
+
+        //exp of [A B 0; 0 0 I/h; 0 0 0] h is [Phi G1 G2; 0 I I; 0 0 I],
+        //G1 the zero order hold response, G2 the one of the ramp
+        matrix M{n + 2*p, n + 2*p};
+        for(std::size_t i = 0; i < n; ++i)
+          for(std::size_t j = 0; j < n + p; ++j) M(i, j) = h*F(i, j);
+        for(std::size_t k = 0; k < p; ++k) M(n + k, n + p + k) = 1.0;
+
+        const auto E = circuit::dense::expm(M);
+
+        discrete_ d;
+        for(std::size_t i = 0; i < n; ++i)
+          for(std::size_t j = 0; j < n; ++j) d.Phi.push_back(E(i, j));
+        for(std::size_t i = 0; i < n; ++i)
+          for(std::size_t j = 0; j < p; ++j) {
+            d.Ga.push_back(E(i, n + j) - E(i, n + p + j));
+            d.Gb.push_back(E(i, n + p + j));
+          }
+
+        for(std::size_t k = 0; k < p; ++k) {
+          for(std::size_t j = 0; j < p; ++j) {
+            auto g = Y(k, n + j), hu = 0.0;
+            for(std::size_t i = 0; i < n; ++i) {
+              g  += Y(k, i)*E(i, n + p + j);
+              hu += Y(k, i)*(E(i, n + j) - E(i, n + p + j));
+            }
+            d.G.push_back(g);
+            d.Hu.push_back(hu);
+          }
+          for(std::size_t j = 0; j < n; ++j) {
+            auto hx = 0.0;
+            for(std::size_t i = 0; i < n; ++i) hx += Y(k, i)*E(i, j);
+            d.Hx.push_back(hx);
+          }
+        }
+
+        return d;
+      }
+
+      const std::vector<std::string> ports_, probes_;
+      const std::shared_ptr<const state_space> model_;
+
+      std::vector<circuit::entry_reference<float>> A_, b_; //p x p, then p
+      std::vector<circuit::entry_reference<const float>> v_;
+      const float *delta_t_;
+
+      std::map<float, discrete_> steps_;     //filled by prepare alone
+      mutable const discrete_* d_ = nullptr; //of the step being solved
+
+      std::vector<float> s_, next_; //states, at the last step and scratch
+      std::vector<float> u_, u1_;   //port voltages, likewise
+      std::vector<float> values_;   //reconstructed probes
+  };
+
+  /*!
+   * @brief group of magnetically coupled inductors
+   *
+   * Inductor k sits between NODE_A[k] and NODE_B[k], carrying @J{ID[k]}.
+   * With the inverse inductance matrix Gamma, i' = Gamma v, so the
+   * trapezoidal rule gives i = dt/2 Gamma v + J, with J the history of the
+   * previous step. The whole group is one dense Norton stamp, with no
+   * branch current unknowns; dt/2 Gamma is only rebuilt when dt changes.
+   */
+  class coupled_inductors : public component {
+    public:
+      coupled_inductors(std::string id,
+                        std::vector<std::string> names,
+                        std::vector<std::string> na,
+                        std::vector<std::string> nb,
+                        shared_stamp Gamma) :
+        component{ std::move(id) },
+        names_{ std::move(names) },
+        na_{ std::move(na) },
+        nb_{ std::move(nb) },
+        Gamma_{ std::move(Gamma) },
+        G_(Gamma_->size(), 0.0f),
+        J_(names_.size(), 0.0f),
+        v_(names_.size(), 0.0f),
+        j_(names_.size(), 0.0f) {}
+
+      virtual bool is_static()    const override { return false; }
+      virtual bool is_dynamic()   const override { return true; }
+      virtual bool is_nonlinear() const override { return false; }
+
+      virtual void register_(circuit::circuit& c) override {
+
+        const auto n = names_.size();
+
+        for(std::size_t k = 0; k < n; ++k) {
+          c.register_node(na_[k]);
+          c.register_node(nb_[k]);
+          c.register_derived("@J" + names_[k]);
+        }
+
+        for(std::size_t k = 0; k < n; ++k)
+          for(std::size_t l = 0; l < n; ++l)
+            if((*Gamma_)[k*n + l] != 0.0f) {
+              c.register_entry({na_[k], na_[l]});
+              c.register_entry({na_[k], nb_[l]});
+              c.register_entry({nb_[k], na_[l]});
+              c.register_entry({nb_[k], nb_[l]});
+            }
+
+      }
+
+      virtual void setup(circuit::circuit& c) override {
+
+        const auto n = names_.size();
+
+        A_.clear();
+        for(std::size_t k = 0; k < n; ++k)
+          for(std::size_t l = 0; l < n; ++l)
+            if((*Gamma_)[k*n + l] != 0.0f)
+              A_.push_back({{ c.get_A({na_[k], na_[l]}), c.get_A({na_[k], nb_[l]}),
+                              c.get_A({nb_[k], na_[l]}), c.get_A({nb_[k], nb_[l]}) },
+                            k*n + l});
+
+        ba_.clear();
+        bb_.clear();
+        a_t0_.clear();
+        b_t0_.clear();
+        for(std::size_t k = 0; k < n; ++k) {
+          ba_.push_back(c.get_b(na_[k]));
+          bb_.push_back(c.get_b(nb_[k]));
+          a_t0_.push_back(c.get_state(na_[k]));
+          b_t0_.push_back(c.get_state(nb_[k]));
+        }
+
+        delta_t_ = c.get_delta_time();
+
+        auto bound = false;
+        for(std::size_t k = 0; k < n; ++k)
+          bound |= c.bind_derived("@J" + names_[k], &j_[k]);
+
+        if(bound) c.register_commit(this);
+
+      }
+
+      virtual std::vector<std::string> terminals() const override {
+        std::vector<std::string> ts;
+        for(std::size_t k = 0; k < names_.size(); ++k) {
+          ts.push_back(na_[k]);
+          ts.push_back(nb_[k]);
+        }
+        return ts;
+      }
+
+      virtual ptr clone(const renamer& r) const override {
+        std::vector<std::string> names, na, nb;
+        for(std::size_t k = 0; k < names_.size(); ++k) {
+          names.push_back(r.id(names_[k]));
+          na.push_back(r.node(na_[k]));
+          nb.push_back(r.node(nb_[k]));
+        }
+        return make_component<coupled_inductors>(r.id(id_), std::move(names),
+                                                 std::move(na), std::move(nb), Gamma_);
+      }
+
+      virtual void fill() const noexcept override {
+
+        const auto n = names_.size();
+
+        for(std::size_t k = 0; k < n; ++k) v_[k] = *a_t0_[k] - *b_t0_[k];
+
+        //i = G v + J with the stamp in use, that is the current at t0
+        for(std::size_t k = 0; k < n; ++k) {
+          auto Gv = 0.0f;
+          for(std::size_t l = 0; l < n; ++l) Gv += G_[k*n + l]*v_[l];
+          J_[k] += Gv;
+        }
+
+        if(*delta_t_ != dt_) {
+          dt_ = *delta_t_;
+          for(std::size_t kl = 0; kl < G_.size(); ++kl) G_[kl] = 0.5f*dt_*(*Gamma_)[kl];
+        }
+
+        //next history source, J = i + G v
+        for(std::size_t k = 0; k < n; ++k) {
+          auto Gv = 0.0f;
+          for(std::size_t l = 0; l < n; ++l) Gv += G_[k*n + l]*v_[l];
+          J_[k] += Gv;
+          *ba_[k] -= J_[k];
+          *bb_[k] += J_[k];
+        }
+
+        for(auto&& [a, kl]: A_) {
+          const auto g = G_[kl];
+          *a[0] += g;
+          *a[1] -= g;
+          *a[2] -= g;
+          *a[3] += g;
+        }
+
+      }
+
+      virtual void commit() noexcept override {
+        const auto n = names_.size();
+        for(std::size_t k = 0; k < n; ++k) {
+          auto i = J_[k];
+          for(std::size_t l = 0; l < n; ++l)
+            i += G_[k*n + l]*(*a_t0_[l] - *b_t0_[l]);
+          j_[k] = i;
+        }
+      }
+
+      const auto& inductors()          const noexcept { return names_; }
+      const auto& inverse_inductance() const noexcept { return *Gamma_; }
+
+    private:
+      const std::vector<std::string> names_, na_, nb_;
+      const shared_stamp Gamma_;
+
+      std::vector<std::pair<std::array<circuit::entry_reference<float>, 4>, std::size_t>> A_;
+      std::vector<circuit::entry_reference<float>> ba_, bb_;
+      std::vector<circuit::entry_reference<const float>> a_t0_, b_t0_;
+      const float *delta_t_;
+
+      mutable std::vector<float> G_, J_, v_; //dt/2 Gamma, history, scratch
+      mutable float dt_ = 0.0f;              //dt of G_
+      std::vector<float> j_;                 //reconstructed branch currents
+  };
+
+}		// -----  end of namespace rtspice::components  -----
+
+#endif   // ----- #ifndef block_INC  -----
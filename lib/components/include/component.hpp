@@ -18,8 +18,11 @@
 #ifndef  component_INC
 #define  component_INC
 
+#include <cstdint>
+#include <map>
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace rtspice::circuit {
   class circuit;
@@ -27,6 +30,23 @@ namespace rtspice::circuit {
 
 namespace rtspice::components {
 
+  /*!
+   *  @brief maps the names of a subcircuit prototype onto an instance
+   */
+  struct renamer {
+
+    std::string prefix;                       //instance path, i.e. "X1."
+    std::map<std::string, std::string> ports; //formal to actual nodes
+
+    std::string node(const std::string& n) const {
+      if(n == "0") return n; //ground is global
+      const auto it = ports.find(n);
+      return it == ports.end() ? prefix + n : it->second;
+    }
+
+    std::string id(const std::string& i) const { return prefix + i; }
+  };
+
   /*!
    *  @brief component base class
    */
@@ -49,9 +69,34 @@ namespace rtspice::components {
 
       virtual void fill() const noexcept = 0;
 
+      //external nodes the component is connected to, used by netlist passes
+      virtual std::vector<std::string> terminals() const = 0;
+
+      //updates internal state after every converged time step, only called
+      //for components that asked for it through circuit::register_commit
+      virtual void commit() noexcept {}
+
+      //reads external parameters before a time step, true if the static stamp
+      //must be rebuilt. only called for components that asked for it through
+      //circuit::register_update
+      virtual bool update() noexcept { return false; }
+
+      //precomputes what steps of delta_t will need, called by circuit::prepare
+      //off the real-time thread, on dynamic components
+      virtual void prepare(float) {}
+
+      //piecewise linear nonlinear components: appends the linear segment each
+      //of its parts sits on at the current solution. when all nonlinear
+      //components are piecewise, the circuit searches regions instead of NR
+      virtual bool is_piecewise() const { return false; }
+      virtual void region(std::vector<std::uint8_t>&) const noexcept {}
+
       const auto& id() const noexcept { return id_; }
       using ptr = std::shared_ptr<component>;
 
+      //copy for a subcircuit instance, with nodes and id renamed
+      virtual ptr clone(const renamer& r) const = 0;
+
       virtual ~component() = default;
   };
 
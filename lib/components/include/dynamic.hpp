@@ -18,16 +18,108 @@
 #ifndef  dynamic_INC
 #define  dynamic_INC
 
+#include <array>
+#include <utility>
+
 #include "component.hpp"
 #include "circuit.hpp"
 
 namespace rtspice::components {
 
+  /*!
+   *  @brief  integration methods, the policies of dynamic and companion
+   *
+   *  Each one discretizes u' = s w over a step h as u = P + K w at its end,
+   *  returning K and P from u and w at its start, plus whatever it keeps in
+   *  states. A capacitor integrates its current into its voltage with
+   *  s = 1/C, an inductor its voltage into its current with s = 1/L.
+   *
+   *  The trapezoidal rule damps nothing, so stiff modes are left ringing at
+   *  the Nyquist frequency. Backward Euler and BDF2 damp them, at the cost of
+   *  some damping in the audio band, the first much more. TR-BDF2 has the
+   *  circuit split every step in a trapezoidal stage and a BDF2 one, which
+   *  damps as BDF2 does for twice the solves.
+   */
+  namespace integration {
+
+    //unspecified is what a line naming no method gets, the METHOD option
+    //moves those and only those
+    enum class method { unspecified, be, tr, bdf2, tr_bdf2 };
+
+    struct backward_euler {
+      void setup(circuit::circuit&) {}
+
+      auto operator()(float u, float, float h, float s) noexcept {
+        return std::make_pair(h*s, u);
+      }
+    };
+
+    struct trapezoidal {
+      void setup(circuit::circuit&) {}
+
+      auto operator()(float u, float w, float h, float s) noexcept {
+        const auto K = 0.5f*h*s;
+        return std::make_pair(K, u + K*w);
+      }
+    };
+
+    //the trapezoidal rule, for lines left without a method
+    struct unspecified : trapezoidal {};
+
+    /*!
+     * @brief second order backward differences, for steps of any size
+     *
+     * With r = h/h0 the ratio to the step before, u = ((1+r)^2 u0 - r^2 u1
+     * + (1+r) h s w)/(1+2r), u1 being u a step earlier. The first step has
+     * no such history and is taken by backward Euler.
+     */
+    struct bdf2 {
+      std::array<float, 2> states{ 0.0f, 0.0f }; //u and h of the last step
+
+      void setup(circuit::circuit&) {}
+
+      auto operator()(float u, float, float h, float s) noexcept {
+        const auto [u1, h0] = states;
+        states = { u, h };
+
+        if(h0 == 0.0f) return std::make_pair(h*s, u);
+
+        const auto r = h/h0, d = 1.0f + 2.0f*r;
+        return std::make_pair((1.0f + r)*h*s/d,
+                              ((1.0f + r)*(1.0f + r)*u - r*r*u1)/d);
+      }
+    };
+
+    /*!
+     * @brief trapezoidal rule to the first stage of the step, BDF2 over both
+     */
+    struct tr_bdf2 {
+      void setup(circuit::circuit& c) {
+        c.split_steps();
+        stage_ = c.get_stage();
+      }
+
+      auto operator()(float u, float w, float h, float s) noexcept {
+        if(*stage_ == 2) return second_(u, w, h, s);
+        second_.states = { u, h };
+        return trapezoidal{}(u, w, h, s);
+      }
+
+      private:
+        bdf2 second_;
+        const unsigned *stage_ = nullptr;
+    };
+
+  }		// -----  end of namespace integration  -----
+
   /*!
    *  @brief  basic dynamic component template, optimized for
    *  modified nodal analysis
+   *
+   *  F turns the integration method M into the branch equation
+   *  v = R j + V; the trapezoidal rule unless the netlist asks otherwise.
    */
-  template<class F>
+  template<class F, class M = integration::unspecified>
   class dynamic : public component {
     public:
       template<class... Args>
@@ -75,14 +167,26 @@ namespace rtspice::components {
 
         delta_t_ = c.get_delta_time();
 
+        m_.setup(c);
+
+      }
+
+      virtual std::vector<std::string> terminals() const override {
+        return {na_, nb_};
       }
 
+      virtual ptr clone(const renamer& r) const override {
+        return make_component<dynamic>(r.id(id_), r.node(na_), r.node(nb_), f_);
+      }
+
+      const F& function() const noexcept { return f_; }
+
       virtual void fill() const noexcept override {
 
         const auto vt0 = *a_t0_ - *b_t0_;
         const auto jt0 = *j_t0_;
 
-        const auto [R_dyn, V_dyn] = f_(vt0, jt0, *delta_t_);
+        const auto [R_dyn, V_dyn] = f_(m_, vt0, jt0, *delta_t_);
 
         *Aaj_ += 1.0;
         *Abj_ -= 1.0;
@@ -97,6 +201,7 @@ namespace rtspice::components {
     private:
       const std::string na_, nb_, nj_;
       const F f_;
+      mutable M m_;
       circuit::entry_reference<float> Aaj_, Abj_, Aja_, Ajb_, Ajj_;
       circuit::entry_reference<float> bj_;
 
@@ -105,21 +210,177 @@ namespace rtspice::components {
   };
 
   /*!
-   * @brief dynamic behaviour associated with a linear capacitor using a 
-   * trapezoidal integration scheme.
+   *  @brief  dynamic component template using a Norton companion model
+   *
+   *  Unlike dynamic<F>, no branch current unknown is added to the system: the
+   *  device is stamped as a conductance in parallel with a history current
+   *  source, directly on na and nb. F must have an operator() accepting the
+   *  integration method M, previous voltage, previous current and time step,
+   *  returning G and J such that j(t+dt) = G*v(t+dt) + J.
+   *
+   *  The branch current is kept as a recursion on the stamped values, and is
+   *  only reconstructed after each step when a PROBE asks for "@J"+id.
    */
-  class linear_capacitor_trapezoidal {
+  template<class F, class M = integration::unspecified>
+  class companion : public component {
     public:
+      template<class... Args>
+      companion(std::string id,
+                std::string na,
+                std::string nb,
+                Args&&... args) :
+        component{ std::move(id) },
+        na_{ std::move(na) },
+        nb_{ std::move(nb) },
+        nj_{ "@J"+id_ },
+        f_( std::forward<Args>(args)... ) {}
+
+      virtual bool is_static()    const override { return false; }
+      virtual bool is_dynamic()   const override { return F::dynamic_v; }
+      virtual bool is_nonlinear() const override { return false; }
+
+      virtual void register_(circuit::circuit& c) override {
+
+        c.register_node(na_);
+        c.register_node(nb_);
+        c.register_derived(nj_);
+
+        c.register_entry({na_, na_});
+        c.register_entry({na_, nb_});
+        c.register_entry({nb_, na_});
+        c.register_entry({nb_, nb_});
+
+      }
+
+      virtual void setup(circuit::circuit& c) override {
+
+        Aaa_ = c.get_A({na_, na_});
+        Aab_ = c.get_A({na_, nb_});
+        Aba_ = c.get_A({nb_, na_});
+        Abb_ = c.get_A({nb_, nb_});
+
+        ba_  = c.get_b(na_);
+        bb_  = c.get_b(nb_);
+
+        a_t0_ = c.get_state(na_);
+        b_t0_ = c.get_state(nb_);
+
+        delta_t_ = c.get_delta_time();
+
+        if(c.bind_derived(nj_, &j_))
+          c.register_commit(this);
+
+        m_.setup(c);
+
+      }
+
+      virtual std::vector<std::string> terminals() const override {
+        return {na_, nb_};
+      }
+
+      virtual ptr clone(const renamer& r) const override {
+        return make_component<companion>(r.id(id_), r.node(na_), r.node(nb_), f_);
+      }
+
+      const F& function() const noexcept { return f_; }
+
+      virtual void fill() const noexcept override {
+
+        const auto vt0 = *a_t0_ - *b_t0_;
+        const auto jt0 = G_*vt0 + J_; //current from the previous stamp
 
+        const auto [G, J] = f_(m_, vt0, jt0, *delta_t_);
+
+        *Aaa_ += G;
+        *Aab_ -= G;
+        *Aba_ -= G;
+        *Abb_ += G;
+
+        *ba_  -= J;
+        *bb_  += J;
+
+        G_ = G;
+        J_ = J;
+
+      }
+
+      virtual void commit() noexcept override {
+        j_ = G_*(*a_t0_ - *b_t0_) + J_;
+      }
+
+    private:
+      const std::string na_, nb_, nj_;
+      const F f_;
+      mutable M m_;
+      circuit::entry_reference<float> Aaa_, Aab_, Aba_, Abb_;
+      circuit::entry_reference<float> ba_, bb_;
+
+      circuit::entry_reference<const float> a_t0_, b_t0_;
+      const float *delta_t_;
+
+      mutable float G_ = 0.0f, J_ = 0.0f; //last stamp, keeps the history
+      float j_ = 0.0f;                    //reconstructed branch current
+  };
+
+  /*!
+   * @brief branch equation of a linear capacitor, v = P + K j
+   */
+  class linear_capacitor_branch {
+    public:
+      static constexpr bool dynamic_v = true;
+
+      linear_capacitor_branch(float C) :
+        S_( 1.0 / C ) {}
+
+      float capacitance() const noexcept { return 1.0f / S_; }
+
+      template<class M>
+      inline auto operator()(M& m, float v, float j, float delta_t) const noexcept {
+        return m(v, j, delta_t, S_);
+      }
+
+    private:
+      const float S_;
+  };
+
+  /*!
+   * @brief branch equation of a linear inductor, j = P + K v
+   */
+  class linear_inductor_branch {
+    public:
+      static constexpr bool dynamic_v = true;
+
+      linear_inductor_branch(float L) :
+        S_( 1.0 / L ) {}
+
+      float inductance() const noexcept { return 1.0f / S_; }
+
+      template<class M>
+      inline auto operator()(M& m, float v, float j, float delta_t) const noexcept {
+        const auto [K, P] = m(j, v, delta_t, S_);
+        return std::make_pair(1.0f/K, -P/K);
+      }
+
+    private:
+      const float S_;
+  };
+
+  /*!
+   * @brief Norton companion of a linear capacitor
+   */
+  class linear_capacitor_norton {
+    public:
       static constexpr bool dynamic_v = true;
 
-      linear_capacitor_trapezoidal(float C) :
-        S_( 0.5 / C ) {}
+      linear_capacitor_norton(float C) :
+        S_( 1.0 / C ) {}
 
-      inline auto operator()(float v, float j, float delta_t) const noexcept {
-        const auto R = delta_t*S_;
-        const auto V = v + R*j;
-        return std::make_pair(R, V);
+      float capacitance() const noexcept { return 1.0f / S_; }
+
+      template<class M>
+      inline auto operator()(M& m, float v, float j, float delta_t) const noexcept {
+        const auto [K, P] = m(v, j, delta_t, S_);
+        return std::make_pair(1.0f/K, -P/K);
       }
 
     private:
@@ -127,27 +388,135 @@ namespace rtspice::components {
   };
 
   /*!
-   * @brief dynamic behaviour associated with a linear inductor using a 
-   * trapezoidal integration scheme.
+   * @brief Norton companion of a linear inductor
    */
-  class linear_inductor_trapezoidal {
+  class linear_inductor_norton {
     public:
       static constexpr bool dynamic_v = true;
 
-      linear_inductor_trapezoidal(float L) :
-        L_( 2.0 * L ) {}
+      linear_inductor_norton(float L) :
+        S_( 1.0 / L ) {}
+
+      float inductance() const noexcept { return 1.0f / S_; }
+
+      template<class M>
+      inline auto operator()(M& m, float v, float j, float delta_t) const noexcept {
+        return m(j, v, delta_t, S_);
+      }
+
+    private:
+      const float S_;
+  };
+
+  /*!
+   *  @brief  K line: mutual coupling K between two inductors, given by id
+   *
+   *  Stamps nothing, the couple_inductors pass replaces every group of
+   *  coupled inductors by a single coupled_inductors block.
+   */
+  class inductor_coupling : public component {
+    public:
+      inductor_coupling(std::string id,
+                        std::string la,
+                        std::string lb,
+                        float k) :
+        component{ std::move(id) },
+        la_{ std::move(la) },
+        lb_{ std::move(lb) },
+        k_{ k } {}
+
+      virtual bool is_static()    const override { return true; }
+      virtual bool is_dynamic()   const override { return false; }
+      virtual bool is_nonlinear() const override { return false; }
 
-      inline auto operator()(float v, float j, float delta_t) const noexcept {
-        const auto R = L_/delta_t;
-        const auto V = v + R*j;
-        return std::make_pair(R, -V); //source sign is reversed
+      virtual void register_(circuit::circuit&) override {}
+      virtual void setup(circuit::circuit&) override {}
+      virtual void fill() const noexcept override {}
+
+      virtual std::vector<std::string> terminals() const override { return {}; }
+
+      virtual ptr clone(const renamer& r) const override {
+        return make_component<inductor_coupling>(r.id(id_), r.id(la_), r.id(lb_), k_);
       }
+
+      const std::string& first()  const noexcept { return la_; }
+      const std::string& second() const noexcept { return lb_; }
+      float coefficient()         const noexcept { return k_; }
+
     private:
-      const float L_;
+      const std::string la_, lb_;
+      const float k_;
   };
 
-  using linear_capacitor = dynamic<linear_capacitor_trapezoidal>;
-  using linear_inductor  = dynamic<linear_inductor_trapezoidal>;
+  using linear_capacitor = dynamic<linear_capacitor_branch>;
+  using linear_inductor  = dynamic<linear_inductor_branch>;
+
+  using norton_capacitor = companion<linear_capacitor_norton>;
+  using norton_inductor  = companion<linear_inductor_norton>;
+
+  /*!
+   *  @brief  D<F, M>, with the method M picked at run time
+   */
+  template<template<class, class> class D, class F, class... Args>
+  component::ptr make_integrated(integration::method m, Args&&... args) {
+    using namespace integration;
+    switch(m) {
+      case method::be:
+        return make_component<D<F, backward_euler>>(std::forward<Args>(args)...);
+      case method::bdf2:
+        return make_component<D<F, bdf2>>(std::forward<Args>(args)...);
+      case method::tr_bdf2:
+        return make_component<D<F, tr_bdf2>>(std::forward<Args>(args)...);
+      case method::tr:
+        return make_component<D<F, trapezoidal>>(std::forward<Args>(args)...);
+      default:
+        return make_component<D<F, unspecified>>(std::forward<Args>(args)...);
+    }
+  }
+
+  namespace detail {
+
+    template<class T, class G>
+    float value_of(const component& c, G get) {
+      const auto p = dynamic_cast<const T*>(&c);
+      return p ? (p->function().*get)() : 0.0f;
+    }
+
+    template<class... M>
+    float capacitance(const component& c) {
+      return ((value_of<dynamic<linear_capacitor_branch, M>>(c, &linear_capacitor_branch::capacitance) +
+               value_of<companion<linear_capacitor_norton, M>>(c, &linear_capacitor_norton::capacitance)) + ... + 0.0f);
+    }
+
+    template<class... M>
+    float inductance(const component& c) {
+      return ((value_of<dynamic<linear_inductor_branch, M>>(c, &linear_inductor_branch::inductance) +
+               value_of<companion<linear_inductor_norton, M>>(c, &linear_inductor_norton::inductance)) + ... + 0.0f);
+    }
+
+  }		// -----  end of namespace detail  -----
+
+  //of a linear capacitor or inductor under any method, 0 for anything else
+  inline float capacitance(const component& c) {
+    using namespace integration;
+    return detail::capacitance<unspecified, backward_euler, trapezoidal, bdf2, tr_bdf2>(c);
+  }
+
+  inline float inductance(const component& c) {
+    using namespace integration;
+    return detail::inductance<unspecified, backward_euler, trapezoidal, bdf2, tr_bdf2>(c);
+  }
+
+  //the same, only under the trapezoidal rule, picked or not
+  inline float trapezoidal_capacitance(const component& c) {
+    using namespace integration;
+    return detail::capacitance<unspecified, trapezoidal>(c);
+  }
+
+  inline float trapezoidal_inductance(const component& c) {
+    using namespace integration;
+    return detail::inductance<unspecified, trapezoidal>(c);
+  }
 
 }		// -----  end of namespace rtspice::components  -----
 
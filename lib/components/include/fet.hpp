@@ -0,0 +1,218 @@
+/*!
+ *    @file  fet.hpp
+ *   @brief  field effect transistor definitions
+ *
+ *  @author  Thadeu Luiz Barbosa Dias (tlbd)
+ *
+ *  @internal
+ *       Created:  10/18/2026
+ *      Revision:  none
+ *      Compiler:  g++
+ *  Organization:  SMT - Signals, Multimedia and Telecommunications Lab
+ *     Copyright:  Copyright (c) 2019, Thadeu Luiz Barbosa Dias
+ *
+ *  This source code is released for free distribution under the terms of the
+ *  GNU General Public License as published by the Free Software Foundation.
+ */
+
+#ifndef  fet_INC
+#define  fet_INC
+
+#include <string>
+#include <vector>
+
+#include "component.hpp"
+#include "circuit.hpp"
+#include "sources.hpp"
+
+namespace rtspice::components {
+
+  /*!
+   * @brief one Shichman-Hodges device
+   *
+   * Drain current ID = beta/2 (Vgs - VTO)^2 (1 + LAMBDA Vds) in saturation.
+   * SPICE writes the JFET one as BETA (Vgs - VTO)^2, so JFETs store twice
+   * their BETA.
+   */
+  struct fet_device {
+
+    enum class type { nmos, pmos, njf, pjf };
+
+    fet_device(std::string nd, std::string ng, std::string ns,
+               type t, float VTO, float beta, float lambda) :
+      nd{ std::move(nd) }, ng{ std::move(ng) }, ns{ std::move(ns) },
+      polarity{ t == type::nmos || t == type::njf ? 1.0f : -1.0f },
+      //p-channel thresholds are given as seen from the source
+      VTO{ polarity*VTO },
+      beta{ t == type::njf || t == type::pjf ? 2.0f*beta : beta },
+      lambda{ lambda } {}
+
+    std::string nd, ng, ns;
+    float polarity, VTO, beta, lambda;
+  };
+
+  /*!
+   * @brief batch of FETs, evaluated together in one vectorized pass
+   *
+   * Parameters are kept as contiguous arrays: fill gathers every Vgs and Vds,
+   * runs the square law over all devices at once and only then stamps them.
+   * Each netlist line makes a batch of one, the batch_fets pass then merges
+   * all of them, so several FETs cost about as much as one.
+   */
+  class fet_array : public component {
+    public:
+      virtual bool is_static()    const override { return false; }
+      virtual bool is_dynamic()   const override { return false; }
+      virtual bool is_nonlinear() const override { return true; }
+
+      fet_array(std::string id,
+                std::string nd,
+                std::string ng,
+                std::string ns,
+                fet_device::type t,
+                float VTO,
+                float beta,
+                float lambda) :
+        fet_array{ std::move(id), {{ std::move(nd), std::move(ng), std::move(ns),
+                                     t, VTO, beta, lambda }} } {}
+
+      fet_array(std::string id, std::vector<fet_device> devices) :
+        component{ std::move(id) },
+        devices_{ std::move(devices) } {
+
+        const auto n = devices_.size();
+
+        for(auto&& d: devices_) {
+          polarity_.push_back(d.polarity);
+          VTO_.push_back(d.VTO);
+          beta_.push_back(d.beta);
+          lambda_.push_back(d.lambda);
+          branches_.push_back({ d.nd, d.ns, {&d.ng, &d.nd} });
+        }
+
+        xd_.resize(n);
+        xg_.resize(n);
+        xs_.resize(n);
+
+        vgs_.resize(n);
+        vds_.resize(n);
+        ids_.resize(n);
+        gm_.resize(n);
+        gds_.resize(n);
+      }
+
+      virtual void register_(circuit::circuit& c) override {
+        for(auto&& d: devices_) {
+          c.register_node(d.nd);
+          c.register_node(d.ng);
+          c.register_node(d.ns);
+        }
+        for(auto&& b: branches_) b.register_(c);
+      }
+
+      virtual void setup(circuit::circuit& c) override {
+        for(std::size_t i = 0; i < devices_.size(); ++i) {
+          branches_[i].setup(c);
+          xd_[i] = c.get_x(devices_[i].nd);
+          xg_[i] = c.get_x(devices_[i].ng);
+          xs_[i] = c.get_x(devices_[i].ns);
+        }
+      }
+
+      virtual std::vector<std::string> terminals() const override {
+        std::vector<std::string> ts;
+        for(auto&& d: devices_) {
+          ts.push_back(d.nd);
+          ts.push_back(d.ng);
+          ts.push_back(d.ns);
+        }
+        return ts;
+      }
+
+      virtual ptr clone(const renamer& r) const override {
+        auto devices = devices_;
+        for(auto&& d: devices) {
+          d.nd = r.node(d.nd);
+          d.ng = r.node(d.ng);
+          d.ns = r.node(d.ns);
+        }
+        return make_component<fet_array>(r.id(id_), std::move(devices));
+      }
+
+      virtual void fill() const noexcept override {
+
+        const auto n = devices_.size();
+
+        for(std::size_t i = 0; i < n; ++i) {
+          vgs_[i] = *xg_[i] - *xs_[i];
+          vds_[i] = *xd_[i] - *xs_[i];
+        }
+
+        evaluate_(n, polarity_.data(), VTO_.data(), beta_.data(), lambda_.data(),
+                  vgs_.data(), vds_.data(), ids_.data(), gm_.data(), gds_.data());
+
+        for(std::size_t i = 0; i < n; ++i)
+          branches_[i].fill(ids_[i], {gm_[i], gds_[i]}, {vgs_[i], vds_[i]});
+
+      }
+
+      const auto& devices() const noexcept { return devices_; }
+
+    private:
+      //drain to source current and its partials, branch free so it vectorizes
+      static void evaluate_(std::size_t n,
+                            const float* __restrict polarity,
+                            const float* __restrict VTO,
+                            const float* __restrict beta,
+                            const float* __restrict lambda,
+                            const float* __restrict vgs,
+                            const float* __restrict vds,
+                            float* __restrict id,
+                            float* __restrict gm,
+                            float* __restrict gds) noexcept {
+
+        #pragma omp simd
+        for(std::size_t i = 0; i < n; ++i) {
+
+          //n-channel view of the device
+          const auto p  = polarity[i];
+          const auto gs = p*vgs[i];
+          const auto ds = p*vds[i];
+
+          //drain and source swap roles on negative Vds
+          const auto fwd = ds >= 0.0f;
+          const auto v   = fwd ? ds : -ds;
+          const auto ov  = (fwd ? gs : gs - ds) - VTO[i];
+
+          const auto on  = ov > 0.0f;
+          const auto sat = v >= ov;
+          const auto cl  = 1.0f + lambda[i]*v;
+          const auto b   = on ? beta[i] : 0.0f;
+
+          const auto q   = sat ? 0.5f*ov*ov : ov*v - 0.5f*v*v;
+          const auto dq1 = sat ? ov : v;         //against the overdrive
+          const auto dq2 = sat ? 0.0f : ov - v;  //against |Vds|
+
+          const auto I  = b*q*cl;
+          const auto g1 = b*dq1*cl;
+          const auto g2 = b*(dq2*cl + q*lambda[i]);
+
+          //back to terminal voltages and to the device polarity
+          id[i]  = p*(fwd ? I : -I);
+          gm[i]  = fwd ? g1 : -g1;
+          gds[i] = fwd ? g2 : g1 + g2;
+        }
+      }
+
+      const std::vector<fet_device> devices_;
+      std::vector<float> polarity_, VTO_, beta_, lambda_;
+
+      std::vector<controlled_branch<2>> branches_;
+      std::vector<circuit::entry_reference<const float>> xd_, xg_, xs_;
+
+      mutable std::vector<float> vgs_, vds_, ids_, gm_, gds_; //scratch
+  };
+
+}		// -----  end of namespace rtspice::components  -----
+
+#endif   // ----- #ifndef fet_INC  -----
@@ -0,0 +1,141 @@
+/*!
+ *    @file  line.hpp
+ *   @brief  lossless delay line
+ *
+ *  @author  Thadeu Luiz Barbosa Dias (tlbd)
+ *
+ *  @internal
+ *       Created:  10/18/2026
+ *      Revision:  none
+ *      Compiler:  g++
+ *  Organization:  SMT - Signals, Multimedia and Telecommunications Lab
+ *     Copyright:  Copyright (c) 2019, Thadeu Luiz Barbosa Dias
+ *
+ *  This source code is released for free distribution under the terms of the
+ *  GNU General Public License as published by the Free Software Foundation.
+ */
+
+#ifndef  line_INC
+#define  line_INC
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "component.hpp"
+#include "circuit.hpp"
+
+namespace rtspice::components {
+
+  /*!
+   * @brief ideal transmission line between ports A and B, delaying by steps
+   *
+   * Each port is a conductance 1/Z0 fed by the wave that left the other one
+   * steps ago: v = Z0 i + h, with i into the line and h read from a ring
+   * buffer, which then takes 2 v - h for the other port. Nothing couples
+   * the two ports within a step, so the system splits into independent
+   * blocks at every line. The rings are allocated at load time; a split
+   * step only moves them once, after its second stage.
+   */
+  class delay_line : public component {
+    public:
+      delay_line(std::string id,
+                 std::string pa,
+                 std::string ma,
+                 std::string pb,
+                 std::string mb,
+                 float z0,
+                 unsigned steps) :
+        component{ std::move(id) },
+        pa_{ std::move(pa) }, ma_{ std::move(ma) },
+        pb_{ std::move(pb) }, mb_{ std::move(mb) },
+        z0_{ z0 },
+        G_{ 1.0f/z0 },
+        to_a_(std::max(steps, 1u), 0.0f),
+        to_b_(std::max(steps, 1u), 0.0f) {}
+
+      virtual bool is_static()    const override { return false; }
+      virtual bool is_dynamic()   const override { return true; }
+      virtual bool is_nonlinear() const override { return false; }
+
+      virtual void register_(circuit::circuit& c) override {
+        for(auto&& [p, m]: {std::pair{pa_, ma_}, std::pair{pb_, mb_}}) {
+          c.register_node(p);
+          c.register_node(m);
+
+          c.register_entry({p, p});
+          c.register_entry({p, m});
+          c.register_entry({m, p});
+          c.register_entry({m, m});
+        }
+      }
+
+      virtual void setup(circuit::circuit& c) override {
+        a_ = { c.get_A({pa_, pa_}), c.get_A({pa_, ma_}), c.get_A({ma_, pa_}),
+               c.get_A({ma_, ma_}), c.get_b(pa_), c.get_b(ma_),
+               c.get_state(pa_), c.get_state(ma_) };
+        b_ = { c.get_A({pb_, pb_}), c.get_A({pb_, mb_}), c.get_A({mb_, pb_}),
+               c.get_A({mb_, mb_}), c.get_b(pb_), c.get_b(mb_),
+               c.get_state(pb_), c.get_state(mb_) };
+
+        stage_ = c.get_stage();
+        c.register_commit(this);
+      }
+
+      virtual std::vector<std::string> terminals() const override {
+        return {pa_, ma_, pb_, mb_};
+      }
+
+      virtual ptr clone(const renamer& r) const override {
+        return make_component<delay_line>(r.id(id_), r.node(pa_), r.node(ma_),
+                                          r.node(pb_), r.node(mb_), z0_, steps());
+      }
+
+      virtual void fill() const noexcept override {
+        stamp_(a_, to_a_[pos_]);
+        stamp_(b_, to_b_[pos_]);
+      }
+
+      virtual void commit() noexcept override {
+        if(*stage_ == 1) return;
+
+        const auto ha = to_a_[pos_], hb = to_b_[pos_];
+        to_b_[pos_] = 2.0f*(*a_.p - *a_.m) - ha;
+        to_a_[pos_] = 2.0f*(*b_.p - *b_.m) - hb;
+
+        if(++pos_ == to_a_.size()) pos_ = 0;
+      }
+
+      float    impedance() const noexcept { return z0_; }
+      unsigned steps()     const noexcept { return to_a_.size(); }
+
+    private:
+      struct port_ {
+        circuit::entry_reference<float> App, Apm, Amp, Amm, bp, bm;
+        circuit::entry_reference<const float> p, m;
+      };
+
+      void stamp_(const port_& s, float h) const noexcept {
+        *s.App += G_;
+        *s.Apm -= G_;
+        *s.Amp -= G_;
+        *s.Amm += G_;
+
+        *s.bp  += G_*h;
+        *s.bm  -= G_*h;
+      }
+
+      const std::string pa_, ma_, pb_, mb_;
+      const float z0_, G_;
+
+      port_ a_, b_;
+      const unsigned* stage_ = nullptr;
+
+      //waves headed to each port, written steps before they arrive
+      std::vector<float> to_a_, to_b_;
+      std::size_t pos_ = 0;
+  };
+
+}		// -----  end of namespace rtspice::components  -----
+
+#endif   // ----- #ifndef line_INC  -----
@@ -20,6 +20,7 @@
 
 #include "component.hpp"
 #include "circuit.hpp"
+#include "sources.hpp"
 
 namespace rtspice::components {
 
@@ -29,6 +30,10 @@ namespace rtspice::components {
    * output nodes: na, nb; control nodes nc, nd.
    * This model assumes linear stable operation, such that VC == VD
    *
+   * The opamp is a nullor, so it is folded into the node numbering at load
+   * time: the output current is never an unknown, the output equations are
+   * merged and both inputs share the same voltage unknown.
+   *
    */
   class ideal_opamp : public component {
     public:
@@ -41,8 +46,7 @@ namespace rtspice::components {
         na_{ std::move(na) },
         nb_{ std::move(nb) },
         nc_{ std::move(nc) },
-        nd_{ std::move(nd) },
-        nj_{ "@J" + id_ } {}
+        nd_{ std::move(nd) } {}
 
       virtual bool is_static()    const override { return true; }
       virtual bool is_dynamic()   const override { return false; }
@@ -54,36 +58,37 @@ namespace rtspice::components {
         c.register_node(nb_);
         c.register_node(nc_);
         c.register_node(nd_);
-        c.register_node(nj_);
 
-        c.register_entry({na_, nj_});
-        c.register_entry({nb_, nj_});
-        c.register_entry({nj_, nc_});
-        c.register_entry({nj_, nd_});
+        c.register_nullor({na_, nb_}, {nc_, nd_});
 
       }
 
-      virtual void setup(circuit::circuit& c) override {
-
-        Aaj_  = c.get_A({na_, nj_});
-        Abj_  = c.get_A({nb_, nj_});
-        Ajc_  = c.get_A({nj_, nc_});
-        Ajd_  = c.get_A({nj_, nd_});
+      virtual void setup(circuit::circuit&) override {}
 
+      virtual std::vector<std::string> terminals() const override {
+        return {na_, nb_, nc_, nd_};
       }
 
-      virtual void fill() const noexcept override {
-        *Aaj_ += 1.0;
-        *Abj_ -= 1.0;
-        *Ajc_ += 1.0;
-        *Ajd_ -= 1.0;
+      virtual ptr clone(const renamer& r) const override {
+        return make_component<ideal_opamp>(r.id(id_), r.node(na_), r.node(nb_),
+                                           r.node(nc_), r.node(nd_));
       }
 
+      virtual void fill() const noexcept override {}
+
     private:
-      const std::string na_, nb_, nc_, nd_, nj_;
-      circuit::entry_reference<float> Aaj_, Abj_, Ajc_, Ajd_;
+      const std::string na_, nb_, nc_, nd_;
   };
 
+  /*!
+   * @brief opamp macromodel with finite gain, clipping smoothly at its rails
+   *
+   * A single nonlinear controlled source, see rail_transfer. Unlike an ideal
+   * opamp clamped by diodes to the supplies, it adds one unknown and no
+   * exponential to the Newton iterations.
+   */
+  using rail_opamp = vcvs<rail_transfer>;
+
 }		// -----  end of namespace rtspice::components  -----
 
 
@@ -0,0 +1,133 @@
+/*!
+ *    @file  options.hpp
+ *   @brief  simulation options and model statements
+ *
+ *  @author  Thadeu Luiz Barbosa Dias (tlbd)
+ *
+ *  @internal
+ *       Created:  10/18/2026
+ *      Revision:  none
+ *      Compiler:  g++
+ *  Organization:  SMT - Signals, Multimedia and Telecommunications Lab
+ *     Copyright:  Copyright (c) 2019, Thadeu Luiz Barbosa Dias
+ *
+ *  This source code is released for free distribution under the terms of the
+ *  GNU General Public License as published by the Free Software Foundation.
+ */
+
+#ifndef  options_INC
+#define  options_INC
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "component.hpp"
+#include "circuit.hpp"
+
+namespace rtspice::components {
+
+  /*!
+   *  @brief  .OPTIONS line: stamps nothing, only carries named values read by
+   *  the netlist passes
+   */
+  class options : public component {
+    public:
+      using list = std::vector<std::pair<std::string, float>>;
+
+      options(list values) :
+        component{ ".OPTIONS" },
+        values_{ std::move(values) } {}
+
+      virtual bool is_static()    const override { return true; }
+      virtual bool is_dynamic()   const override { return false; }
+      virtual bool is_nonlinear() const override { return false; }
+
+      virtual void register_(circuit::circuit&) override {}
+      virtual void setup(circuit::circuit&) override {}
+      virtual void fill() const noexcept override {}
+
+      virtual std::vector<std::string> terminals() const override { return {}; }
+
+      virtual ptr clone(const renamer&) const override {
+        return make_component<options>(values_);
+      }
+
+      const auto& values() const noexcept { return values_; }
+
+    private:
+      const list values_;
+  };
+
+  /*!
+   *  @brief  .MODEL line: stamps nothing, the model itself is kept by the
+   *  parser and shared by the devices referencing it
+   */
+  class model_card : public component {
+    public:
+      model_card(std::string name) :
+        component{ ".MODEL " + std::move(name) } {}
+
+      virtual bool is_static()    const override { return true; }
+      virtual bool is_dynamic()   const override { return false; }
+      virtual bool is_nonlinear() const override { return false; }
+
+      virtual void register_(circuit::circuit&) override {}
+      virtual void setup(circuit::circuit&) override {}
+      virtual void fill() const noexcept override {}
+
+      virtual std::vector<std::string> terminals() const override { return {}; }
+
+      virtual ptr clone(const renamer&) const override {
+        return make_component<model_card>(id_.substr(7));
+      }
+  };
+
+  /*!
+   *  @brief  .SLOW and .PARTITION lines: stamp nothing, mark the subcircuit
+   *  instance they are cloned into as a circuit of its own. a slow one is
+   *  stepped once every ratio steps with the voltages it hands over held, or
+   *  linearly interpolated in between, a threaded one every step on a worker
+   *  thread
+   */
+  class partition_card : public component {
+    public:
+      partition_card(std::string id, unsigned ratio, bool hold = false,
+                     bool threaded = false) :
+        component{ std::move(id) },
+        ratio_{ ratio },
+        hold_{ hold },
+        threaded_{ threaded } {}
+
+      virtual bool is_static()    const override { return true; }
+      virtual bool is_dynamic()   const override { return false; }
+      virtual bool is_nonlinear() const override { return false; }
+
+      virtual void register_(circuit::circuit&) override {}
+      virtual void setup(circuit::circuit&) override {}
+      virtual void fill() const noexcept override {}
+
+      virtual std::vector<std::string> terminals() const override { return {}; }
+
+      virtual ptr clone(const renamer& r) const override {
+        return make_component<partition_card>(r.id(id_), ratio_, hold_, threaded_);
+      }
+
+      //instance path of the subcircuit, i.e. "X1.", empty at the top level
+      std::string instance() const {
+        return id_.substr(0, id_.rfind(threaded_ ? ".PARTITION" : ".SLOW"));
+      }
+
+      unsigned ratio()    const noexcept { return ratio_; }
+      bool     hold()     const noexcept { return hold_; }
+      bool     threaded() const noexcept { return threaded_; }
+
+    private:
+      const unsigned ratio_;
+      const bool     hold_;
+      const bool     threaded_;
+  };
+
+}		// -----  end of namespace rtspice::components  -----
+
+#endif   // ----- #ifndef options_INC  -----
@@ -0,0 +1,196 @@
+/*!
+ *    @file  potentiometer.hpp
+ *   @brief  three terminal potentiometer
+ *
+ *  @author  Thadeu Luiz Barbosa Dias (tlbd)
+ *
+ *  @internal
+ *       Created:  10/18/2026
+ *      Revision:  none
+ *      Compiler:  g++
+ *  Organization:  SMT - Signals, Multimedia and Telecommunications Lab
+ *     Copyright:  Copyright (c) 2019, Thadeu Luiz Barbosa Dias
+ *
+ *  This source code is released for free distribution under the terms of the
+ *  GNU General Public License as published by the Free Software Foundation.
+ */
+
+#ifndef  potentiometer_INC
+#define  potentiometer_INC
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <string>
+#include <tuple>
+#include <utility>
+
+#include "component.hpp"
+#include "circuit.hpp"
+
+namespace rtspice::components {
+
+  enum class taper { linear, log, antilog };
+
+  using taper_curve = std::array<float, 257>;
+
+  /*!
+   * @brief fraction of the track between wiper and NODE_B against knob position
+   *
+   * Sampled once, the knob is then read by linear interpolation. The log
+   * taper is the usual audio one, 10% at half rotation.
+   */
+  inline const taper_curve& taper_table(taper t) {
+
+    constexpr auto N = std::tuple_size_v<taper_curve> - 1;
+
+    //keeps both halves of the track away from 0 Ohm
+    constexpr auto end = 1e-4;
+
+    const auto sample = [=](auto law) {
+      taper_curve table;
+      for(std::size_t i = 0; i <= N; ++i)
+        table[i] = std::clamp(law(double(i)/N), end, 1.0 - end);
+      return table;
+    };
+
+    const auto audio = [](double x) { return (std::pow(81.0, x) - 1.0)/80.0; };
+
+    static const auto linear  = sample([](double x) { return x; });
+    static const auto log     = sample(audio);
+    static const auto antilog = sample([&](double x) { return 1.0 - audio(1.0 - x); });
+
+    switch(t) {
+      case taper::log:     return log;
+      case taper::antilog: return antilog;
+      default:             return linear;
+    }
+  }
+
+  /*!
+   * @brief potentiometer between NODE_A and NODE_B, wiper on NODE_W
+   *
+   * The knob PARAM, in [0, 1], moves the wiper from NODE_B towards NODE_A.
+   * Both halves are stamped with the static system, which is only rebuilt
+   * when the knob moves. The move is a rank 2 change of the matrix,
+   * dG1 u1 u1' + dG2 u2 u2' with u1 = e_a - e_w and u2 = e_w - e_b.
+   */
+  class potentiometer : public component {
+    public:
+      potentiometer(std::string id,
+                    std::string na,
+                    std::string nw,
+                    std::string nb,
+                    float R,
+                    std::string param_name,
+                    components::taper t = taper::linear) :
+        component{ std::move(id) },
+        na_{ std::move(na) },
+        nw_{ std::move(nw) },
+        nb_{ std::move(nb) },
+        R_{ R },
+        param_name_{ std::move(param_name) },
+        taper_{ t },
+        table_{ &taper_table(t) } {}
+
+      virtual bool is_static()    const override { return true; }
+      virtual bool is_dynamic()   const override { return false; }
+      virtual bool is_nonlinear() const override { return false; }
+
+      virtual void register_(circuit::circuit& c) override {
+
+        c.register_node(na_);
+        c.register_node(nw_);
+        c.register_node(nb_);
+
+        for(auto&& [i, j]: { std::pair{&na_, &nw_}, std::pair{&nw_, &nb_} }) {
+          c.register_entry({*i, *i});
+          c.register_entry({*i, *j});
+          c.register_entry({*j, *i});
+          c.register_entry({*j, *j});
+        }
+
+      }
+
+      virtual void setup(circuit::circuit& c) override {
+
+        Aaa_ = c.get_A({na_, na_});
+        Aaw_ = c.get_A({na_, nw_});
+        Awa_ = c.get_A({nw_, na_});
+        Aww_ = c.get_A({nw_, nw_});
+        Awb_ = c.get_A({nw_, nb_});
+        Abw_ = c.get_A({nb_, nw_});
+        Abb_ = c.get_A({nb_, nb_});
+
+        val_ = &c.get_param(param_name_);
+        pos_ = val_->load(std::memory_order_relaxed);
+
+        c.register_update(this);
+
+      }
+
+      virtual std::vector<std::string> terminals() const override {
+        return {na_, nw_, nb_};
+      }
+
+      virtual void fill() const noexcept override {
+        const auto [G1, G2] = conductances(pos_);
+        stamp_(G1, G2);
+      }
+
+      virtual bool update() noexcept override {
+        const auto pos = val_->load(std::memory_order_relaxed);
+        if(pos == pos_) return false;
+        pos_ = pos;
+        return true;
+      }
+
+      //knob, as last set by the host
+      float position() const noexcept {
+        return val_->load(std::memory_order_relaxed);
+      }
+
+      //conductances NODE_A-NODE_W and NODE_W-NODE_B at a knob position
+      std::pair<float, float> conductances(float pos) const noexcept {
+
+        constexpr auto N = std::tuple_size_v<taper_curve> - 1;
+
+        const auto x = std::clamp(pos, 0.0f, 1.0f)*N;
+        const auto i = std::min(static_cast<std::size_t>(x), N - 1);
+        const auto f = (*table_)[i] + (x - i)*((*table_)[i+1] - (*table_)[i]);
+
+        return { 1.0f/((1.0f - f)*R_), 1.0f/(f*R_) };
+      }
+
+      virtual ptr clone(const renamer& r) const override {
+        return make_component<potentiometer>(r.id(id_), r.node(na_), r.node(nw_),
+                                             r.node(nb_), R_, param_name_, taper_);
+      }
+
+    private:
+      void stamp_(float G1, float G2) const noexcept {
+        *Aaa_ += G1;
+        *Aaw_ -= G1;
+        *Awa_ -= G1;
+        *Aww_ += G1 + G2;
+        *Awb_ -= G2;
+        *Abw_ -= G2;
+        *Abb_ += G2;
+      }
+
+      const std::string na_, nw_, nb_;
+      const float R_;
+      const std::string param_name_;
+      const components::taper taper_;
+      const taper_curve* table_;
+
+      const std::atomic<float>* val_;
+      float pos_; //currently stamped
+
+      circuit::entry_reference<float> Aaa_, Aaw_, Awa_, Aww_, Awb_, Abw_, Abb_;
+  };
+
+}		// -----  end of namespace rtspice::components  -----
+
+#endif   // ----- #ifndef potentiometer_INC  -----
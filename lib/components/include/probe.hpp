@@ -45,6 +45,18 @@ namespace rtspice::components {
 
       virtual void fill() const noexcept override {}
 
+      virtual std::vector<std::string> terminals() const override {
+        return {probe_};
+      }
+
+      virtual ptr clone(const renamer& r) const override {
+        //branch currents follow the renamed component
+        for(auto&& prefix: {"@J", "J@"})
+          if(probe_.rfind(prefix, 0) == 0)
+            return make_component<probe>(prefix + r.id(probe_.substr(2)));
+        return make_component<probe>(r.node(probe_));
+      }
+
 
       virtual bool is_static()    const override { return true; }
       virtual bool is_dynamic()   const override { return false; }
@@ -18,13 +18,27 @@
 #ifndef  resistor_INC
 #define  resistor_INC
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <type_traits>
+#include <vector>
 
 #include "circuit.hpp"
 #include "component.hpp"
 
 namespace rtspice::components {
 
+  //characteristics that may run piecewise linear expose their segments
+  template<class F, class = void>
+  struct has_segments : std::false_type {};
+
+  template<class F>
+  struct has_segments<F, std::void_t<decltype(std::declval<const F&>().segment(0.0f))>> :
+    std::true_type {};
+
   /*!
    * @brief generalized resistance template
    *
@@ -81,6 +95,25 @@ namespace rtspice::components {
 
       }
 
+      virtual std::vector<std::string> terminals() const override {
+        return {na_, nb_};
+      }
+
+      virtual ptr clone(const renamer& r) const override {
+        return make_component<resistor>(r.id(id_), r.node(na_), r.node(nb_), f_);
+      }
+
+      const F& function() const noexcept { return f_; }
+
+      virtual bool is_piecewise() const override {
+        if constexpr(has_segments<F>::value) return f_.piecewise();
+        else return false;
+      }
+
+      virtual void region(std::vector<std::uint8_t>& key) const noexcept override {
+        if constexpr(has_segments<F>::value) key.push_back(f_.segment(*xa_ - *xb_));
+      }
+
       virtual void fill() const noexcept override {
 
         const auto v = *xa_ - *xb_;
@@ -128,6 +161,8 @@ namespace rtspice::components {
 
       void setup(circuit::circuit& c) {}
 
+      float conductance() const noexcept { return G_; }
+
     private:
       const float G_;
   };
@@ -161,6 +196,100 @@ namespace rtspice::components {
       const std::atomic<float>* val_;
   };
 
+  /*!
+   * @brief shockley junction constants, computed once per .MODEL and shared,
+   * read only, by all of its devices
+   *
+   * With PWL segments the exponential is replaced by its chords between
+   * breakpoints 2 N Vt apart, ending at the knee. Below them a chord to the
+   * origin, above the knee the usual extrapolation, so PWL + 2 segments.
+   *
+   * ADAA, 1 or 2, asks for antiderivative antialiasing of the order given
+   * wherever the junction is evaluated explicitly, see the wave digital
+   * mode. Ignored on piecewise linear junctions.
+   */
+  struct diode_model {
+
+    using ptr = std::shared_ptr<const diode_model>;
+
+    static constexpr float k = 1.3806504e-23;
+    static constexpr float q = 1.602176487e-19; /* A s */
+    static constexpr float Vt = k*300.0/q;
+
+    //above the knee the junction is linearly extrapolated
+    static constexpr float v_knee = 0.8;
+
+    diode_model(float IS, float N, unsigned PWL = 0, unsigned ADAA = 0) :
+      IS{ IS },
+      N{ N },
+      inv_N_Vt{ 1.0f/(N * Vt) },
+      e_sat ( IS*std::expm1(v_knee*inv_N_Vt) ),
+      df_sat( IS*std::exp(v_knee*inv_N_Vt)*inv_N_Vt ),
+      PWL{ PWL },
+      h{ 2.0f*N*Vt },
+      v_first{ v_knee - PWL*h },
+      ADAA{ PWL ? 0 : std::min(ADAA, 2u) } {
+
+        if(PWL == 0) return;
+
+        const auto j = [&](double v) { return IS*std::expm1(v*inv_N_Vt); };
+
+        const auto chord = [&](double a, double b) {
+          const auto G = (j(b) - j(a))/(b - a);
+          pwl_G.push_back(G);
+          pwl_I.push_back(j(a) - G*a);
+        };
+
+        if(v_first > 0.0f) chord(0.0, v_first);
+        else               chord(v_first - h, v_first);
+
+        for(unsigned s = 0; s < PWL; ++s) chord(v_first + s*h, v_first + (s+1)*h);
+
+        pwl_G.push_back(df_sat);
+        pwl_I.push_back(e_sat - df_sat*v_knee);
+      }
+
+    //linear segment holding v, only meaningful with PWL segments
+    unsigned segment(float v) const noexcept {
+      const auto s = std::floor((v - v_first)/h) + 1.0f;
+      return s <= 0.0f ? 0 : std::min(static_cast<unsigned>(s), PWL + 1);
+    }
+
+    const float IS, N, inv_N_Vt, e_sat, df_sat;
+
+    //junction current, its derivative and its first two antiderivatives,
+    //null at the origin, in double since ADAA takes differences of them
+    double j(double v) const noexcept {
+      if(v < v_knee) return IS*std::expm1(v*inv_N_Vt);
+      return e_sat + df_sat*(v - v_knee);
+    }
+
+    double dj(double v) const noexcept {
+      if(v < v_knee) return IS*std::exp(v*inv_N_Vt)*inv_N_Vt;
+      return df_sat;
+    }
+
+    double J1(double v) const noexcept {
+      const double a = 1.0/inv_N_Vt;
+      if(v <= v_knee) return IS*(a*std::expm1(v/a) - v);
+      const auto u = v - v_knee;
+      return J1(v_knee) + u*(e_sat + 0.5*df_sat*u);
+    }
+
+    double J2(double v) const noexcept {
+      const double a = 1.0/inv_N_Vt;
+      if(v <= v_knee) return IS*(a*a*std::expm1(v/a) - a*v - 0.5*v*v);
+      const auto u = v - v_knee;
+      return J2(v_knee) + u*(J1(v_knee) + u*(0.5*e_sat + df_sat*u/6.0));
+    }
+
+    const unsigned PWL;
+    const float h, v_first;
+    std::vector<float> pwl_G, pwl_I; //j = I + G v on each segment
+
+    const unsigned ADAA;
+  };
+
   /*!
    * @brief class implementing shockley equation characteristics
    */
@@ -171,36 +300,42 @@ namespace rtspice::components {
       static constexpr bool nonlinear_v = true;
 
       diode_resistance(float IS, float N) :
-        IS_{ IS },
-        N_Vt_{ N * Vt },
-        e_sat_ ( IS_*std::expm1(v_knee/N_Vt_) ),
-        df_sat_( IS_*std::exp(v_knee/N_Vt_)/N_Vt_ ) { }
+        diode_resistance{ std::make_shared<const diode_model>(IS, N) } {}
+
+      diode_resistance(diode_model::ptr model) :
+        model_{ std::move(model) } {}
 
       void setup(circuit::circuit& c) {}
 
       inline auto operator()(float v) const noexcept -> std::pair<float,float> {
 
-        if(v < v_knee) {
-          const auto vnt = v/N_Vt_;
-          const auto f  = IS_*std::expm1(vnt);
-         const auto df = IS_*std::exp(vnt)/N_Vt_;
+        const auto& m = *model_;
+
+        if(m.PWL) {
+          const auto s = m.segment(v);
+          return {m.pwl_I[s] + m.pwl_G[s]*v, m.pwl_G[s]};
+        }
+
+        if(v < m.v_knee) {
+          const auto vnt = v*m.inv_N_Vt;
+          const auto f  = m.IS*std::expm1(vnt);
+          const auto df = m.IS*std::exp(vnt)*m.inv_N_Vt;
           return {f, df};
         } else {
-          const auto f = e_sat_ + df_sat_*(v-v_knee);
-          return {f, df_sat_};
+          const auto f = m.e_sat + m.df_sat*(v-m.v_knee);
+          return {f, m.df_sat};
         }
 
       }
 
-    private:
+      bool piecewise() const noexcept { return model_->PWL > 0; }
 
-      static constexpr float k = 1.3806504e-23;
-      static constexpr float q = 1.602176487e-19; /* A s */
-      static constexpr float Vt = k*300.0/q;
+      unsigned segment(float v) const noexcept { return model_->segment(v); }
 
-      static constexpr float v_knee = 0.8;
+      const auto& model() const noexcept { return model_; }
 
-      const float IS_, N_Vt_, e_sat_, df_sat_;
+    private:
+      diode_model::ptr model_;
   };
 
   using linear_resistor = resistor<linear_resistance>;
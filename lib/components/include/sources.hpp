@@ -19,7 +19,12 @@
 #define  source_INC
 
 #include <unordered_map>
+#include <array>
+#include <algorithm>
 #include <atomic>
+#include <cmath>
+#include <memory>
+#include <type_traits>
 
 #include <string>
 
@@ -28,6 +33,14 @@
 
 namespace rtspice::components {
 
+  //transfer functions keeping state across time steps expose commit(v)
+  template<class F, class = void>
+  struct has_commit : std::false_type {};
+
+  template<class F>
+  struct has_commit<F, std::void_t<decltype(std::declval<F&>().commit(0.0f))>> :
+    std::true_type {};
+
   /*!
    * @brief generalized independent current source
    *
@@ -65,6 +78,16 @@ namespace rtspice::components {
         f_.setup(c);
       }
 
+      virtual std::vector<std::string> terminals() const override {
+        return {na_, nb_};
+      }
+
+      virtual ptr clone(const renamer& r) const override {
+        return make_component<current_source>(r.id(id_), r.node(na_), r.node(nb_), f_);
+      }
+
+      const F& function() const noexcept { return f_; }
+
       virtual void fill() const noexcept override {
         const auto I = f_();
         *ba_ -= I;
@@ -130,6 +153,16 @@ namespace rtspice::components {
 
       }
 
+      virtual std::vector<std::string> terminals() const override {
+        return {na_, nb_};
+      }
+
+      virtual ptr clone(const renamer& r) const override {
+        return make_component<voltage_source>(r.id(id_), r.node(na_), r.node(nb_), f_);
+      }
+
+      const F& function() const noexcept { return f_; }
+
       virtual void fill() const noexcept override {
 
         const auto V = f_();
@@ -154,7 +187,8 @@ namespace rtspice::components {
    * General voltage amplifier, where the value of the voltage is determined by
    * V(v). The class F must have an operator() accepting the dependent voltage value.
    * The linear or nonlinear information is passed through member constants
-   * called 'static_v' and 'nonlinear_v'.
+   * called 'static_v' and 'nonlinear_v'. If F has a commit(v) member, it is
+   * called with the converged control voltage after every time step.
    *
    */
   template<class F>
@@ -212,8 +246,21 @@ namespace rtspice::components {
 
         f_.setup(c);
 
+        if constexpr(has_commit<F>::value) c.register_commit(this);
+
       }
 
+      virtual std::vector<std::string> terminals() const override {
+        return {na_, nb_, nc_, nd_};
+      }
+
+      virtual ptr clone(const renamer& r) const override {
+        return make_component<vcvs>(r.id(id_), r.node(na_), r.node(nb_),
+                                  r.node(nc_), r.node(nd_), f_);
+      }
+
+      const F& function() const noexcept { return f_; }
+
       virtual void fill() const noexcept override {
 
         const auto v = *xc_ - *xd_;
@@ -234,6 +281,10 @@ namespace rtspice::components {
 
       }
 
+      virtual void commit() noexcept override {
+        if constexpr(has_commit<F>::value) f_.commit(*xc_ - *xd_);
+      }
+
     private:
       const std::string na_, nb_, nc_, nd_, nj_;
       F f_;
@@ -307,6 +358,17 @@ namespace rtspice::components {
         f_.setup(c);
       }
 
+      virtual std::vector<std::string> terminals() const override {
+        return {na_, nb_, nc_, nd_};
+      }
+
+      virtual ptr clone(const renamer& r) const override {
+        return make_component<cccs>(r.id(id_), r.node(na_), r.node(nb_),
+                                  r.node(nc_), r.node(nd_), f_);
+      }
+
+      const F& function() const noexcept { return f_; }
+
       virtual void fill() const noexcept override {
 
         const auto i = *xj_;
@@ -397,6 +459,17 @@ namespace rtspice::components {
 
       }
 
+      virtual std::vector<std::string> terminals() const override {
+        return {na_, nb_, nc_, nd_};
+      }
+
+      virtual ptr clone(const renamer& r) const override {
+        return make_component<vccs>(r.id(id_), r.node(na_), r.node(nb_),
+                                  r.node(nc_), r.node(nd_), f_);
+      }
+
+      const F& function() const noexcept { return f_; }
+
       virtual void fill() const noexcept override {
 
         const auto v = *xc_ -*xd_;
@@ -504,6 +577,17 @@ namespace rtspice::components {
 
       }
 
+      virtual std::vector<std::string> terminals() const override {
+        return {na_, nb_, nc_, nd_};
+      }
+
+      virtual ptr clone(const renamer& r) const override {
+        return make_component<ccvs>(r.id(id_), r.node(na_), r.node(nb_),
+                                  r.node(nc_), r.node(nd_), f_);
+      }
+
+      const F& function() const noexcept { return f_; }
+
       virtual void fill() const noexcept override {
 
         const auto j = *xx_;
@@ -537,6 +621,106 @@ namespace rtspice::components {
       circuit::entry_reference<const float> xx_;
   };
 
+  /*!
+   * @brief node held at a constant voltage against ground
+   *
+   * Produced by the netlist passes out of grounded DC voltage sources: the
+   * node voltage is known, so its unknown and equation are folded out of the
+   * system and its column is moved to the right hand side.
+   */
+  class fixed_voltage : public component {
+    public:
+      fixed_voltage(std::string id,
+                    std::string na,
+                    float V) :
+        component{ std::move(id) },
+        na_{ std::move(na) },
+        V_{ V } {}
+
+      virtual bool is_static()    const override { return true; }
+      virtual bool is_dynamic()   const override { return false; }
+      virtual bool is_nonlinear() const override { return false; }
+
+      virtual void register_(circuit::circuit &c) override {
+        c.register_node(na_);
+        c.register_constant(na_, V_);
+      }
+
+      virtual void setup(circuit::circuit&) override {}
+
+      virtual std::vector<std::string> terminals() const override {
+        return {na_, "0"};
+      }
+
+      virtual ptr clone(const renamer& r) const override {
+        return make_component<fixed_voltage>(r.id(id_), r.node(na_), V_);
+      }
+
+      virtual void fill() const noexcept override {}
+
+      float value() const noexcept { return V_; }
+
+    private:
+      const std::string na_;
+      const float V_;
+  };
+
+  /*!
+   * @brief linearized current from node a to node k, controlled by the
+   * voltages of N nodes against k
+   */
+  template<std::size_t N>
+  class controlled_branch {
+    public:
+      controlled_branch(const std::string& na, const std::string& nk,
+                        std::array<const std::string*, N> nc) :
+        na_{ &na }, nk_{ &nk }, nc_{ nc } {}
+
+      void register_(circuit::circuit& c) const {
+        for(auto n: nc_) {
+          c.register_entry({*na_, *n});
+          c.register_entry({*nk_, *n});
+        }
+        c.register_entry({*na_, *nk_});
+        c.register_entry({*nk_, *nk_});
+      }
+
+      void setup(circuit::circuit& c) {
+        for(std::size_t i = 0; i < N; ++i) {
+          Aac_[i] = c.get_A({*na_, *nc_[i]});
+          Akc_[i] = c.get_A({*nk_, *nc_[i]});
+        }
+        Aak_ = c.get_A({*na_, *nk_});
+        Akk_ = c.get_A({*nk_, *nk_});
+        ba_  = c.get_b(*na_);
+        bk_  = c.get_b(*nk_);
+      }
+
+      //current I and its gains g at the control voltages v
+      void fill(float I, const std::array<float, N>& g,
+                         const std::array<float, N>& v) const noexcept {
+        auto G = 0.0f;
+        auto J = I;
+        for(std::size_t i = 0; i < N; ++i) {
+          *Aac_[i] += g[i];
+          *Akc_[i] -= g[i];
+          G += g[i];
+          J -= g[i]*v[i];
+        }
+        *Aak_ -= G;
+        *Akk_ += G;
+        *ba_  -= J;
+        *bk_  += J;
+      }
+
+    private:
+      const std::string *na_, *nk_;
+      const std::array<const std::string*, N> nc_;
+
+      std::array<circuit::entry_reference<float>, N> Aac_, Akc_;
+      circuit::entry_reference<float> Aak_, Akk_, ba_, bk_;
+  };
+
   /*!
    * @brief simple transfer function implementing DC source characteristics
    *
@@ -556,6 +740,8 @@ namespace rtspice::components {
 
       void setup(circuit::circuit&) {}
 
+      float value() const noexcept { return val_; }
+
     private:
       const float val_;
   };
@@ -601,16 +787,47 @@ namespace rtspice::components {
         param_name_{ std::move(param) } {}
 
       void setup(circuit::circuit& c) {
-        val_ = &c.get_input(param_name_);
+        val_   = &c.get_input(param_name_);
+        stage_ = c.get_stage();
       }
 
+      //the first stage of a split step sees the input ramping from its last
+      //value, as it only changes between steps
       inline float operator()() const noexcept {
-        return *val_;
+        if(*stage_ == 1) return last_ + circuit::circuit::gamma*(*val_ - last_);
+        return last_ = *val_;
       }
 
     private:
       const std::string param_name_;
       const float* val_;
+      const unsigned* stage_;
+      mutable float last_ = 0.0f;
+  };
+
+  /*!
+   * @brief source written by another circuit, through a shared cell
+   *
+   * Couples a slow partition to the rest of the netlist: the circuit owning
+   * both writes the cells between time steps.
+   */
+  class shared_function {
+    public:
+      static constexpr bool static_v   = false;
+      static constexpr bool dynamic_v  = true;
+      static constexpr bool nonlinear_v= false;
+
+      shared_function(std::shared_ptr<const float> value) :
+        value_{ std::move(value) } {}
+
+      void setup(circuit::circuit&) {}
+
+      inline float operator()() const noexcept {
+        return *value_;
+      }
+
+    private:
+      std::shared_ptr<const float> value_;
   };
 
   /*!
@@ -632,10 +849,92 @@ namespace rtspice::components {
         return std::make_pair(df_*x, df_);
       }
 
+      float gain() const noexcept { return df_; }
+
     private:
       const float df_;
   };
 
+  /*!
+   * @brief open loop gain A0 with a tanh saturation between the rails
+   *
+   * V = mid + half tanh((y - mid)/half), with y = A0 v, mid and half the
+   * center and half swing of [VNEG, VPOS]. With a gain bandwidth product GBW
+   * the gain rolls off through a dominant pole at GBW/A0, discretized with
+   * the trapezoidal rule: y = alpha y[n-1] + beta (v + v[n-1]). The pole
+   * comes before the clipper, so the output never leaves the rails.
+   *
+   * With a large A0 the tanh is nearly a step, and plain Newton bounces from
+   * one rail to the other. Like pnjlim for junctions, the tanh argument moves
+   * at most by max(1, |u|) per iteration: it may halve, double or fall back
+   * to zero, and the linearization at the limited point is extended up to
+   * the requested one.
+   */
+  class rail_transfer {
+    public:
+
+      static constexpr bool static_v    = false;
+      static constexpr bool dynamic_v   = false;
+      static constexpr bool nonlinear_v = true;
+
+      rail_transfer(float A0, float Vneg, float Vpos, float GBW = 0.0f) :
+        A0_{ A0 },
+        Vneg_{ Vneg },
+        Vpos_{ Vpos },
+        GBW_{ GBW },
+        mid_{ 0.5f*(Vpos + Vneg) },
+        half_{ 0.5f*(Vpos - Vneg) },
+        wp_( 8.0*std::atan(1.0)*GBW/A0 ) {} //2 pi GBW/A0
+
+      void setup(circuit::circuit& c) {
+        delta_t_ = c.get_delta_time();
+      }
+
+      inline std::pair<float, float> operator()(float v) const noexcept {
+
+        auto y = A0_*v, dy = A0_;
+
+        if(GBW_ > 0.0f) {
+          const auto k = 0.5f*wp_*(*delta_t_);
+          const auto alpha = (1.0f - k)/(1.0f + k);
+          const auto beta  = k*A0_/(1.0f + k);
+          y  = alpha*y_ + beta*(v + v_);
+          dy = beta;
+        }
+
+        const auto u  = (y - mid_)/half_;
+        const auto s  = std::max(1.0f, std::abs(u_));
+        const auto ue = std::clamp(u, u_ - s, u_ + s);
+        u_ = ue;
+
+        const auto t = std::tanh(ue);
+        const auto d = 1.0f - t*t;
+        return { mid_ + half_*t + d*half_*(u - ue), dy*d };
+      }
+
+      //advance the pole state with the converged input
+      void commit(float v) noexcept {
+        if(GBW_ > 0.0f) {
+          const auto k = 0.5f*wp_*(*delta_t_);
+          y_ = ((1.0f - k)*y_ + k*A0_*(v + v_))/(1.0f + k);
+          v_ = v;
+        }
+      }
+
+      float gain()     const noexcept { return A0_; }
+      float neg_rail() const noexcept { return Vneg_; }
+      float pos_rail() const noexcept { return Vpos_; }
+      float gbw()      const noexcept { return GBW_; }
+
+    private:
+      const float A0_, Vneg_, Vpos_, GBW_;
+      const float mid_, half_, wp_;
+      const float *delta_t_;
+
+      float y_ = 0.0f, v_ = 0.0f; //pole state at the last time step
+      mutable float u_ = 0.0f;    //last Newton evaluation point
+  };
+
   using dc_current = current_source<constant_function>;
   using dc_voltage = voltage_source<constant_function>;
 
@@ -645,6 +944,9 @@ namespace rtspice::components {
   using ext_current = current_source<external_function>;
   using ext_voltage = voltage_source<external_function>;
 
+  using shared_current = current_source<shared_function>;
+  using shared_voltage = voltage_source<shared_function>;
+
   using linear_vcvs = vcvs<linear_transfer>;
   using linear_vccs = vccs<linear_transfer>;
   using linear_cccs = cccs<linear_transfer>;
@@ -0,0 +1,131 @@
+/*!
+ *    @file  switch.hpp
+ *   @brief  knob controlled switch
+ *
+ *  @author  Thadeu Luiz Barbosa Dias (tlbd)
+ *
+ *  @internal
+ *       Created:  10/18/2026
+ *      Revision:  none
+ *      Compiler:  g++
+ *  Organization:  SMT - Signals, Multimedia and Telecommunications Lab
+ *     Copyright:  Copyright (c) 2019, Thadeu Luiz Barbosa Dias
+ *
+ *  This source code is released for free distribution under the terms of the
+ *  GNU General Public License as published by the Free Software Foundation.
+ */
+
+#ifndef  switch_INC
+#define  switch_INC
+
+#include <atomic>
+#include <string>
+
+#include "component.hpp"
+#include "circuit.hpp"
+
+namespace rtspice::components {
+
+  /*!
+   * @brief single pole switch between NODE_A and NODE_B
+   *
+   * Closed while PARAM is at least 0.5, or below it when normally closed, so
+   * a pair of opposite switches on one PARAM makes a selector. Both states
+   * are plain conductances precomputed at load time, stamped with the static
+   * system: a flip only rebuilds the static stamp before the next step, and
+   * nothing is evaluated per sample.
+   */
+  class spst_switch : public component {
+    public:
+      static constexpr float Ron  = 0.1f;
+      static constexpr float Roff = 100e6f;
+
+      spst_switch(std::string id,
+                  std::string na,
+                  std::string nb,
+                  std::string param_name,
+                  bool normally_closed = false,
+                  float ron  = Ron,
+                  float roff = Roff) :
+        component{ std::move(id) },
+        na_{ std::move(na) },
+        nb_{ std::move(nb) },
+        param_name_{ std::move(param_name) },
+        normally_closed_{ normally_closed },
+        Gon_{ 1.0f/ron },
+        Goff_{ 1.0f/roff } {}
+
+      virtual bool is_static()    const override { return true; }
+      virtual bool is_dynamic()   const override { return false; }
+      virtual bool is_nonlinear() const override { return false; }
+
+      virtual void register_(circuit::circuit& c) override {
+
+        c.register_node(na_);
+        c.register_node(nb_);
+
+        c.register_entry({na_, na_});
+        c.register_entry({na_, nb_});
+        c.register_entry({nb_, na_});
+        c.register_entry({nb_, nb_});
+
+      }
+
+      virtual void setup(circuit::circuit& c) override {
+
+        Aaa_ = c.get_A({na_, na_});
+        Aab_ = c.get_A({na_, nb_});
+        Aba_ = c.get_A({nb_, na_});
+        Abb_ = c.get_A({nb_, nb_});
+
+        val_ = &c.get_param(param_name_);
+        closed_ = closed();
+
+        c.register_update(this);
+
+      }
+
+      virtual std::vector<std::string> terminals() const override {
+        return {na_, nb_};
+      }
+
+      virtual void fill() const noexcept override {
+        const auto G = closed_ ? Gon_ : Goff_;
+        *Aaa_ += G;
+        *Aab_ -= G;
+        *Aba_ -= G;
+        *Abb_ += G;
+      }
+
+      virtual bool update() noexcept override {
+        const auto now = closed();
+        if(now == closed_) return false;
+        closed_ = now;
+        return true;
+      }
+
+      bool closed() const noexcept {
+        return (val_->load(std::memory_order_relaxed) >= 0.5f) != normally_closed_;
+      }
+
+      virtual ptr clone(const renamer& r) const override {
+        return make_component<spst_switch>(r.id(id_), r.node(na_), r.node(nb_),
+                                           param_name_, normally_closed_,
+                                           1.0f/Gon_, 1.0f/Goff_);
+      }
+
+    private:
+      const std::string na_, nb_;
+      const std::string param_name_;
+      const bool normally_closed_;
+      const float Gon_, Goff_;
+
+      const std::atomic<float>* val_;
+      bool closed_; //currently stamped
+
+      circuit::entry_reference<float> Aaa_, Aab_, Aba_, Abb_;
+  };
+
+}		// -----  end of namespace rtspice::components  -----
+
+#endif   // ----- #ifndef switch_INC  -----
@@ -0,0 +1,373 @@
+/*!
+ *    @file  tube.hpp
+ *   @brief  vacuum tube definitions
+ *
+ *  @author  Thadeu Luiz Barbosa Dias (tlbd)
+ *
+ *  @internal
+ *       Created:  10/18/2026
+ *      Revision:  none
+ *      Compiler:  g++
+ *  Organization:  SMT - Signals, Multimedia and Telecommunications Lab
+ *     Copyright:  Copyright (c) 2019, Thadeu Luiz Barbosa Dias
+ *
+ *  This source code is released for free distribution under the terms of the
+ *  GNU General Public License as published by the Free Software Foundation.
+ */
+
+#ifndef  tube_INC
+#define  tube_INC
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "component.hpp"
+#include "circuit.hpp"
+#include "sources.hpp"
+
+namespace rtspice::components {
+
+  //value and partial derivatives of a two variable characteristic
+  struct surface_point {
+    float f, fx, fy;
+  };
+
+  /*!
+   * @brief bicubic Hermite table of a smooth two variable function
+   *
+   * Knots hold the value, both partials and the cross partial, so the
+   * interpolant and its derivatives are continuous across cells and Newton
+   * iterations see no kinks. Points outside the grid are left to the caller.
+   */
+  class hermite_table {
+    public:
+      template<class F>
+      hermite_table(F&& f, float x0, float x1, std::size_t nx,
+                           float y0, float y1, std::size_t ny) :
+        x0_{ x0 }, y0_{ y0 },
+        dx_{ (x1 - x0)/nx }, dy_{ (y1 - y0)/ny },
+        nx_{ nx }, ny_{ ny },
+        knots_((nx + 1)*(ny + 1)) {
+
+        //cross partial by central differences of the exact fx
+        const auto h = 1e-3f*dy_;
+
+        for(std::size_t i = 0; i <= nx; ++i)
+          for(std::size_t j = 0; j <= ny; ++j) {
+            const auto x = x0 + i*dx_, y = y0 + j*dy_;
+            const auto p = f(x, y);
+            const auto fxy = (f(x, y + h).fx - f(x, y - h).fx)/(2*h);
+            knots_[i*(ny + 1) + j] = { p.f, p.fx*dx_, p.fy*dy_, fxy*dx_*dy_ };
+          }
+      }
+
+      bool inside(float x, float y) const noexcept {
+        const auto t = (x - x0_)/dx_, u = (y - y0_)/dy_;
+        return t >= 0 && t <= nx_ && u >= 0 && u <= ny_;
+      }
+
+      surface_point operator()(float x, float y) const noexcept {
+
+        auto t = (x - x0_)/dx_, u = (y - y0_)/dy_;
+        const auto i = std::min(static_cast<std::size_t>(t), nx_ - 1);
+        const auto j = std::min(static_cast<std::size_t>(u), ny_ - 1);
+        t -= i;
+        u -= j;
+
+        //hermite basis: value and slope at each end, and their derivatives
+        const auto basis = [](float s) {
+          const auto s2 = s*s, s3 = s2*s;
+          return std::array<float, 8>{
+            2*s3 - 3*s2 + 1, s3 - 2*s2 + s, -2*s3 + 3*s2, s3 - s2,
+            6*s2 - 6*s,      3*s2 - 4*s + 1, -6*s2 + 6*s, 3*s2 - 2*s };
+        };
+        const auto bt = basis(t), bu = basis(u);
+
+        surface_point p{ 0, 0, 0 };
+        for(std::size_t a = 0; a < 2; ++a)
+          for(std::size_t b = 0; b < 2; ++b) {
+            const auto& k = knots_[(i + a)*(ny_ + 1) + j + b];
+
+            const auto v  = bt[2*a]*k[0] + bt[2*a+1]*k[1];
+            const auto vy = bt[2*a]*k[2] + bt[2*a+1]*k[3];
+            const auto w  = bt[4+2*a]*k[0] + bt[5+2*a]*k[1];
+            const auto wy = bt[4+2*a]*k[2] + bt[5+2*a]*k[3];
+
+            p.f  += bu[2*b]*v  + bu[2*b+1]*vy;
+            p.fx += bu[2*b]*w  + bu[2*b+1]*wy;
+            p.fy += bu[4+2*b]*v + bu[5+2*b]*vy;
+          }
+
+        p.fx /= dx_;
+        p.fy /= dy_;
+        return p;
+      }
+
+    private:
+      const float x0_, y0_, dx_, dy_;
+      const std::size_t nx_, ny_;
+      std::vector<std::array<float, 4>> knots_;
+  };
+
+  //log(1 + e^a) and its derivative, without overflow
+  inline std::pair<double, double> softplus(double a) noexcept {
+    if(a > 30.0) return { a, 1.0 };
+    const auto e = std::exp(a);
+    return { std::log1p(e), e/(1.0 + e) };
+  }
+
+  //2 E1^EX / KG1 for positive E1, and its derivative
+  inline std::pair<double, double> koren_law(double E1, double EX, double KG1) noexcept {
+    if(E1 <= 0.0) return { 0.0, 0.0 };
+    const auto p = std::pow(E1, EX - 1.0);
+    return { 2.0*p*E1/KG1, 2.0*EX*p/KG1 };
+  }
+
+  //grid to cathode conduction, vgk^1.5 / RGI for positive vgk
+  inline std::pair<float, float> grid_current(float vgk, float RGI) noexcept {
+    if(vgk <= 0.0f) return { 0.0f, 0.0f };
+    const auto s = std::sqrt(vgk);
+    return { vgk*s/RGI, 1.5f*s/RGI };
+  }
+
+  /*!
+   * @brief Koren triode, plate current tabulated over (Vgk, Vpk)
+   */
+  struct triode_model {
+
+    using ptr = std::shared_ptr<const triode_model>;
+
+    triode_model(float MU, float EX, float KG1, float KP, float KVB, float RGI) :
+      MU{ MU }, EX{ EX }, KG1{ KG1 }, KP{ KP }, KVB{ KVB }, RGI{ RGI },
+      plate{ [this](float vgk, float vpk) { return exact(vgk, vpk); },
+             -24.0f, 8.0f, 256, 0.0f, 512.0f, 128 } {}
+
+    //plate current straight from the model equations
+    surface_point exact(double vgk, double vpk) const noexcept {
+
+      const auto s = std::sqrt(KVB + vpk*vpk);
+      const auto [sp, sig] = softplus(KP*(1.0/MU + vgk/s));
+
+      const auto E1  = vpk/KP*sp;
+      const auto dE1_dvgk = vpk*sig/s;
+      const auto dE1_dvpk = sp/KP - sig*vgk*vpk*vpk/(s*s*s);
+
+      const auto [i, di] = koren_law(E1, EX, KG1);
+      return { float(i), float(di*dE1_dvgk), float(di*dE1_dvpk) };
+    }
+
+    surface_point operator()(float vgk, float vpk) const noexcept {
+      return plate.inside(vgk, vpk) ? plate(vgk, vpk) : exact(vgk, vpk);
+    }
+
+    const float MU, EX, KG1, KP, KVB, RGI;
+    const hermite_table plate;
+  };
+
+  /*!
+   * @brief Koren pentode, plate current factored as F(Vg1k, Vg2k) atan(Vpk/KVB)
+   * with F tabulated
+   */
+  struct pentode_model {
+
+    using ptr = std::shared_ptr<const pentode_model>;
+
+    pentode_model(float MU, float EX, float KG1, float KG2, float KP, float KVB,
+                  float RGI) :
+      MU{ MU }, EX{ EX }, KG1{ KG1 }, KG2{ KG2 }, KP{ KP }, KVB{ KVB }, RGI{ RGI },
+      cathode{ [this](float vg1k, float vg2k) { return exact(vg1k, vg2k); },
+               -96.0f, 8.0f, 104, 0.0f, 512.0f, 128 } {}
+
+    //F from the model equations
+    surface_point exact(double vg1k, double vg2k) const noexcept {
+
+      if(vg2k <= 0.0) return { 0.0f, 0.0f, 0.0f };
+
+      const auto [sp, sig] = softplus(KP*(1.0/MU + vg1k/vg2k));
+
+      const auto E1  = vg2k/KP*sp;
+      const auto dE1_dvg1k = sig;
+      const auto dE1_dvg2k = sp/KP - sig*vg1k/vg2k;
+
+      const auto [i, di] = koren_law(E1, EX, KG1);
+      return { float(i), float(di*dE1_dvg1k), float(di*dE1_dvg2k) };
+    }
+
+    surface_point operator()(float vg1k, float vg2k) const noexcept {
+      return cathode.inside(vg1k, vg2k) ? cathode(vg1k, vg2k) : exact(vg1k, vg2k);
+    }
+
+    //screen current, (Vg1k + Vg2k/MU)^EX / KG2
+    surface_point screen(float vg1k, float vg2k) const noexcept {
+      const auto e = vg1k + vg2k/MU;
+      if(e <= 0.0f) return { 0.0f, 0.0f, 0.0f };
+      const auto p = std::pow(e, EX - 1.0f);
+      const auto d = EX*p/KG2;
+      return { p*e/KG2, d, d/MU };
+    }
+
+    const float MU, EX, KG1, KG2, KP, KVB, RGI;
+    const hermite_table cathode;
+  };
+
+  class triode : public component {
+    public:
+      virtual bool is_static()    const override { return false; }
+      virtual bool is_dynamic()   const override { return false; }
+      virtual bool is_nonlinear() const override { return true; }
+
+      triode(std::string id,
+             std::string np,
+             std::string ng,
+             std::string nk,
+             triode_model::ptr model) :
+        component{ std::move(id) },
+        np_{ std::move(np) },
+        ng_{ std::move(ng) },
+        nk_{ std::move(nk) },
+        model_{ std::move(model) },
+        plate_{ np_, nk_, {&ng_, &np_} },
+        grid_{ ng_, nk_, {&ng_} } {}
+
+      virtual void register_(circuit::circuit& c) override {
+        c.register_node(np_);
+        c.register_node(ng_);
+        c.register_node(nk_);
+        plate_.register_(c);
+        grid_.register_(c);
+      }
+
+      virtual void setup(circuit::circuit& c) override {
+        plate_.setup(c);
+        grid_.setup(c);
+        xp_ = c.get_x(np_);
+        xg_ = c.get_x(ng_);
+        xk_ = c.get_x(nk_);
+      }
+
+      virtual std::vector<std::string> terminals() const override {
+        return {np_, ng_, nk_};
+      }
+
+      virtual ptr clone(const renamer& r) const override {
+        return make_component<triode>(r.id(id_), r.node(np_), r.node(ng_),
+                                      r.node(nk_), model_);
+      }
+
+      virtual void fill() const noexcept override {
+
+        const auto vgk = *xg_ - *xk_;
+        const auto vpk = *xp_ - *xk_;
+
+        const auto ip = (*model_)(vgk, vpk);
+        plate_.fill(ip.f, {ip.fx, ip.fy}, {vgk, vpk});
+
+        const auto [ig, gg] = grid_current(vgk, model_->RGI);
+        grid_.fill(ig, {gg}, {vgk});
+
+      }
+
+      const auto& model() const noexcept { return model_; }
+
+    private:
+      const std::string np_, ng_, nk_;
+      const triode_model::ptr model_;
+
+      controlled_branch<2> plate_;
+      controlled_branch<1> grid_;
+
+      circuit::entry_reference<const float> xp_, xg_, xk_;
+  };
+
+  class pentode : public component {
+    public:
+      virtual bool is_static()    const override { return false; }
+      virtual bool is_dynamic()   const override { return false; }
+      virtual bool is_nonlinear() const override { return true; }
+
+      pentode(std::string id,
+              std::string np,
+              std::string ns,
+              std::string ng,
+              std::string nk,
+              pentode_model::ptr model) :
+        component{ std::move(id) },
+        np_{ std::move(np) },
+        ns_{ std::move(ns) },
+        ng_{ std::move(ng) },
+        nk_{ std::move(nk) },
+        model_{ std::move(model) },
+        plate_{ np_, nk_, {&ng_, &ns_, &np_} },
+        screen_{ ns_, nk_, {&ng_, &ns_} },
+        grid_{ ng_, nk_, {&ng_} } {}
+
+      virtual void register_(circuit::circuit& c) override {
+        c.register_node(np_);
+        c.register_node(ns_);
+        c.register_node(ng_);
+        c.register_node(nk_);
+        plate_.register_(c);
+        screen_.register_(c);
+        grid_.register_(c);
+      }
+
+      virtual void setup(circuit::circuit& c) override {
+        plate_.setup(c);
+        screen_.setup(c);
+        grid_.setup(c);
+        xp_ = c.get_x(np_);
+        xs_ = c.get_x(ns_);
+        xg_ = c.get_x(ng_);
+        xk_ = c.get_x(nk_);
+      }
+
+      virtual std::vector<std::string> terminals() const override {
+        return {np_, ns_, ng_, nk_};
+      }
+
+      virtual ptr clone(const renamer& r) const override {
+        return make_component<pentode>(r.id(id_), r.node(np_), r.node(ns_),
+                                       r.node(ng_), r.node(nk_), model_);
+      }
+
+      virtual void fill() const noexcept override {
+
+        const auto& m = *model_;
+
+        const auto vgk = *xg_ - *xk_;
+        const auto vsk = *xs_ - *xk_;
+        const auto vpk = *xp_ - *xk_;
+
+        const auto F = m(vgk, vsk);
+        const auto a = std::atan(vpk/m.KVB);
+        const auto da = m.KVB/(m.KVB*m.KVB + vpk*vpk);
+        plate_.fill(F.f*a, {F.fx*a, F.fy*a, F.f*da}, {vgk, vsk, vpk});
+
+        const auto is = m.screen(vgk, vsk);
+        screen_.fill(is.f, {is.fx, is.fy}, {vgk, vsk});
+
+        const auto [ig, gg] = grid_current(vgk, m.RGI);
+        grid_.fill(ig, {gg}, {vgk});
+
+      }
+
+      const auto& model() const noexcept { return model_; }
+
+    private:
+      const std::string np_, ns_, ng_, nk_;
+      const pentode_model::ptr model_;
+
+      controlled_branch<3> plate_;
+      controlled_branch<2> screen_;
+      controlled_branch<1> grid_;
+
+      circuit::entry_reference<const float> xp_, xs_, xg_, xk_;
+  };
+
+}		// -----  end of namespace rtspice::components  -----
+
+#endif   // ----- #ifndef tube_INC  -----
@@ -38,8 +38,10 @@ namespace rtspice::gui {
       Q_OBJECT;
 
     public:
+      //log, lines from loading the netlist shown before the circuit's own
       circuit_widget(const QString& name,
           const std::vector<components::component::ptr>& components,
+          const std::vector<std::string>& log,
           QWidget* parent);
 
       ~circuit_widget();
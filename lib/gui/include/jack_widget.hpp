@@ -20,8 +20,11 @@
 #define  jack_widget_INC
 
 #include "circuit.hpp"
+#include "oversampler.hpp"
 
 #include <list>
+#include <memory>
+#include <vector>
 
 #include <QGroupBox>
 #include <QList>
@@ -71,6 +74,11 @@ namespace rtspice::gui {
       float delta_t_;
       QStringList node_names_;
 
+      //the circuit runs between resamplers sized for the JACK buffer, at a
+      //fixed or adaptive rate, adding latency_ frames
+      std::unique_ptr<circuit::oversampler> oversampler_;
+      jack_nframes_t latency_ = 0;
+
       //jack members
       jack_client_t *client_          = nullptr;
       const char    **known_sources_  = nullptr;
@@ -93,9 +101,15 @@ namespace rtspice::gui {
       std::vector<input_port_> input_ports_;
       std::vector<output_port_> output_ports_;
 
+      //port buffers, in port order, as the oversampler takes them
+      std::vector<const float*> input_buffers_;
+      std::vector<float*>       output_buffers_;
+
       //jack callbacks
       static int process_callback(jack_nframes_t nframes, void* arg);
       static int sample_rate_callback(jack_nframes_t rate, void* arg);
+      static int buffer_size_callback(jack_nframes_t nframes, void* arg);
+      static void latency_callback(jack_latency_callback_mode_t mode, void* arg);
 
       static constexpr auto program_name = "RTspice";
   };
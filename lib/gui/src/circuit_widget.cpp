@@ -30,9 +30,10 @@ using namespace rtspice::gui;
 using rtspice::components::component;
 
 circuit_widget::circuit_widget(const QString& name,
-    const vector<component::ptr>& components, QWidget* parent) :
+    const vector<component::ptr>& components, const vector<string>& log,
+    QWidget* parent) :
   QWidget{ parent },
-  c_{ components } {
+  c_{ components, true } {
 
     //prepare layout
     layout_ = new QGridLayout{this};
@@ -47,11 +48,20 @@ circuit_widget::circuit_widget(const QString& name,
 
     info_box_->layout()->addWidget(
       new QLabel{QString{"Loaded circuit with %1 nodes."}
-        .arg(c_.nodes().size()), info_box_});
+        .arg(c_.size()), info_box_});
 
     info_box_->layout()->addWidget(
       new QLabel{QString{"Modified admitance matrix has %1 non-zeros."}
-        .arg(c_.entries().size()), info_box_});
+        .arg(c_.nnz()), info_box_});
+
+    info_box_->layout()->addWidget(
+      new QLabel{QString{"Factored in %1 order, over %2 diagonal blocks."}
+        .arg(QString::fromStdString(c_.ordering())).arg(c_.blocks()), info_box_});
+
+    for(auto&& lines: { &log, &c_.log() })
+      for(auto&& line: *lines)
+        info_box_->layout()->addWidget(
+          new QLabel{QString::fromStdString(line), info_box_});
 
 
     knobs_ = new knob_holder{c_, this};
@@ -26,6 +26,8 @@
 #include <QFormLayout>
 #include <QComboBox>
 
+#include <jack/thread.h>
+
 using namespace std;
 using namespace rtspice::gui;
 using rtspice::circuit::circuit;
@@ -79,6 +81,8 @@ void jack_widget::set_callbacks_() {
 
   jack_set_process_callback(client_, &jack_widget::process_callback, this);
   jack_set_sample_rate_callback(client_, &jack_widget::sample_rate_callback, this);
+  jack_set_buffer_size_callback(client_, &jack_widget::buffer_size_callback, this);
+  jack_set_latency_callback(client_, &jack_widget::latency_callback, this);
 
 }
 
@@ -108,6 +112,21 @@ void jack_widget::register_ports_() {
     output_ports_.emplace_back(port);
   }
 
+  vector<float*> inputs;
+  vector<circuit::entry_reference<const float>> outputs;
+  for(auto& p : input_ports_)  inputs.push_back(p.entry);
+  for(auto& p : output_ports_) outputs.push_back(p.entry);
+
+  input_buffers_.assign(input_ports_.size(), nullptr);
+  output_buffers_.assign(output_ports_.size(), nullptr);
+
+  oversampler_ = make_unique<circuit::oversampler>(circuit_,
+      move(inputs), move(outputs), circuit_.oversampling(), circuit_.adaptive());
+  latency_ = oversampler_->latency();
+
+  sample_rate_callback(jack_get_sample_rate(client_), this);
+  buffer_size_callback(jack_get_buffer_size(client_), this);
+
 }
 
 jack_widget::~jack_widget() {
@@ -130,6 +149,12 @@ jack_widget::~jack_widget() {
 void jack_widget::activate_(bool checked) {
   if(checked) {
     jack_activate(client_);
+    //the process thread waits on the circuit's workers every period, so they
+    //run at its priority or it inherits their latency
+    const auto priority = jack_client_real_time_priority(client_);
+    if(priority >= 0)
+      for(auto&& w: circuit_.worker_threads())
+        jack_acquire_real_time_scheduling(w, priority);
     connections_->connect_();
     connections_->setDisabled(true); //lock connection widget
   }
@@ -159,15 +184,13 @@ int jack_widget::process_callback(jack_nframes_t n_frames, void* arg) {
   for_each(begin(iports), end(iports), get_buffer);
   for_each(begin(oports), end(oports), get_buffer);
 
-  for(auto i = 0; i < n_frames; ++i) {
+  for(size_t p = 0; p < iports.size(); ++p) this_->input_buffers_[p]  = iports[p].buffer;
+  for(size_t p = 0; p < oports.size(); ++p) this_->output_buffers_[p] = oports[p].buffer;
 
-    for(auto& p : iports) *p.entry = p.buffer[i];
+  this_->oversampler_->process(this_->input_buffers_.data(),
+                               this_->output_buffers_.data(),
+                               n_frames, this_->delta_t_);
 
-    this_->circuit_.advance_(this_->delta_t_);
-
-    for(auto& p : oports) p.buffer[i] = *p.entry;
-
-  }
   return 0;
 
 }
@@ -175,9 +198,40 @@ int jack_widget::process_callback(jack_nframes_t n_frames, void* arg) {
 int jack_widget::sample_rate_callback(jack_nframes_t sample_rate, void* arg) {
   auto this_ = static_cast<jack_widget*>(arg);
   this_->delta_t_ = 1.0/sample_rate;
+  if(this_->oversampler_) this_->oversampler_->prepare(this_->delta_t_);
+  return 0;
+}
+
+int jack_widget::buffer_size_callback(jack_nframes_t n_frames, void* arg) {
+  //called off the process thread, the one place buffers are sized
+  auto this_ = static_cast<jack_widget*>(arg);
+  if(this_->oversampler_) this_->oversampler_->resize(n_frames);
   return 0;
 }
 
+void jack_widget::latency_callback(jack_latency_callback_mode_t mode, void* arg) {
+
+  auto this_ = static_cast<jack_widget*>(arg);
+
+  //latency seen through the circuit: the worst of the other side, plus ours
+  const auto through = [&](auto& from, auto& to) {
+    jack_latency_range_t range{ 0, 0 }, r;
+    for(auto& p : from) {
+      jack_port_get_latency_range(p.handle, mode, &r);
+      range.min = max(range.min, r.min);
+      range.max = max(range.max, r.max);
+    }
+    range.min += this_->latency_;
+    range.max += this_->latency_;
+    for(auto& p : to) jack_port_set_latency_range(p.handle, mode, &range);
+  };
+
+  if(mode == JackCaptureLatency)
+    through(this_->input_ports_, this_->output_ports_);
+  else
+    through(this_->output_ports_, this_->input_ports_);
+}
+
 jack_widget::connection_widget_::connection_widget_(jack_widget* parent) :
   QGroupBox{ "Connections", parent },
   parent_{ parent }{
@@ -109,33 +109,34 @@ void main_window::parse_file(const QString& file_name, const QString& file_conte
     return;
   }
 
-  //map statements to components
-  vector<component::ptr> components;
+  //map statements to components, the circuit widget simplifies them
+  netlist_builder builder{true};
   auto statements_it = statements.cbegin();
 
   //first line is the circuit title
   const auto name = QString::fromStdString(*statements_it++);
   for(; statements_it != statements.cend(); ++statements_it) {
     const auto& statement = *statements_it;
-    component::ptr component;
-
-    auto statement_it = statement.begin();
-    bool good = qi::phrase_parse(statement_it, statement.end(),
-        statement_parser<string::const_iterator, qi::ascii::space_type>{},
-        qi::ascii::space,
-        component);
-    if(!good || statement_it != statement.end()) {
+    if(!builder.add(statement)) {
       QMessageBox::warning(this, tr(program_name),
           tr("Invalid syntax detected in statement:\n\"%1\"\n in file %2:\n")
             .arg(QString::fromStdString(statement),
               QDir::toNativeSeparators(file_name)));
       return;
     }
-    components.emplace_back(std::move(component));
   }
 
+  if(!builder.complete()) {
+    QMessageBox::warning(this, tr(program_name),
+        tr("Unterminated .SUBCKT in file %1.\n")
+          .arg(QDir::toNativeSeparators(file_name)));
+    return;
+  }
+
+  const auto& components = builder.components();
+
   //TODO: spawn circuit widget
-  circuit_ = new circuit_widget{name, components, this};
+  circuit_ = new circuit_widget{name, components, builder.log(), this};
   this->setCentralWidget(circuit_);
 
   open_file_action_->setDisabled(true);
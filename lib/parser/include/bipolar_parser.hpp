@@ -22,6 +22,7 @@
 #include "component_parser.hpp"
 #include <boost/spirit/include/phoenix_bind.hpp>
 
+#include "model_parser.hpp"
 #include "bipolar.hpp"
 
 
@@ -32,7 +33,7 @@ namespace rtspice::parser {
   template<class Iterator, class Skipper>
   struct bipolar_parser : component_parser<Iterator, Skipper> {
 
-    bipolar_parser() : component_parser<Iterator, Skipper>{ start_ } {
+    bipolar_parser(model_table& models) : component_parser<Iterator, Skipper>{ start_ } {
       using namespace qi;
 
       npn_ = (id_ //name
@@ -55,7 +56,14 @@ namespace rtspice::parser {
           >> lit("BR=") >> value_)[
         _val = bind(make_component<components::bipolar_pnp>, _1, _2, _3, _4, _5, _6, _7)];
 
-      start_ %= &lit('Q') >> (npn_ | pnp_);
+      //Q{ID} {NC} {NB} {NE} {MODEL}
+      npn_model_ = (id_ >> id_ >> id_ >> id_ >> models.npn)[
+        _val = bind(make_component<components::bipolar_npn>, _1, _2, _3, _4, _5)];
+
+      pnp_model_ = (id_ >> id_ >> id_ >> id_ >> models.pnp)[
+        _val = bind(make_component<components::bipolar_pnp>, _1, _2, _3, _4, _5)];
+
+      start_ %= &lit('Q') >> (npn_ | pnp_ | npn_model_ | pnp_model_);
     }
 
     private:
@@ -64,6 +72,8 @@ namespace rtspice::parser {
       qi::rule<Iterator, Skipper, components::component::ptr()> start_;
       qi::rule<Iterator, Skipper, component::ptr()> npn_;
       qi::rule<Iterator, Skipper, component::ptr()> pnp_;
+      qi::rule<Iterator, Skipper, component::ptr()> npn_model_;
+      qi::rule<Iterator, Skipper, component::ptr()> pnp_model_;
 
   };
 
@@ -25,7 +25,29 @@
 
 namespace rtspice::parser {
 
-  template<char Prefix, class F, class Iterator, class Skipper>
+  //integration methods by keyword, as option values
+  struct integration_methods : qi::symbols<char, float> {
+
+    integration_methods() {
+      using components::integration::method;
+      add
+        ("BE",     float(method::be))
+        ("TR",     float(method::tr))
+        ("BDF2",   float(method::bdf2))
+        ("TRBDF2", float(method::tr_bdf2));
+    }
+
+  };
+
+  /*!
+   * @brief generic parser for two terminal dynamic components
+   *
+   * F is the branch current formulation, used by default, while N is the
+   * Norton companion formulation, selected with a trailing NORTON keyword.
+   * A last keyword picks the integration method, else the one of the METHOD
+   * option applies.
+   */
+  template<char Prefix, class F, class N, class Iterator, class Skipper>
   struct dynamic_parser : component_parser<Iterator, Skipper> {
 
     dynamic_parser() : component_parser<Iterator, Skipper>{start_} {
@@ -33,25 +55,70 @@ namespace rtspice::parser {
       using namespace qi;
       using boost::phoenix::bind;
 
-      dynamic_ = (id_ >> id_ >> id_ >> value_)[
-        _val = bind(make_component<components::dynamic<F>>, _1, _2, _3, _4)];
+      method_ = methods_ | attr(float(components::integration::method::unspecified));
+
+      dynamic_ = (id_ >> id_ >> id_ >> value_ >> method_)[
+        _val = bind(&make_<components::dynamic, F>, _5, _1, _2, _3, _4)];
+
+      norton_ = (id_ >> id_ >> id_ >> value_ >> lit("NORTON") >> method_)[
+        _val = bind(&make_<components::companion, N>, _5, _1, _2, _3, _4)];
 
-      start_ %=  &lit(Prefix) >> (dynamic_);
+      start_ %=  &lit(Prefix) >> (norton_ | dynamic_);
     };
 
     private:
+      template<template<class, class> class D, class G>
+      static component::ptr make_(float m, const std::string& id,
+                                  const std::string& na, const std::string& nb,
+                                  float value) {
+        return components::make_integrated<D, G>(
+            static_cast<components::integration::method>(m), id, na, nb, value);
+      }
+
       using component_parser<Iterator, Skipper>::id_;
       using component_parser<Iterator, Skipper>::value_;
 
+      integration_methods                           methods_;
+      qi::rule<Iterator, Skipper, float()>          method_;
       qi::rule<Iterator, Skipper, component::ptr()> dynamic_;
+      qi::rule<Iterator, Skipper, component::ptr()> norton_;
       qi::rule<Iterator, Skipper, component::ptr()> start_;
   };
 
   template<class Iterator, class Skipper>
-  using capacitor_parser = dynamic_parser<'C', components::linear_capacitor_trapezoidal, Iterator, Skipper>;
+  using capacitor_parser = dynamic_parser<'C',
+        components::linear_capacitor_branch,
+        components::linear_capacitor_norton,
+        Iterator, Skipper>;
+
+  template<class Iterator, class Skipper>
+  using inductor_parser = dynamic_parser<'L',
+        components::linear_inductor_branch,
+        components::linear_inductor_norton,
+        Iterator, Skipper>;
 
+  /*!
+   * @brief parser for K statements, coupling two inductors
+   */
   template<class Iterator, class Skipper>
-  using inductor_parser = dynamic_parser<'L', components::linear_inductor_trapezoidal, Iterator, Skipper>;
+  struct coupling_parser : component_parser<Iterator, Skipper> {
+
+    coupling_parser() : component_parser<Iterator, Skipper>{start_} {
+
+      using namespace qi;
+      using boost::phoenix::bind;
+
+      //K{ID} {L_A} {L_B} {K}
+      start_ = (&lit('K') >> id_ >> id_ >> id_ >> value_)[
+        _val = bind(make_component<components::inductor_coupling>, _1, _2, _3, _4)];
+    };
+
+    private:
+      using component_parser<Iterator, Skipper>::id_;
+      using component_parser<Iterator, Skipper>::value_;
+
+      qi::rule<Iterator, Skipper, component::ptr()> start_;
+  };
 
 }		// -----  end of namespace rtspice::parser  -----
 
@@ -0,0 +1,76 @@
+/*!
+ *    @file  fet_parser.hpp
+ *   @brief  field effect transistor parser
+ *
+ *  @author  Thadeu Luiz Barbosa Dias (tlbd)
+ *
+ *  @internal
+ *       Created:  10/18/2026
+ *      Revision:  none
+ *      Compiler:  g++
+ *  Organization:  SMT - Signals, Multimedia and Telecommunications Lab
+ *     Copyright:  Copyright (c) 2019, Thadeu Luiz Barbosa Dias
+ *
+ *  This source code is released for free distribution under the terms of the
+ *  GNU General Public License as published by the Free Software Foundation.
+ */
+
+#ifndef  fet_parser_INC
+#define  fet_parser_INC
+
+#include "component_parser.hpp"
+
+#include <boost/spirit/include/phoenix_bind.hpp>
+
+#include "fet.hpp"
+
+namespace rtspice::parser {
+
+  namespace qi = boost::spirit::qi;
+
+  template<class Iterator, class Skipper>
+  struct fet_parser : component_parser<Iterator, Skipper> {
+
+    fet_parser() : component_parser<Iterator, Skipper>{ start_ } {
+
+      using namespace qi;
+      using boost::phoenix::bind;
+      using type = components::fet_device::type;
+
+      mos_type_.add("NMOS", type::nmos)("PMOS", type::pmos);
+      jfet_type_.add("NJF", type::njf)("PJF", type::pjf);
+
+      lambda_ = (lit("LAMBDA=") >> value_) | attr(0.0f);
+
+      //M{ID} {DRAIN} {GATE} {SOURCE} NMOS|PMOS VTO={VTO} KP={KP} [LAMBDA={L}]
+      mosfet_ = (&lit('M') >> id_ >> id_ >> id_ >> id_ >> mos_type_
+          >> lit("VTO=") >> value_
+          >> lit("KP=")  >> value_
+          >> lambda_)[
+        _val = bind(make_component<components::fet_array>, _1, _2, _3, _4, _5, _6, _7, _8)];
+
+      //J{ID} {DRAIN} {GATE} {SOURCE} NJF|PJF VTO={VTO} BETA={BETA} [LAMBDA={L}]
+      jfet_ = (&lit('J') >> id_ >> id_ >> id_ >> id_ >> jfet_type_
+          >> lit("VTO=")  >> value_
+          >> lit("BETA=") >> value_
+          >> lambda_)[
+        _val = bind(make_component<components::fet_array>, _1, _2, _3, _4, _5, _6, _7, _8)];
+
+      start_ %= mosfet_ | jfet_;
+    }
+
+    private:
+      using component_parser<Iterator, Skipper>::id_;
+      using component_parser<Iterator, Skipper>::value_;
+
+      qi::symbols<char, components::fet_device::type> mos_type_, jfet_type_;
+      qi::rule<Iterator, Skipper, float()> lambda_;
+      qi::rule<Iterator, Skipper, component::ptr()> mosfet_;
+      qi::rule<Iterator, Skipper, component::ptr()> jfet_;
+      qi::rule<Iterator, Skipper, component::ptr()> start_;
+
+  };
+
+}		// -----  end of namespace rtspice::parser  -----
+
+#endif   // ----- #ifndef fet_parser_INC  -----
@@ -0,0 +1,57 @@
+/*!
+ *    @file  line_parser.hpp
+ *   @brief  delay line parser
+ *
+ *  @author  Thadeu Luiz Barbosa Dias (tlbd)
+ *
+ *  @internal
+ *       Created:  10/18/2026
+ *      Revision:  none
+ *      Compiler:  g++
+ *  Organization:  SMT - Signals, Multimedia and Telecommunications Lab
+ *     Copyright:  Copyright (c) 2019, Thadeu Luiz Barbosa Dias
+ *
+ *  This source code is released for free distribution under the terms of the
+ *  GNU General Public License as published by the Free Software Foundation.
+ */
+
+#ifndef  line_parser_INC
+#define  line_parser_INC
+
+#include "component_parser.hpp"
+
+#include <boost/spirit/include/phoenix_bind.hpp>
+
+#include "line.hpp"
+
+namespace rtspice::parser {
+
+  namespace qi = boost::spirit::qi;
+
+  template<class Iterator, class Skipper>
+  struct delay_line_parser : component_parser<Iterator, Skipper> {
+
+    delay_line_parser() : component_parser<Iterator, Skipper>{start_} {
+
+      using namespace qi;
+      using boost::phoenix::bind;
+
+      //T{ID} {A+} {A-} {B+} {B-} Z0={Z} N={STEPS}, Z > 0 and STEPS >= 1
+      start_ = (&lit('T') >> id_ >> id_ >> id_ >> id_ >> id_
+          >> lit("Z0=") >> value_
+          >> lit("N=")  >> uint_)[
+        _pass = _6 > 0.0f && _7 > 0u,
+        _val  = bind(make_component<components::delay_line>, _1, _2, _3, _4, _5, _6, _7)];
+
+    };
+
+    private:
+      using component_parser<Iterator, Skipper>::id_;
+      using component_parser<Iterator, Skipper>::value_;
+
+      qi::rule<Iterator, Skipper, component::ptr()> start_;
+  };
+
+}		// -----  end of namespace rtspice::parser  -----
+
+#endif   // ----- #ifndef line_parser_INC  -----
@@ -0,0 +1,158 @@
+/*!
+ *    @file  model_parser.hpp
+ *   @brief  .MODEL statement parser
+ *
+ *  @author  Thadeu Luiz Barbosa Dias (tlbd)
+ *
+ *  @internal
+ *       Created:  10/18/2026
+ *      Revision:  none
+ *      Compiler:  g++
+ *  Organization:  SMT - Signals, Multimedia and Telecommunications Lab
+ *     Copyright:  Copyright (c) 2019, Thadeu Luiz Barbosa Dias
+ *
+ *  This source code is released for free distribution under the terms of the
+ *  GNU General Public License as published by the Free Software Foundation.
+ */
+
+#ifndef  model_parser_INC
+#define  model_parser_INC
+
+#include "component_parser.hpp"
+
+#include <boost/spirit/include/phoenix_bind.hpp>
+
+#include "resistor.hpp"
+#include "bipolar.hpp"
+#include "tube.hpp"
+#include "options.hpp"
+
+namespace rtspice::parser {
+
+  namespace qi = boost::spirit::qi;
+
+  /*!
+   * @brief models defined so far, looked up by name from device lines
+   *
+   * Starts with Koren's fits of common tubes, which a .MODEL may override.
+   */
+  struct model_table {
+
+    model_table() {
+      using namespace components;
+      triodes.add
+        ("12AX7", std::make_shared<const triode_model>(100.0f, 1.40f, 1060.0f, 600.0f, 300.0f, 2000.0f))
+        ("12AT7", std::make_shared<const triode_model>( 60.0f, 1.35f,  460.0f, 300.0f, 300.0f, 2000.0f))
+        ("12AU7", std::make_shared<const triode_model>( 21.5f, 1.30f, 1180.0f,  84.0f, 300.0f, 2000.0f));
+      pentodes.add
+        ("EL34",  std::make_shared<const pentode_model>(11.0f, 1.35f,  650.0f, 4200.0f, 60.0f, 24.0f, 2000.0f))
+        ("6L6GC", std::make_shared<const pentode_model>( 8.7f, 1.35f, 1460.0f, 4500.0f, 48.0f, 12.0f, 2000.0f));
+    }
+
+    qi::symbols<char, components::diode_model::ptr>   diodes;
+    qi::symbols<char, components::bipolar_model::ptr> npn, pnp;
+    qi::symbols<char, components::triode_model::ptr>  triodes;
+    qi::symbols<char, components::pentode_model::ptr> pentodes;
+  };
+
+  template<class Iterator, class Skipper>
+  struct model_parser : component_parser<Iterator, Skipper> {
+
+    model_parser(model_table& models) :
+      component_parser<Iterator, Skipper>{start_},
+      models_{ models } {
+
+      using namespace qi;
+
+      diode_ = (lit(".MODEL") >> id_ >> lit('D')
+          >> -lit('(')
+          >> lit("IS=") >> value_
+          >> lit("N=")  >> value_
+          >> ((lit("PWL=") >> value_) | attr(0.0f))
+          >> ((lit("ADAA=") >> value_) | attr(0.0f))
+          >> -lit(')'))[
+        _val = boost::phoenix::bind(&model_parser::diode_card_, this, _1, _2, _3, _4, _5)];
+
+      bipolar_ = (lit(".MODEL") >> id_ >> (qi::string("NPN") | qi::string("PNP"))
+          >> -lit('(')
+          >> lit("IS=") >> value_
+          >> lit("BF=") >> value_
+          >> lit("BR=") >> value_
+          >> ((lit("PWL=") >> value_) | attr(0.0f))
+          >> -lit(')'))[
+        _val = boost::phoenix::bind(&model_parser::bipolar_card_, this, _1, _2, _3, _4, _5, _6)];
+
+      triode_ = (lit(".MODEL") >> id_ >> lit("TRIODE")
+          >> -lit('(')
+          >> lit("MU=")  >> value_
+          >> lit("EX=")  >> value_
+          >> lit("KG1=") >> value_
+          >> lit("KP=")  >> value_
+          >> lit("KVB=") >> value_
+          >> ((lit("RGI=") >> value_) | attr(2000.0f))
+          >> -lit(')'))[
+        _val = boost::phoenix::bind(&model_parser::triode_card_, this, _1, _2, _3, _4, _5, _6, _7)];
+
+      pentode_ = (lit(".MODEL") >> id_ >> lit("PENTODE")
+          >> -lit('(')
+          >> lit("MU=")  >> value_
+          >> lit("EX=")  >> value_
+          >> lit("KG1=") >> value_
+          >> lit("KG2=") >> value_
+          >> lit("KP=")  >> value_
+          >> lit("KVB=") >> value_
+          >> ((lit("RGI=") >> value_) | attr(2000.0f))
+          >> -lit(')'))[
+        _val = boost::phoenix::bind(&model_parser::pentode_card_, this, _1, _2, _3, _4, _5, _6, _7, _8)];
+
+      start_ %= diode_ | bipolar_ | triode_ | pentode_;
+    };
+
+    private:
+      //a redefinition replaces the model for the devices that follow
+      //PWL is the number of segments of a piecewise linear junction, 0 if smooth
+      //ADAA is the antialiasing order of a smooth one, 0 if none
+      component::ptr diode_card_(const std::string& name, float IS, float N,
+                                 float PWL, float ADAA) {
+        models_.diodes.at(name) = std::make_shared<const components::diode_model>(
+            IS, N, static_cast<unsigned>(PWL), static_cast<unsigned>(ADAA));
+        return make_component<components::model_card>(name);
+      }
+
+      component::ptr bipolar_card_(const std::string& name, const std::string& type,
+                                   float IS, float BF, float BR, float PWL) {
+        auto& table = type == "NPN" ? models_.npn : models_.pnp;
+        table.at(name) = std::make_shared<const components::bipolar_model>(
+            IS, BF, BR, static_cast<unsigned>(PWL));
+        return make_component<components::model_card>(name);
+      }
+
+      component::ptr triode_card_(const std::string& name, float MU, float EX,
+                                  float KG1, float KP, float KVB, float RGI) {
+        models_.triodes.at(name) = std::make_shared<const components::triode_model>(
+            MU, EX, KG1, KP, KVB, RGI);
+        return make_component<components::model_card>(name);
+      }
+
+      component::ptr pentode_card_(const std::string& name, float MU, float EX,
+                                   float KG1, float KG2, float KP, float KVB, float RGI) {
+        models_.pentodes.at(name) = std::make_shared<const components::pentode_model>(
+            MU, EX, KG1, KG2, KP, KVB, RGI);
+        return make_component<components::model_card>(name);
+      }
+
+      using component_parser<Iterator, Skipper>::id_;
+      using component_parser<Iterator, Skipper>::value_;
+
+      model_table& models_;
+
+      qi::rule<Iterator, Skipper, component::ptr()> diode_;
+      qi::rule<Iterator, Skipper, component::ptr()> bipolar_;
+      qi::rule<Iterator, Skipper, component::ptr()> triode_;
+      qi::rule<Iterator, Skipper, component::ptr()> pentode_;
+      qi::rule<Iterator, Skipper, component::ptr()> start_;
+  };
+
+}		// -----  end of namespace rtspice::parser  -----
+
+#endif   // ----- #ifndef model_parser_INC  -----
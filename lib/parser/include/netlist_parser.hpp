@@ -21,10 +21,22 @@
 
 #include "probe_parser.hpp"
 #include "resistor_parser.hpp"
+#include "potentiometer_parser.hpp"
+#include "switch_parser.hpp"
+#include "line_parser.hpp"
 #include "source_parser.hpp"
 #include "dynamic_parser.hpp"
 #include "opamp_parser.hpp"
 #include "bipolar_parser.hpp"
+#include "tube_parser.hpp"
+#include "fet_parser.hpp"
+#include "options_parser.hpp"
+#include "model_parser.hpp"
+
+#include "passes.hpp"
+
+#include <algorithm>
+#include <map>
 
 #include <boost/spirit/include/qi.hpp>
 #include <boost/spirit/include/phoenix_stl.hpp>
@@ -72,33 +84,221 @@ namespace rtspice::parser {
   struct statement_parser : component_parser<Iterator, Skipper> {
 
     statement_parser() :
-      component_parser<Iterator, Skipper>{ start_ } {
+      component_parser<Iterator, Skipper>{ start_ },
+      diode_{ models_ },
+      bipolar_{ models_ },
+      tube_{ models_ },
+      model_{ models_ } {
 
         start_ %= probe_
+          | options_
+          | model_
           | resistor_
+          | potentiometer_
+          | switch_
           | source_
           | capacitor_
           | inductor_
+          | coupling_
+          | line_
           | diode_
           | opamp_
-          | bipolar_;
+          | bipolar_
+          | fet_
+          | tube_;
 
     }
 
     private:
       qi::rule<Iterator, Skipper, components::component::ptr()> start_;
 
+      model_table models_; //shared by the device parsers below
+
       probe_parser         <Iterator, Skipper>   probe_;
       resistor_parser      <Iterator, Skipper>   resistor_;
+      potentiometer_parser <Iterator, Skipper>   potentiometer_;
+      switch_parser        <Iterator, Skipper>   switch_;
       diode_parser         <Iterator, Skipper>   diode_;
       source_parser        <Iterator, Skipper>   source_;
       capacitor_parser     <Iterator, Skipper>   capacitor_;
       inductor_parser      <Iterator, Skipper>   inductor_;
+      coupling_parser      <Iterator, Skipper>   coupling_;
+      delay_line_parser    <Iterator, Skipper>   line_;
       opamp_parser         <Iterator, Skipper>   opamp_;
       bipolar_parser       <Iterator, Skipper>   bipolar_;
+      fet_parser           <Iterator, Skipper>   fet_;
+      tube_parser          <Iterator, Skipper>   tube_;
+      options_parser       <Iterator, Skipper>   options_;
+      model_parser         <Iterator, Skipper>   model_;
   };
 
 
+  /*!
+   * @brief qi grammar for subcircuit statements
+   *
+   * .SUBCKT, .ENDS and X instance lines, output as their list of names
+   */
+  template<class Iterator, class Skipper>
+  struct subckt_parser : qi::grammar<Iterator, Skipper, std::vector<std::string>()> {
+
+    subckt_parser() : subckt_parser::base_type{start_} {
+
+      using namespace qi;
+
+      name_  %= +(alnum | char_('_'));
+      start_ %= (qi::string(".SUBCKT") >> +name_)
+              | (qi::string(".ENDS")   >> *name_)
+              | (&lit('X') >> +name_);
+
+    }
+
+    private:
+      qi::rule<Iterator, std::string()>                          name_;
+      qi::rule<Iterator, Skipper, std::vector<std::string>()>    start_;
+  };
+
+  /*!
+   * @brief turns netlist statements into a flat component list
+   *
+   * Each subcircuit is stored as written, but for its own METHOD, EXPM and K
+   * cards, applied when its .ENDS is read. Every X instance then clones that
+   * template under its own names: internal nodes and ids are prefixed by the
+   * instance name, i.e. "X1.". A precompiling builder, meant for circuits
+   * built with simplify, also reduces each template once by the netlist
+   * passes, with its ports pinned, and instances share the stamps of its
+   * reduced blocks. The instances themselves are still simplified again
+   * with the rest of the circuit.
+   *
+   * A K card must follow both inductors it couples, in its own scope.
+   */
+  class netlist_builder {
+    public:
+      using iterator = std::string::const_iterator;
+      using skipper  = qi::ascii::space_type;
+
+      explicit netlist_builder(bool precompile = false) :
+        precompile_{ precompile } {}
+
+      //false on invalid syntax, unknown subcircuit, port count mismatch or
+      //K card naming an inductor not defined before it
+      bool add(const std::string& statement) {
+
+        std::vector<std::string> names;
+        auto it = statement.begin();
+        if(qi::phrase_parse(it, statement.end(), subckt_, qi::ascii::space, names)
+            && it == statement.end())
+          return hierarchy_(names);
+
+        component::ptr c;
+        it = statement.begin();
+        if(!qi::phrase_parse(it, statement.end(), statement_, qi::ascii::space, c)
+            || it != statement.end())
+          return false;
+
+        if(const auto k = std::dynamic_pointer_cast<components::inductor_coupling>(c))
+          if(!inductor_(k->first()) || !inductor_(k->second()))
+            return false;
+
+        target_().push_back(std::move(c));
+        return true;
+      }
+
+      //false while a .SUBCKT is left open
+      bool complete() const { return open_.empty(); }
+
+      const auto& components() const { return top_; }
+
+      //notes from resolving the K cards of each .SUBCKT
+      const auto& log() const { return log_; }
+
+    private:
+      struct definition {
+        std::vector<std::string>    ports;
+        std::vector<component::ptr> prototype;
+      };
+
+      std::vector<component::ptr>& target_() {
+        return open_.empty() ? top_ : open_.back().second.prototype;
+      }
+
+      bool inductor_(const std::string& id) {
+        const auto& t = target_();
+        return std::any_of(t.begin(), t.end(), [&](auto&& c) {
+              return c->id() == id && components::inductance(*c) > 0.0f;
+            });
+      }
+
+      bool hierarchy_(const std::vector<std::string>& names) {
+
+        if(names.front() == ".SUBCKT") {
+          if(names.size() < 2) return false;
+          open_.push_back({names[1], {{names.begin() + 2, names.end()}, {}}});
+          return true;
+        }
+
+        if(names.front() == ".ENDS") {
+          if(open_.empty()) return false;
+
+          auto [name, def] = std::move(open_.back());
+          open_.pop_back();
+          if(names.size() > 1 && names[1] != name) return false;
+
+          //ports must survive like probes
+          auto pinned = circuit::passes::pinned(def.prototype);
+          pinned.insert(def.ports.begin(), def.ports.end());
+
+          //a METHOD or EXPM of its own comes before the global one, and K
+          //cards are resolved before anything can take their inductors
+          circuit::passes::apply_method(def.prototype, pinned);
+          std::vector<std::string> notes;
+          circuit::passes::couple_inductors(def.prototype, pinned, notes);
+          for(auto&& n: notes) log_.push_back(name + ": " + n);
+          circuit::passes::expm_discretize(def.prototype, pinned);
+
+          if(precompile_)
+            for(auto&& [_, run]: circuit::passes::pipeline)
+              run(def.prototype, pinned);
+
+          //options only apply to the definition itself
+          auto& proto = def.prototype;
+          proto.erase(std::remove_if(proto.begin(), proto.end(), [](auto&& c) {
+                return std::dynamic_pointer_cast<components::options>(c) != nullptr;
+              }), proto.end());
+
+          subckts_[name] = std::move(def);
+          return true;
+        }
+
+        //X{ID} {NODES...} {SUBCKT}
+        if(names.size() < 2) return false;
+
+        const auto it = subckts_.find(names.back());
+        if(it == subckts_.end()) return false;
+
+        const auto& def = it->second;
+        if(def.ports.size() != names.size() - 2) return false;
+
+        components::renamer r{names.front() + ".", {}};
+        for(std::size_t i = 0; i < def.ports.size(); ++i)
+          r.ports[def.ports[i]] = names[i + 1];
+
+        auto& target = target_();
+        for(auto&& c: def.prototype) target.push_back(c->clone(r));
+
+        return true;
+      }
+
+      const bool precompile_;
+
+      std::vector<component::ptr> top_;
+      std::vector<std::string>    log_;
+      std::vector<std::pair<std::string, definition>> open_; //being defined
+      std::map<std::string, definition> subckts_;
+
+      subckt_parser   <iterator, skipper> subckt_;
+      statement_parser<iterator, skipper> statement_;
+  };
+
 }		// -----  end of namespace rtspice::parser  -----
 
 #endif   // ----- #ifndef netlist_parser_INC  -----
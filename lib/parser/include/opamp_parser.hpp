@@ -38,12 +38,25 @@ namespace rtspice::parser {
       ideal_opamp_ = (id_ >> id_ >> id_ >> id_ >> id_ >> lit("OPAMP"))[
         _val = bind(make_component<components::ideal_opamp>, _1, _2, _3, _4, _5)];
 
-      start_ %=  &lit('U') >> (ideal_opamp_);
+      //U{ID} {OUT+} {OUT-} {IN+} {IN-} OPAMP VNEG={V} VPOS={V} [AOL={A}] [GBW={F}]
+      rail_opamp_ = (id_ >> id_ >> id_ >> id_ >> id_ >> lit("OPAMP")
+          >> lit("VNEG=") >> value_
+          >> lit("VPOS=") >> value_
+          >> ((lit("AOL=") >> value_) | attr(default_gain))
+          >> ((lit("GBW=") >> value_) | attr(0.0f)))[
+        _val = bind(make_component<components::rail_opamp>,
+                    _1, _2, _3, _4, _5, _8, _6, _7, _9)];
+
+      start_ %=  &lit('U') >> (rail_opamp_ | ideal_opamp_);
     };
 
     private:
+      static constexpr float default_gain = 1e5f;
+
       using component_parser<Iterator, Skipper>::id_;
+      using component_parser<Iterator, Skipper>::value_;
       qi::rule<Iterator, Skipper, component::ptr()> ideal_opamp_;
+      qi::rule<Iterator, Skipper, component::ptr()> rail_opamp_;
       qi::rule<Iterator, Skipper, component::ptr()> start_;
   };
 
@@ -0,0 +1,62 @@
+/*!
+ *    @file  options_parser.hpp
+ *   @brief  .OPTIONS statement parser
+ *
+ *  @author  Thadeu Luiz Barbosa Dias (tlbd)
+ *
+ *  @internal
+ *       Created:  10/18/2026
+ *      Revision:  none
+ *      Compiler:  g++
+ *  Organization:  SMT - Signals, Multimedia and Telecommunications Lab
+ *     Copyright:  Copyright (c) 2019, Thadeu Luiz Barbosa Dias
+ *
+ *  This source code is released for free distribution under the terms of the
+ *  GNU General Public License as published by the Free Software Foundation.
+ */
+
+#ifndef  options_parser_INC
+#define  options_parser_INC
+
+#include "component_parser.hpp"
+
+#include <boost/fusion/include/std_pair.hpp>
+#include <boost/spirit/include/phoenix_bind.hpp>
+
+#include "options.hpp"
+#include "dynamic_parser.hpp"
+
+namespace rtspice::parser {
+
+  template<class Iterator, class Skipper>
+  struct options_parser : component_parser<Iterator, Skipper> {
+
+    options_parser() : component_parser<Iterator, Skipper>{start_} {
+
+      using namespace qi;
+      using boost::phoenix::bind;
+
+      key_   %= +(alnum | char_('_'));
+      value_pair_ %= key_ >> '=' >> (methods_ | value_);
+
+      start_ = (lit(".OPTIONS") >> +value_pair_)[
+        _val = bind(make_component<components::options>, _1)]
+        | (lit(".SLOW") >> uint_ >> matches[lit("HOLD")])[
+        _val = boost::phoenix::bind(make_component<components::partition_card>,
+                                    std::string{".SLOW"}, _1, _2, false)]
+        | lit(".PARTITION")[
+        _val = boost::phoenix::bind(make_component<components::partition_card>,
+                                    std::string{".PARTITION"}, 1u, true, true)];
+    };
+
+    private:
+      using component_parser<Iterator, Skipper>::value_;
+      integration_methods                                            methods_;
+      qi::rule<Iterator, std::string()>                              key_;
+      qi::rule<Iterator, Skipper, std::pair<std::string, float>()>   value_pair_;
+      qi::rule<Iterator, Skipper, component::ptr()>                  start_;
+  };
+
+}		// -----  end of namespace rtspice::parser  -----
+
+#endif   // ----- #ifndef options_parser_INC  -----
@@ -0,0 +1,68 @@
+/*!
+ *    @file  potentiometer_parser.hpp
+ *   @brief  potentiometer parser
+ *
+ *  @author  Thadeu Luiz Barbosa Dias (tlbd)
+ *
+ *  @internal
+ *       Created:  10/18/2026
+ *      Revision:  none
+ *      Compiler:  g++
+ *  Organization:  SMT - Signals, Multimedia and Telecommunications Lab
+ *     Copyright:  Copyright (c) 2019, Thadeu Luiz Barbosa Dias
+ *
+ *  This source code is released for free distribution under the terms of the
+ *  GNU General Public License as published by the Free Software Foundation.
+ */
+
+#ifndef  potentiometer_parser_INC
+#define  potentiometer_parser_INC
+
+#include "component_parser.hpp"
+
+#include <boost/spirit/include/phoenix_bind.hpp>
+
+#include "potentiometer.hpp"
+
+namespace rtspice::parser {
+
+  namespace qi = boost::spirit::qi;
+
+  struct taper_names : qi::symbols<char, components::taper> {
+
+    taper_names() {
+      add
+        ("LIN",  components::taper::linear)
+        ("LOG",  components::taper::log)
+        ("ALOG", components::taper::antilog);
+    }
+
+  };
+
+  template<class Iterator, class Skipper>
+  struct potentiometer_parser : component_parser<Iterator, Skipper> {
+
+    potentiometer_parser() : component_parser<Iterator, Skipper>{start_} {
+
+      using namespace qi;
+      using boost::phoenix::bind;
+
+      //P{ID} {NODE_A} {WIPER} {NODE_B} POT {VALUE} {PARAM} [{TAPER}]
+      start_ = (&lit('P') >> id_ >> id_ >> id_ >> id_
+          >> lit("POT") >> value_ >> id_
+          >> (taper_ | attr(components::taper::linear)))[
+        _val = bind(make_component<components::potentiometer>, _1, _2, _3, _4, _5, _6, _7)];
+
+    };
+
+    private:
+      using component_parser<Iterator, Skipper>::id_;
+      using component_parser<Iterator, Skipper>::value_;
+
+      taper_names taper_;
+      qi::rule<Iterator, Skipper, component::ptr()> start_;
+  };
+
+}		// -----  end of namespace rtspice::parser  -----
+
+#endif   // ----- #ifndef potentiometer_parser_INC  -----
@@ -35,13 +35,17 @@ namespace rtspice::parser {
       using namespace qi;
       using boost::phoenix::bind;
 
-      start_ =  lit("PROBE") >> id_[
+      //'@' allows probing of internal variables, i.e. branch currents, and
+      //'.' the nodes inside subcircuit instances
+      variable_ %= +(alnum | char_('@') | char_('.'));
+
+      start_ =  lit("PROBE") >> variable_[
         _val = bind(make_component<components::probe>, _1)];
 
     };
 
     private:
-      using component_parser<Iterator, Skipper>::id_;
+      qi::rule<Iterator, std::string()>             variable_;
       qi::rule<Iterator, Skipper, component::ptr()> start_;
   };
 
@@ -22,6 +22,7 @@
 
 #include <boost/spirit/include/phoenix_bind.hpp>
 
+#include "model_parser.hpp"
 #include "resistor.hpp"
 
 namespace rtspice::parser {
@@ -58,7 +59,7 @@ namespace rtspice::parser {
   template<class Iterator, class Skipper>
   struct diode_parser : component_parser<Iterator, Skipper> {
 
-    diode_parser() : component_parser<Iterator, Skipper>{start_} {
+    diode_parser(model_table& models) : component_parser<Iterator, Skipper>{start_} {
 
       using namespace qi;
       using boost::phoenix::bind;
@@ -66,7 +67,11 @@ namespace rtspice::parser {
       basic_diode_ = (id_ >> id_ >> id_>> lit("IS=") >> value_ >> lit("N=") >> value_)[
         _val = bind(make_component<components::basic_diode>, _1, _2, _3, _4, _5)];
 
-      start_ %=  &lit('D') >> basic_diode_;
+      model_diode_ = (id_ >> id_ >> id_ >> models.diodes)[
+        _val = bind(make_component<components::basic_diode>,
+                    _1, _2, _3, _4)];
+
+      start_ %=  &lit('D') >> (basic_diode_ | model_diode_);
 
     };
 
@@ -75,6 +80,7 @@ namespace rtspice::parser {
       using component_parser<Iterator, Skipper>::value_;
 
       qi::rule<Iterator, Skipper, component::ptr()> basic_diode_;
+      qi::rule<Iterator, Skipper, component::ptr()> model_diode_;
       qi::rule<Iterator, Skipper, component::ptr()> start_;
   };
 
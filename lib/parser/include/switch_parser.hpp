@@ -0,0 +1,58 @@
+/*!
+ *    @file  switch_parser.hpp
+ *   @brief  switch parser
+ *
+ *  @author  Thadeu Luiz Barbosa Dias (tlbd)
+ *
+ *  @internal
+ *       Created:  10/18/2026
+ *      Revision:  none
+ *      Compiler:  g++
+ *  Organization:  SMT - Signals, Multimedia and Telecommunications Lab
+ *     Copyright:  Copyright (c) 2019, Thadeu Luiz Barbosa Dias
+ *
+ *  This source code is released for free distribution under the terms of the
+ *  GNU General Public License as published by the Free Software Foundation.
+ */
+
+#ifndef  switch_parser_INC
+#define  switch_parser_INC
+
+#include "component_parser.hpp"
+
+#include <boost/spirit/include/phoenix_bind.hpp>
+
+#include "switch.hpp"
+
+namespace rtspice::parser {
+
+  namespace qi = boost::spirit::qi;
+
+  template<class Iterator, class Skipper>
+  struct switch_parser : component_parser<Iterator, Skipper> {
+
+    switch_parser() : component_parser<Iterator, Skipper>{start_} {
+
+      using namespace qi;
+      using boost::phoenix::bind;
+
+      //S{ID} {NODE_A} {NODE_B} SW {PARAM} [NC] [RON={R}] [ROFF={R}]
+      start_ = (&lit('S') >> id_ >> id_ >> id_
+          >> lit("SW") >> id_
+          >> matches[lit("NC")]
+          >> ((lit("RON=")  >> value_) | attr(components::spst_switch::Ron))
+          >> ((lit("ROFF=") >> value_) | attr(components::spst_switch::Roff)))[
+        _val = bind(make_component<components::spst_switch>, _1, _2, _3, _4, _5, _6, _7)];
+
+    };
+
+    private:
+      using component_parser<Iterator, Skipper>::id_;
+      using component_parser<Iterator, Skipper>::value_;
+
+      qi::rule<Iterator, Skipper, component::ptr()> start_;
+  };
+
+}		// -----  end of namespace rtspice::parser  -----
+
+#endif   // ----- #ifndef switch_parser_INC  -----
@@ -0,0 +1,61 @@
+/*!
+ *    @file  tube_parser.hpp
+ *   @brief  vacuum tube parser
+ *
+ *  @author  Thadeu Luiz Barbosa Dias (tlbd)
+ *
+ *  @internal
+ *       Created:  10/18/2026
+ *      Revision:  none
+ *      Compiler:  g++
+ *  Organization:  SMT - Signals, Multimedia and Telecommunications Lab
+ *     Copyright:  Copyright (c) 2019, Thadeu Luiz Barbosa Dias
+ *
+ *  This source code is released for free distribution under the terms of the
+ *  GNU General Public License as published by the Free Software Foundation.
+ */
+
+#ifndef  tube_parser_INC
+#define  tube_parser_INC
+
+#include "component_parser.hpp"
+
+#include <boost/spirit/include/phoenix_bind.hpp>
+
+#include "model_parser.hpp"
+#include "tube.hpp"
+
+namespace rtspice::parser {
+
+  namespace qi = boost::spirit::qi;
+
+  template<class Iterator, class Skipper>
+  struct tube_parser : component_parser<Iterator, Skipper> {
+
+    tube_parser(model_table& models) : component_parser<Iterator, Skipper>{start_} {
+
+      using namespace qi;
+      using boost::phoenix::bind;
+
+      //U{ID} {PLATE} {GRID} {CATHODE} {MODEL}
+      triode_ = (id_ >> id_ >> id_ >> id_ >> models.triodes)[
+        _val = bind(make_component<components::triode>, _1, _2, _3, _4, _5)];
+
+      //U{ID} {PLATE} {SCREEN} {GRID} {CATHODE} {MODEL}
+      pentode_ = (id_ >> id_ >> id_ >> id_ >> id_ >> models.pentodes)[
+        _val = bind(make_component<components::pentode>, _1, _2, _3, _4, _5, _6)];
+
+      start_ %= &lit('U') >> (triode_ | pentode_);
+    };
+
+    private:
+      using component_parser<Iterator, Skipper>::id_;
+
+      qi::rule<Iterator, Skipper, component::ptr()> triode_;
+      qi::rule<Iterator, Skipper, component::ptr()> pentode_;
+      qi::rule<Iterator, Skipper, component::ptr()> start_;
+  };
+
+}		// -----  end of namespace rtspice::parser  -----
+
+#endif   // ----- #ifndef tube_parser_INC  -----
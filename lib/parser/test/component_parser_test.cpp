@@ -18,6 +18,7 @@
 #include <catch2/catch.hpp>
 
 #include "netlist_parser.hpp"
+#include "circuit.hpp"
 
 using namespace std;
 using namespace std::string_literals;
@@ -303,6 +304,140 @@ SCENARIO("dynamic component parser", "[statement_parser]") {
     }
   }
 
+  GIVEN("a Norton companion capacitor statement") {
+
+    const string statement = "CX net0 net1 4.7e-9 NORTON";
+
+    WHEN("parsed") {
+
+      component::ptr component_;
+
+      auto begin = statement.cbegin();
+      auto end   = statement.cend();
+
+      auto ok = qi::phrase_parse(begin,
+                                 end,
+                                 grammar,
+                                 qi::space,
+                                 component_);
+
+      THEN("parsing is successful") {
+        REQUIRE(ok == true);
+        REQUIRE(begin == end);
+      }
+      THEN("component is created") {
+        REQUIRE(component_ != nullptr);
+        REQUIRE(component_->id() == "CX"s);
+        REQUIRE(dynamic_pointer_cast<norton_capacitor>(component_) != nullptr);
+      }
+    }
+  }
+
+  GIVEN("statements picking their integration method") {
+
+    const vector<string> statements {
+      "CX net0 net1 4.7e-9 BDF2",
+      "LX net0 net1 10m NORTON BE",
+    };
+
+    vector<component::ptr> cs(statements.size());
+
+    const auto ok = [&] {
+      for(size_t i = 0; i < statements.size(); ++i) {
+        auto begin = statements[i].cbegin();
+        if(!qi::phrase_parse(begin, statements[i].cend(), grammar, qi::space, cs[i]) ||
+           begin != statements[i].cend())
+          return false;
+      }
+      return true;
+    }();
+
+    THEN("the method is part of the component type") {
+      REQUIRE(ok);
+      REQUIRE(dynamic_pointer_cast<dynamic<linear_capacitor_branch, integration::bdf2>>(cs[0]) != nullptr);
+      REQUIRE(dynamic_pointer_cast<companion<linear_inductor_norton, integration::backward_euler>>(cs[1]) != nullptr);
+      REQUIRE(dynamic_pointer_cast<linear_capacitor>(cs[0]) == nullptr);
+    }
+
+    THEN("the values are read whatever the method") {
+      REQUIRE(capacitance(*cs[0]) == Approx(4.7e-9f));
+      REQUIRE(inductance(*cs[1]) == Approx(10e-3f));
+      REQUIRE(inductance(*cs[0]) == 0.0f);
+    }
+  }
+
+  GIVEN("a METHOD option over lines with and without a method") {
+
+    netlist_builder builder;
+    for(auto&& s: {"CX net0 net1 1u TR", "CY net0 net1 1u", ".OPTIONS METHOD=BE"})
+      REQUIRE(builder.add(s));
+
+    auto cs = builder.components();
+    rtspice::circuit::passes::apply_method(cs, {});
+
+    THEN("only the line naming none follows it") {
+      REQUIRE(dynamic_pointer_cast<dynamic<linear_capacitor_branch, integration::trapezoidal>>(cs[0]) != nullptr);
+      REQUIRE(dynamic_pointer_cast<dynamic<linear_capacitor_branch, integration::backward_euler>>(cs[1]) != nullptr);
+    }
+  }
+
+  GIVEN("a coupling statement") {
+
+    const string statement = "KX L1 L2 0.999";
+
+    WHEN("parsed") {
+
+      component::ptr component_;
+
+      auto begin = statement.cbegin();
+      auto end   = statement.cend();
+
+      auto ok = qi::phrase_parse(begin,
+                                 end,
+                                 grammar,
+                                 qi::space,
+                                 component_);
+
+      THEN("parsing is successful") {
+        REQUIRE(ok == true);
+        REQUIRE(begin == end);
+      }
+      THEN("component is created") {
+        REQUIRE(component_ != nullptr);
+        REQUIRE(component_->id() == "KX"s);
+        auto k = dynamic_pointer_cast<inductor_coupling>(component_);
+        REQUIRE(k != nullptr);
+        REQUIRE(k->first() == "L1"s);
+        REQUIRE(k->second() == "L2"s);
+        REQUIRE(k->coefficient() == Approx(0.999f));
+      }
+    }
+  }
+
+  GIVEN("K cards in a netlist") {
+
+    netlist_builder builder;
+    for(auto&& s: {"L1 a 0 1m", ".SUBCKT T p s", "L1 p 0 1m", "L2 s 0 4m"})
+      REQUIRE(builder.add(s));
+
+    THEN("they must follow both inductors, in their own scope") {
+      REQUIRE(builder.add("K1 L1 L2 0.5"));
+      REQUIRE(!builder.add("K2 L1 L3 0.5"));
+      REQUIRE(builder.add(".ENDS"));
+      REQUIRE(!builder.add("K3 L1 L2 0.5"));
+      REQUIRE(builder.add("X1 a b T"));
+      REQUIRE(builder.add("L2 b 0 1m"));
+      REQUIRE(builder.add("K4 L1 L2 0.5"));
+      REQUIRE(!builder.add("K5 L1 R1 0.5"));
+    }
+
+    THEN("a clamped coefficient is noted with its subcircuit") {
+      REQUIRE(builder.add("K1 L1 L2 1.5"));
+      REQUIRE(builder.add(".ENDS"));
+      REQUIRE(builder.log() == vector<string>{"T: coupling: K1 clamped to 0.9999"});
+    }
+  }
+
 }
 
 SCENARIO("OPAMP parsing", "[statement_parser]") {
@@ -335,5 +470,533 @@ SCENARIO("OPAMP parsing", "[statement_parser]") {
       }
     }
   }
+
+  GIVEN("a rail limited OPAMP statement") {
+
+    const string statement = "UX net0 net1 net2 net3 OPAMP VNEG=-4.5 VPOS=9 GBW=1M";
+
+    WHEN("parsed") {
+
+      component::ptr component_;
+
+      auto begin = statement.cbegin();
+      auto end   = statement.cend();
+
+      auto ok = qi::phrase_parse(begin,
+                                 end,
+                                 grammar,
+                                 qi::space,
+                                 component_);
+
+      THEN("parsing is successful") {
+        REQUIRE(ok == true);
+        REQUIRE(begin == end);
+      }
+      THEN("component is created") {
+        REQUIRE(component_ != nullptr);
+        REQUIRE(component_->id() == "UX"s);
+        auto u = dynamic_pointer_cast<rail_opamp>(component_);
+        REQUIRE(u != nullptr);
+        REQUIRE(u->function().neg_rail() == -4.5f);
+        REQUIRE(u->function().pos_rail() == 9.0f);
+        REQUIRE(u->function().gain() == 1e5f);
+        REQUIRE(u->function().gbw() == Approx(1e6f));
+      }
+    }
+  }
 }
 
+
+SCENARIO("potentiometer parsing", "[statement_parser]") {
+
+  GIVEN("potentiometer statements") {
+
+    const vector<string> statements {
+      "P1 in out 0 POT 100k Volume LOG",
+      "PTONE a t b POT 20k Tone",
+    };
+
+    for(auto&& statement: statements) {
+
+      component::ptr component_;
+
+      auto begin = statement.cbegin();
+      auto end   = statement.cend();
+
+      auto ok = qi::phrase_parse(begin,
+                                 end,
+                                 grammar,
+                                 qi::space,
+                                 component_);
+
+      THEN("parsing is successful") {
+        REQUIRE(ok == true);
+        REQUIRE(begin == end);
+        REQUIRE(dynamic_pointer_cast<potentiometer>(component_) != nullptr);
+        REQUIRE(component_->terminals().size() == 3);
+      }
+    }
+  }
+}
+
+SCENARIO("switch parsing", "[statement_parser]") {
+
+  GIVEN("switch statements") {
+
+    const vector<string> statements {
+      "S1 a b SW Bright",
+      "SCH2 out b SW Channel NC RON=1 ROFF=10M",
+    };
+
+    for(auto&& statement: statements) {
+
+      component::ptr component_;
+
+      auto begin = statement.cbegin();
+      auto end   = statement.cend();
+
+      auto ok = qi::phrase_parse(begin,
+                                 end,
+                                 grammar,
+                                 qi::space,
+                                 component_);
+
+      THEN("parsing is successful") {
+        REQUIRE(ok == true);
+        REQUIRE(begin == end);
+        REQUIRE(dynamic_pointer_cast<spst_switch>(component_) != nullptr);
+      }
+    }
+  }
+}
+
+SCENARIO("delay line parsing", "[statement_parser]") {
+
+  GIVEN("a delay line statement") {
+
+    component::ptr component_;
+
+    const string statement = "T1 a 0 b 0 Z0=600 N=480";
+    auto begin = statement.cbegin();
+    const auto ok = qi::phrase_parse(begin, statement.cend(), grammar, qi::space, component_);
+
+    THEN("parsing is successful") {
+      REQUIRE(ok == true);
+      REQUIRE(begin == statement.cend());
+      const auto t = dynamic_pointer_cast<delay_line>(component_);
+      REQUIRE(t != nullptr);
+      REQUIRE(t->impedance() == 600.0f);
+      REQUIRE(t->steps() == 480);
+      REQUIRE(t->terminals() == vector<string>{"a", "0", "b", "0"});
+    }
+  }
+
+  GIVEN("delay lines without delay or impedance") {
+
+    THEN("they are rejected") {
+      for(const string statement: {"T1 a 0 b 0 Z0=600 N=0", "T1 a 0 b 0 Z0=0 N=4",
+                                   "T1 a 0 b 0 Z0=-50 N=4"}) {
+        component::ptr component_;
+        auto begin = statement.cbegin();
+        const auto ok = qi::phrase_parse(begin, statement.cend(), grammar, qi::space, component_);
+        CHECK(!(ok && begin == statement.cend()));
+      }
+    }
+  }
+}
+
+SCENARIO("FET parsing", "[statement_parser]") {
+
+  GIVEN("MOSFET and JFET statements") {
+
+    const vector<string> statements {
+      "M1 d g s NMOS VTO=0.7 KP=20u",
+      "M2 d g s PMOS VTO=-0.7 KP=10u LAMBDA=20m",
+      "J1 d g s NJF VTO=-2 BETA=1.3m",
+      "JX d g 0 PJF VTO=2 BETA=1m LAMBDA=1m",
+    };
+
+    for(auto&& statement: statements) {
+
+      component::ptr component_;
+
+      auto begin = statement.cbegin();
+      auto end   = statement.cend();
+
+      auto ok = qi::phrase_parse(begin,
+                                 end,
+                                 grammar,
+                                 qi::space,
+                                 component_);
+
+      THEN("parsing is successful") {
+        REQUIRE(ok == true);
+        REQUIRE(begin == end);
+        const auto f = dynamic_pointer_cast<fet_array>(component_);
+        REQUIRE(f != nullptr);
+        REQUIRE(f->devices().size() == 1);
+      }
+    }
+  }
+}
+
+SCENARIO("options parsing", "[statement_parser]") {
+
+  GIVEN("an .OPTIONS statement") {
+
+    const string statement = ".OPTIONS PRIMA_ORDER=4 PRIMA_TOL=1m METHOD=TRBDF2";
+
+    WHEN("parsed") {
+
+      component::ptr component_;
+
+      auto begin = statement.cbegin();
+      auto end   = statement.cend();
+
+      auto ok = qi::phrase_parse(begin,
+                                 end,
+                                 grammar,
+                                 qi::space,
+                                 component_);
+
+      THEN("parsing is successful") {
+        REQUIRE(ok == true);
+        REQUIRE(begin == end);
+      }
+      THEN("component is created") {
+        const auto opts = dynamic_pointer_cast<options>(component_);
+        REQUIRE(opts != nullptr);
+        REQUIRE(opts->values().size() == 3);
+        REQUIRE(opts->values()[0].first == "PRIMA_ORDER"s);
+        REQUIRE(opts->values()[1].second == Approx(1e-3f));
+        REQUIRE(opts->values()[2].second == float(integration::method::tr_bdf2));
+      }
+    }
+  }
+
+  GIVEN("a .SLOW statement") {
+
+    component::ptr component_;
+
+    const string statement = ".SLOW 32 HOLD";
+    auto begin = statement.cbegin();
+    const auto ok = qi::phrase_parse(begin, statement.cend(), grammar, qi::space, component_);
+
+    THEN("it marks its subcircuit") {
+      REQUIRE(ok == true);
+      REQUIRE(begin == statement.cend());
+      const auto s = dynamic_pointer_cast<partition_card>(component_);
+      REQUIRE(s != nullptr);
+      REQUIRE(s->ratio() == 32);
+      REQUIRE(s->hold());
+      REQUIRE(s->instance().empty());
+      REQUIRE(s->clone({"X1.", {}})->id() == "X1..SLOW"s);
+    }
+  }
+
+  GIVEN("a .PARTITION statement") {
+
+    component::ptr component_;
+
+    const string statement = ".PARTITION";
+    auto begin = statement.cbegin();
+    const auto ok = qi::phrase_parse(begin, statement.cend(), grammar, qi::space, component_);
+
+    THEN("it marks its subcircuit for a worker thread") {
+      REQUIRE(ok == true);
+      REQUIRE(begin == statement.cend());
+      const auto s = dynamic_pointer_cast<partition_card>(component_);
+      REQUIRE(s != nullptr);
+      REQUIRE(s->threaded());
+      REQUIRE(s->ratio() == 1);
+      const auto x = dynamic_pointer_cast<partition_card>(s->clone({"X1.", {}}));
+      REQUIRE(x->instance() == "X1."s);
+    }
+  }
+}
+
+SCENARIO("model parsing", "[netlist_builder]") {
+
+  GIVEN("devices referencing .MODEL statements") {
+
+    const vector<string> netlist {
+      ".MODEL D1N4148 D (IS=2.52n N=1.752)",
+      ".MODEL BC549 NPN IS=7.05f BF=378 BR=3.3",
+      "DA a 0 D1N4148",
+      "DB b 0 D1N4148",
+      "DC c 0 IS=2.52n N=1.752",
+      "Q1 c b e BC549",
+      "Q2 e b 0 BC549",
+    };
+
+    netlist_builder builder;
+    const auto ok = all_of(netlist.begin(), netlist.end(),
+                           [&](auto&& s) { return builder.add(s); });
+
+    THEN("the netlist is accepted") {
+      REQUIRE(ok);
+      REQUIRE(builder.components().size() == netlist.size());
+    }
+
+    THEN("devices of the same model share it") {
+      const auto& cs = builder.components();
+      const auto da = dynamic_pointer_cast<basic_diode>(cs[2]);
+      const auto db = dynamic_pointer_cast<basic_diode>(cs[3]);
+      const auto dc = dynamic_pointer_cast<basic_diode>(cs[4]);
+      REQUIRE(da != nullptr);
+      REQUIRE(da->function().model() == db->function().model());
+      REQUIRE(da->function().model() != dc->function().model());
+      REQUIRE(da->function().model()->IS == Approx(2.52e-9f));
+
+      const auto q1 = dynamic_pointer_cast<bipolar_npn>(cs[5]);
+      const auto q2 = dynamic_pointer_cast<bipolar_npn>(cs[6]);
+      REQUIRE(q1 != nullptr);
+      REQUIRE(q1->model() == q2->model());
+      REQUIRE(q1->model()->BF == Approx(378.0f));
+    }
+
+    THEN("unknown models and wrong types are rejected") {
+      REQUIRE(!builder.add("DD a 0 BC550"));
+      REQUIRE(!builder.add("Q3 a b c D1N4148"));
+    }
+
+    THEN("piecewise linear junctions are asked for per model") {
+      REQUIRE(builder.add(".MODEL D1N914 D (IS=2.52n N=1.752 PWL=6)"));
+      REQUIRE(builder.add(".MODEL BC550 PNP (IS=7.05f BF=378 BR=3.3 PWL=4)"));
+      REQUIRE(builder.add("DD d 0 D1N914"));
+      REQUIRE(builder.add("Q3 a b c BC550"));
+
+      const auto& cs = builder.components();
+      REQUIRE(!cs[2]->is_piecewise());
+      REQUIRE(cs[cs.size() - 2]->is_piecewise());
+      REQUIRE(dynamic_pointer_cast<basic_diode>(cs[cs.size() - 2])->function().model()->PWL == 6);
+      REQUIRE(dynamic_pointer_cast<bipolar_pnp>(cs.back())->model()->junction->PWL == 4);
+    }
+
+    THEN("antialiased junctions are asked for per model") {
+      REQUIRE(builder.add(".MODEL D1N914 D (IS=2.52n N=1.752 ADAA=2)"));
+      REQUIRE(builder.add("DD d 0 D1N914"));
+
+      const auto d = dynamic_pointer_cast<basic_diode>(builder.components().back());
+      REQUIRE(d->function().model()->ADAA == 2);
+      REQUIRE(!d->is_piecewise());
+    }
+  }
+
+  GIVEN("tubes, from the built in and from .MODEL statements") {
+
+    netlist_builder builder;
+
+    THEN("both are accepted and shared") {
+      REQUIRE(builder.add("U1 p1 g1 k1 12AX7"));
+      REQUIRE(builder.add("U2 p2 g2 k2 12AX7"));
+      REQUIRE(builder.add("U3 p s g 0 EL34"));
+      REQUIRE(builder.add(".MODEL MY12AX7 TRIODE (MU=100 EX=1.4 KG1=1060 KP=600 KVB=300)"));
+      REQUIRE(builder.add("U4 p g k MY12AX7"));
+
+      const auto& cs = builder.components();
+      const auto v1 = dynamic_pointer_cast<triode>(cs[0]);
+      const auto v2 = dynamic_pointer_cast<triode>(cs[1]);
+      REQUIRE(v1 != nullptr);
+      REQUIRE(v1->model() == v2->model());
+      REQUIRE(dynamic_pointer_cast<pentode>(cs[2]) != nullptr);
+      REQUIRE(dynamic_pointer_cast<triode>(cs[4])->model()->RGI == Approx(2000.0f));
+    }
+  }
+}
+
+SCENARIO("subcircuit expansion", "[netlist_builder]") {
+
+  GIVEN("a subcircuit definition and its instances") {
+
+    const vector<string> netlist {
+      ".SUBCKT STAGE in out",
+      "R1 in mid 1k",
+      "R2 mid out 1k",
+      "C1 out 0 10n",
+      ".ENDS STAGE",
+      "V1 a 0 SINE 1 1k 0",
+      "X1 a b STAGE",
+      "X2 b c STAGE",
+      "X3 c d STAGE",
+      "PROBE d",
+    };
+
+    const vector<string> flat {
+      "V1 a 0 SINE 1 1k 0",
+      "R1 a b 2k", "C1 b 0 10n",
+      "R2 b c 2k", "C2 c 0 10n",
+      "R3 c d 2k", "C3 d 0 10n",
+      "PROBE d",
+    };
+
+    netlist_builder builder, reference;
+    const auto ok = all_of(netlist.begin(), netlist.end(),
+                           [&](auto&& s) { return builder.add(s); });
+    for(auto&& s: flat) reference.add(s);
+
+    THEN("the netlist is accepted") {
+      REQUIRE(ok);
+      REQUIRE(builder.complete());
+    }
+
+    THEN("templates are kept as written") {
+      REQUIRE(builder.components().size() == 3*3 + 2);
+      REQUIRE(builder.components()[1]->id() == "X1.R1"s);
+    }
+
+    THEN("instances reuse the template a precompiling builder reduced") {
+      netlist_builder precompiled{true};
+      for(auto&& s: netlist) REQUIRE(precompiled.add(s));
+
+      //the series resistors were merged once, in the definition
+      REQUIRE(precompiled.components().size() == flat.size());
+      REQUIRE(precompiled.components()[1]->id() == "X1.R1+R2"s);
+    }
+
+    THEN("the expanded circuit matches the flat one") {
+
+      //the merge is left to the circuit
+      rtspice::circuit::circuit c{builder.components(), true}, r{reference.components(), true};
+
+      REQUIRE(c.size() == r.size());
+
+      const auto v = c.get_x("d"), vr = r.get_x("d");
+      for(auto i = 0; i < 64; ++i) {
+        REQUIRE(c.advance_(1.0f / 44100.0f) > 0);
+        REQUIRE(r.advance_(1.0f / 44100.0f) > 0);
+        CHECK(*v == Approx(*vr).margin(1e-6));
+      }
+    }
+  }
+
+  GIVEN("a subcircuit with a METHOD of its own") {
+
+    netlist_builder builder;
+    for(auto&& s: {".SUBCKT RC in out", ".OPTIONS METHOD=TR", "R1 in out 1k",
+                   "C1 out 0 1u", ".ENDS", "X1 a b RC", "C2 b 0 1u",
+                   ".OPTIONS METHOD=BE"})
+      REQUIRE(builder.add(s));
+
+    auto cs = builder.components();
+    rtspice::circuit::passes::apply_method(cs, {});
+
+    const auto find = [&](const string& id) {
+      return *find_if(cs.begin(), cs.end(), [&](auto&& c) { return c->id() == id; });
+    };
+
+    THEN("the global one only reaches the lines outside it") {
+      REQUIRE(dynamic_pointer_cast<dynamic<linear_capacitor_branch, integration::trapezoidal>>(find("X1.C1")) != nullptr);
+      REQUIRE(dynamic_pointer_cast<dynamic<linear_capacitor_branch, integration::backward_euler>>(find("C2")) != nullptr);
+    }
+  }
+
+  GIVEN("a supply subcircuit marked slow") {
+
+    const auto build = [](bool slow) {
+      vector<string> netlist {
+        ".SUBCKT PSU out",
+        "V1 in 0 DC 10",
+        "R1 in mid 100",
+        "C1 mid 0 100u",
+        "R3 mid out 100",
+        "C2 out 0 100u",
+        ".ENDS",
+        "X1 b PSU",
+        "R2 b 0 1k",
+        "PROBE b",
+      };
+      if(slow) netlist.insert(netlist.begin() + 1, ".SLOW 16");
+
+      netlist_builder builder;
+      for(auto&& s: netlist) builder.add(s);
+      return builder.components();
+    };
+
+    rtspice::circuit::circuit c{build(true)}, r{build(false)};
+
+    THEN("it runs as a partition of its own") {
+      REQUIRE(c.slow_partitions() == 1);
+      REQUIRE(r.slow_partitions() == 0);
+      REQUIRE(c.size() < r.size());
+    }
+
+    THEN("the sagging rail follows the single rate one") {
+
+      constexpr float delta_t = 1.0f / 48000.0f;
+
+      //the interpolated rail lags by up to two slow steps while charging
+      const auto v = c.get_x("b"), vr = r.get_x("b");
+      for(auto i = 0; i < 4800; ++i) {
+        REQUIRE(c.advance_(delta_t) > 0);
+        REQUIRE(r.advance_(delta_t) > 0);
+        CHECK(*v == Approx(*vr).margin(0.15));
+      }
+      CHECK(*v == Approx(*vr).epsilon(1e-3));
+    }
+  }
+
+  GIVEN("buffered stages marked as partitions") {
+
+    const auto build = [](bool threaded) {
+      vector<string> netlist {
+        ".SUBCKT STAGE in out",
+        "R1 in x 10k",
+        "C1 x 0 10n",
+        "U1 out 0 x out OPAMP",
+        ".ENDS",
+        "V1 a 0 SINE 1 1000 0",
+        "X1 a b STAGE",
+        "X2 b c STAGE",
+        "PROBE c",
+      };
+      if(threaded) netlist.insert(netlist.begin() + 1, ".PARTITION");
+
+      netlist_builder builder;
+      for(auto&& s: netlist) builder.add(s);
+      return builder.components();
+    };
+
+    rtspice::circuit::circuit c{build(true)}, r{build(false)};
+
+    THEN("each stage runs on a thread of its own") {
+      REQUIRE(c.threaded_partitions() == 2);
+      REQUIRE(r.threaded_partitions() == 0);
+    }
+
+    THEN("the output is the single threaded one, a step late per handoff") {
+
+      constexpr float delta_t = 1.0f / 48000.0f;
+      constexpr int   late    = 4; //into and out of each stage
+
+      const auto v = c.get_x("c"), vr = r.get_x("c");
+      vector<float> ref;
+      for(auto i = 0; i < 480; ++i) {
+        REQUIRE(c.advance_(delta_t) > 0);
+        REQUIRE(r.advance_(delta_t) > 0);
+        ref.push_back(*vr);
+        if(i >= late) CHECK(*v == Approx(ref[i - late]).margin(1e-4));
+      }
+    }
+  }
+
+  GIVEN("bad instances") {
+
+    netlist_builder builder;
+    builder.add(".SUBCKT DIV in out");
+    builder.add("R1 in out 1k");
+
+    THEN("open definitions are reported") {
+      REQUIRE(!builder.complete());
+      REQUIRE(builder.add(".ENDS"));
+      REQUIRE(builder.complete());
+    }
+
+    THEN("unknown subcircuits and wrong port counts are rejected") {
+      builder.add(".ENDS");
+      REQUIRE(!builder.add("X1 a b OTHER"));
+      REQUIRE(!builder.add("X1 a b c DIV"));
+      REQUIRE(builder.add("X1 a b DIV"));
+    }
+  }
+}